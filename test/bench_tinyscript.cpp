@@ -0,0 +1,1373 @@
+// SPDX-License-Identifier: Zlib
+/*
+ * TINYEXPR - Tiny recursive descent parser and evaluation engine in C
+ *
+ * Copyright (c) 2015-2020 Lewis Van Winkle
+ *
+ * http://CodePlea.com
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgement in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+ /*
+  * TINYEXPR++ - Tiny recursive descent parser and evaluation engine in C++
+  *
+  * Copyright (c) 2020-2024 Blake Madden
+  *
+  * C++ version of the TinyExpr library.
+  *
+  * This software is provided 'as-is', without any express or implied
+  * warranty. In no event will the authors be held liable for any damages
+  * arising from the use of this software.
+  *
+  * Permission is granted to anyone to use this software for any purpose,
+  * including commercial applications, and to alter it and redistribute it
+  * freely, subject to the following restrictions:
+  *
+  * 1. The origin of this software must not be misrepresented; you must not
+  * claim that you wrote the original software. If you use this software
+  * in a product, an acknowledgement in the product documentation would be
+  * appreciated but is not required.
+  * 2. Altered source versions must be plainly marked as such, and must not be
+  * misrepresented as being the original software.
+  * 3. This notice may not be removed or altered from any source distribution.
+  */
+
+  /*
+   * TINYSCRIPT++ - Tiny script parser based on TinyExpr in C++
+   *
+   * Copyright (c) 2024 Denis Reischl
+   *
+   * This software is provided 'as-is', without any express or implied
+   * warranty. In no event will the authors be held liable for any damages
+   * arising from the use of this software.
+   *
+   * Permission is granted to anyone to use this software for any purpose,
+   * including commercial applications, and to alter it and redistribute it
+   * freely, subject to the following restrictions:
+   *
+   * 1. The origin of this software must not be misrepresented; you must not
+   * claim that you wrote the original software. If you use this software
+   * in a product, an acknowledgement in the product documentation would be
+   * appreciated but is not required.
+   * 2. Altered source versions must be plainly marked as such, and must not be
+   * misrepresented as being the original software.
+   * 3. This notice may not be removed or altered from any source distribution.
+   */
+
+
+// dont forget to define that in "tinyexpr.cpp" as well if using float
+#define TE_FLOAT
+
+#include "../tinyscript.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#if defined(__GLIBC__) || defined(__linux__)
+#include <malloc.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/// <summary>
+/// simple stop watch returning nanoseconds
+/// </summary>
+struct bench_timer
+{
+	std::chrono::high_resolution_clock::time_point sStart = std::chrono::high_resolution_clock::now();
+	double elapsed_ns() const
+	{
+		return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - sStart).count();
+	}
+};
+
+/// <summary>keeps the optimizer from removing benchmark results</summary>
+volatile size_t uBenchSink = 0;
+
+/// <summary>
+/// Per evaluate cost against the variable count.
+/// The legacy path resolved every slot by "std::next(std::set::begin(), uIx)",
+/// here the same slot accesses are replayed on the std::set to show that cost.
+/// </summary>
+void bench_variable_table()
+{
+	std::cout << "== flat variable table vs std::set slot walk ==\n";
+	std::cout << "vars    evaluate (ns)    std::set walk (ns)\n";
+
+	for (unsigned uN : { 10u, 50u, 100u, 200u, 400u, 800u })
+	{
+		// create variables and booleans
+		std::vector<float> afValues(uN, 1.f);
+		bool abValues[4] = {};
+		std::set<ts_variable> asVars;
+		std::set<ts_boolean> asBools;
+		for (unsigned u = 0; u < uN; u++)
+			asVars.insert({ "v" + std::to_string(u), &afValues[u] });
+		for (unsigned u = 0; u < 4; u++)
+			asBools.insert({ "b" + std::to_string(u), &abValues[u] });
+
+		// one float statement per variable, one boolean statement per four variables
+		std::string atCode;
+		for (unsigned u = 0; u < uN; u++)
+			atCode += "v" + std::to_string(u) + " = v" + std::to_string(u) + " * 0.5 + 1.;\n";
+		for (unsigned u = 0; u < uN; u += 4)
+			atCode += "b" + std::to_string(u & 3) + " = v" + std::to_string(u) + " < v" + std::to_string(uN - 1 - u) + ";\n";
+
+		ts_parser cTSP = ts_parser(atCode, asVars, asBools);
+		if (cTSP.error().first)
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+
+		// slot indices the legacy path walked per evaluate
+		std::vector<unsigned> auSlots;
+		for (unsigned u = 0; u < uN; u++)
+		{
+			auto ps = std::find_if(asVars.begin(), asVars.end(), [&](const ts_variable& s) { return s.m_name == "v" + std::to_string(u); });
+			auSlots.push_back((unsigned)std::distance(asVars.begin(), ps));
+		}
+		for (unsigned u = 0; u < uN; u += 4)
+		{
+			auSlots.push_back(auSlots[u]);
+			auSlots.push_back(auSlots[uN - 1 - u]);
+		}
+
+		const unsigned uLoops = 2000;
+		bench_timer cT;
+		for (unsigned u = 0; u < uLoops; u++)
+			cTSP.evaluate();
+		double fEval = cT.elapsed_ns() / uLoops;
+
+		cT = bench_timer();
+		for (unsigned u = 0; u < uLoops; u++)
+			for (unsigned uIx : auSlots)
+				uBenchSink = uBenchSink + (size_t)std::next(asVars.begin(), uIx)->m_value;
+		double fWalk = cT.elapsed_ns() / uLoops;
+
+		std::cout << std::setw(4) << uN << std::setw(17) << (unsigned)fEval << std::setw(22) << (unsigned)fWalk << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>heap memory currently in use in KiB (0 if unknown on this platform)</summary>
+size_t heap_kib()
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+	return mallinfo2().uordblks / 1024;
+#else
+	return 0;
+#endif
+}
+
+/// <summary>peak resident memory of the process in KiB (0 if unknown on this platform)</summary>
+size_t peak_rss_kib()
+{
+#if defined(__unix__) || defined(__APPLE__)
+	struct rusage sUsage = {};
+	if (getrusage(RUSAGE_SELF, &sUsage) != 0) return 0;
+#if defined(__APPLE__)
+	return (size_t)sUsage.ru_maxrss / 1024;
+#else
+	return (size_t)sUsage.ru_maxrss;
+#endif
+#else
+	return 0;
+#endif
+}
+
+/// <summary>
+/// Compile time, heap memory and peak resident memory of a generated script
+/// with 1k statements against the variable count.
+/// </summary>
+void bench_compile_statements()
+{
+	std::cout << "== compile 1k statements ==\n";
+	std::cout << "vars    compile (ms)    heap (KiB)    peak RSS (KiB)\n";
+
+	for (unsigned uN : { 10u, 100u, 200u, 500u })
+	{
+		std::vector<float> afValues(uN, 1.f);
+		std::set<ts_variable> asVars;
+		std::set<ts_boolean> asBools;
+		for (unsigned u = 0; u < uN; u++)
+			asVars.insert({ "v" + std::to_string(u), &afValues[u] });
+
+		std::string atCode;
+		for (unsigned u = 0; u < 1000; u++)
+			atCode += "v" + std::to_string(u % uN) + " = sqrt(v" + std::to_string((u * 7) % uN) + " * v" + std::to_string((u * 13) % uN) + ") + 1.;\n";
+
+		size_t uHeap = heap_kib();
+		bench_timer cT;
+		{
+			ts_parser cTSP = ts_parser(atCode, asVars, asBools);
+			double fCompile = cT.elapsed_ns() / 1000000.;
+			size_t uGrowth = heap_kib() - uHeap;
+			std::cout << std::setw(4) << uN << std::setw(16) << std::fixed << std::setprecision(2) << fCompile << std::setw(14) << uGrowth << std::setw(18) << peak_rss_kib() << "\n";
+			if (cTSP.error().first) std::cout << "compile error !\n";
+		}
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Compile time of a generated script with 10k statements
+/// against the number of variables and booleans (identifier resolution).
+/// </summary>
+void bench_compile_symbols()
+{
+	std::cout << "== compile 10k statements, symbol count ==\n";
+	std::cout << "symbols    compile (ms)    per statement (us)\n";
+
+	for (unsigned uN : { 100u, 500u, 2000u, 8000u })
+	{
+		std::vector<float> afValues(uN, 1.f);
+		std::unique_ptr<bool[]> abValues = std::make_unique<bool[]>(uN);
+		std::set<ts_variable> asVars;
+		std::set<ts_boolean> asBools;
+		for (unsigned u = 0; u < uN; u++)
+		{
+			asVars.insert({ "value_" + std::to_string(u), &afValues[u] });
+			asBools.insert({ "flag_" + std::to_string(u), &abValues[u] });
+		}
+
+		std::string atCode;
+		for (unsigned u = 0; u < 10000; u++)
+		{
+			std::string atA = std::to_string((u * 7) % uN), atB = std::to_string((u * 13) % uN);
+			if (u & 1)
+				atCode += "flag_" + std::to_string(u % uN) + " = flag_" + atA + " || value_" + atB + " > value_" + atA + ";\n";
+			else
+				atCode += "value_" + std::to_string(u % uN) + " = value_" + atA + " * value_" + atB + " + sqrt(value_" + atA + ");\n";
+		}
+
+		bench_timer cT;
+		ts_program cProgram(atCode, asVars, asBools, ts_optimize::none);
+		double fCompile = cT.elapsed_ns() / 1000000.;
+		if (cProgram.error().first) std::cout << "compile error !\n";
+		std::cout << std::setw(7) << uN << std::setw(16) << std::fixed << std::setprecision(2) << fCompile << std::setw(22) << (fCompile * 1000. / 10000.) << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Cold start of 200 scripts of 200 statements each,
+/// compiled from source against loaded from mapped program images.
+/// </summary>
+void bench_load_images()
+{
+	std::cout << "== cold start, 200 scripts ==\n";
+	std::cout << "mode                  total (ms)    per script (us)\n";
+
+	const unsigned uScripts = 200, uN = 50;
+	std::vector<float> afValues(uN, 1.f);
+	std::unique_ptr<bool[]> abValues = std::make_unique<bool[]>(uN);
+	std::set<ts_variable> asVars;
+	std::set<ts_boolean> asBools;
+	for (unsigned u = 0; u < uN; u++)
+	{
+		asVars.insert({ "v" + std::to_string(u), &afValues[u] });
+		asBools.insert({ "b" + std::to_string(u), &abValues[u] });
+	}
+	std::vector<std::string> aatCode(uScripts);
+	for (unsigned uS = 0; uS < uScripts; uS++)
+		for (unsigned u = 0; u < 200; u++)
+		{
+			std::string atA = std::to_string((uS + u * 7) % uN), atB = std::to_string((uS + u * 13) % uN);
+			if (u % 4 == 3)
+				aatCode[uS] += "if (v" + atA + " > v" + atB + " || b" + atB + ") { b" + atA + " = v" + atB + " < 1; }\n";
+			else
+				aatCode[uS] += "v" + std::to_string(u % uN) + " = sqrt(v" + atA + " * v" + atB + ") + sin(v" + atB + ") * 0.5;\n";
+		}
+
+	// compile from source, write the images
+	bench_timer cT;
+	std::vector<std::shared_ptr<const ts_program>> apsPrograms;
+	for (const std::string& atCode : aatCode) apsPrograms.push_back(std::make_shared<const ts_program>(atCode, asVars, asBools));
+	double fCompile = cT.elapsed_ns() / 1000000.;
+	for (unsigned uS = 0; uS < uScripts; uS++)
+	{
+		std::ofstream cFile("bench_" + std::to_string(uS) + ".tspi", std::ios::binary);
+		if (apsPrograms[uS]->write(cFile) != TS_OK) std::cout << "write error !\n";
+	}
+	apsPrograms.clear();
+
+	// map and load the images
+	cT = bench_timer();
+	for (unsigned uS = 0; uS < uScripts; uS++)
+	{
+		ts_mapped_file cFile("bench_" + std::to_string(uS) + ".tspi");
+		apsPrograms.push_back(std::make_shared<const ts_program>(cFile.image(), asVars, asBools));
+	}
+	double fLoad = cT.elapsed_ns() / 1000000.;
+	for (unsigned uS = 0; uS < uScripts; uS++)
+	{
+		if (apsPrograms[uS]->error().first) std::cout << "load error !\n";
+		std::remove(("bench_" + std::to_string(uS) + ".tspi").c_str());
+	}
+
+	std::cout << "compile source" << std::setw(18) << std::fixed << std::setprecision(2) << fCompile << std::setw(19) << (fCompile * 1000. / uScripts) << "\n";
+	std::cout << "load mapped image" << std::setw(15) << fLoad << std::setw(19) << (fLoad * 1000. / uScripts) << "\n";
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Generated scripts of some MB, compiled from one string against
+/// compiled from a reader producing the chunks on the fly (script never held),
+/// compile throughput in MB/s.
+/// </summary>
+void bench_compile_source()
+{
+	std::cout << "== compile generated scripts ==\n";
+	std::cout << "size (MB)   string (ms)   string (MB/s)   chunks (ms)   chunks (MB/s)   program heap (KiB)\n";
+
+	float fX = 1.f, fY = 2.f, fZ = 0.f;
+	std::set<ts_variable> asVars = { { "fX", &fX }, { "fY", &fY }, { "fZ", &fZ } };
+	std::set<ts_boolean> asBools;
+	auto line = [](size_t uLine)
+		{
+			return "if (fX > " + std::to_string(uLine % 97) + ") fZ = fZ + sqrt(fY * " + std::to_string(uLine % 13) + "); // generated\n";
+		};
+
+	for (size_t uMB : { 1u, 4u, 16u })
+	{
+		std::string atCode;
+		size_t uLines = 0;
+		while (atCode.size() < (uMB << 20)) atCode += line(uLines++);
+
+		bench_timer cT;
+		{
+			ts_program cProgram(atCode, asVars, asBools, ts_optimize::none);
+			if (cProgram.error().first) std::cout << "compile error !\n";
+		}
+		double fString = cT.elapsed_ns() / 1000000.;
+		atCode = std::string();
+
+		// the reader generates the lines while compiling
+		size_t uLine = 0, uPos = 0;
+		std::string atLine;
+		size_t uHeap = heap_kib();
+		cT = bench_timer();
+		{
+			ts_program cProgram(ts_source([&](char* pc, size_t uSize)
+				{
+					size_t uRead = 0;
+					while (uRead < uSize)
+					{
+						if (uPos == atLine.size())
+						{
+							if (uLine == uLines) break;
+							atLine = line(uLine++);
+							uPos = 0;
+						}
+						size_t uCopy = std::min(uSize - uRead, atLine.size() - uPos);
+						std::memcpy(pc + uRead, atLine.data() + uPos, uCopy);
+						uRead += uCopy, uPos += uCopy;
+					}
+					return uRead;
+				}), asVars, asBools, ts_optimize::none);
+			double fChunks = cT.elapsed_ns() / 1000000.;
+			size_t uGrowth = heap_kib() - uHeap;
+			if (cProgram.error().first) std::cout << "compile error !\n";
+			std::cout << std::setw(9) << uMB << std::setw(14) << std::fixed << std::setprecision(1) << fString << std::setw(16) << (uMB * 1000. / fString)
+				<< std::setw(14) << fChunks << std::setw(16) << (uMB * 1000. / fChunks) << std::setw(21) << uGrowth << "\n";
+		}
+	}
+	std::cout << "\n";
+}
+
+/// <summary>inverse kinematics script as used in the test</summary>
+constexpr const char atBenchIK[] =
+	"fB = sqrt(fTarX * fTarX + fTarY * fTarY + fTarZ * fTarZ);\n"
+	"fD = sqrt(fTarX * fTarX + fTarZ * fTarZ);\n"
+	"fAlpha = acos((fB * fB + fC * fC - fA * fA) / (2. * fB * fC));\n"
+	"fBeta = acos((fA * fA + fC * fC - fB * fB) / (2. * fA * fC));\n"
+	"fAlpha = fAlpha + atan(fTarX / fD);\n"
+	"fBeta = abs(3.141592654 - fBeta);\n"
+	"fGamma = -atan(fTarZ / fTarX);\n"
+	"if (fTarX < 0.)\n"
+	"{\n"
+	"	fGamma = 3.141592654 + fGamma;\n"
+	"}\n";
+
+/// <summary>
+/// Per evaluate cost of the inverse kinematics script
+/// and of a script skipping most of its if blocks.
+/// </summary>
+void bench_evaluate_script()
+{
+	std::cout << "== evaluate ==\n";
+	std::cout << "script                  evaluate (ns)    jit (ns)\n";
+
+	float fTarX = 1.2f, fTarY = 1.9f, fTarZ = 1.4f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_boolean> asBools;
+
+	// 64 blocks of 8 statements, only every 8th block taken
+	std::string atBlocks;
+	for (unsigned u = 0; u < 64; u++)
+	{
+		atBlocks += "if (fTarX > " + std::to_string(u % 8) + ".)\n{\n";
+		for (unsigned uS = 0; uS < 8; uS++)
+			atBlocks += "fD = fD * 0.5 + fA;\n";
+		atBlocks += "}\n";
+	}
+
+	std::pair<const char*, std::string> asScripts[] = { { "inverse kinematics", atBenchIK }, { "if blocks (1/8 taken)", atBlocks } };
+	for (auto& sScript : asScripts)
+	{
+		ts_parser cTSP = ts_parser(sScript.second, asVars, asBools);
+		if (cTSP.error().first)
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+
+		const unsigned uLoops = 100000;
+		bench_timer cT;
+		for (unsigned u = 0; u < uLoops; u++)
+			cTSP.evaluate();
+		double fEval = cT.elapsed_ns() / uLoops;
+
+		// same script as machine code
+		double fJit = 0.;
+		if (cTSP.set_backend(ts_backend::jit) == TS_OK)
+		{
+			cT = bench_timer();
+			for (unsigned u = 0; u < uLoops; u++)
+				cTSP.evaluate();
+			fJit = cT.elapsed_ns() / uLoops;
+		}
+		std::cout << std::left << std::setw(24) << sScript.first << std::right << std::setw(13) << std::fixed << std::setprecision(1) << fEval
+			<< std::setw(12) << fJit << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Inverse kinematics script compiled statement by statement
+/// against the whole script optimized (folding, shared subexpressions, dead stores).
+/// </summary>
+void bench_optimize_script()
+{
+	std::cout << "== optimizer, inverse kinematics ==\n";
+	std::cout << "program          instructions    evaluate (ns)\n";
+
+	float fTarX = 1.2f, fTarY = 1.9f, fTarZ = 1.4f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_boolean> asBools;
+
+	std::pair<const char*, ts_optimize> asModes[] = { { "as compiled", ts_optimize::none }, { "optimized", ts_optimize::full } };
+	for (auto& sMode : asModes)
+	{
+		ts_parser cTSP = ts_parser(atBenchIK, asVars, asBools, sMode.second);
+		if (cTSP.error().first)
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+		std::string atDump = cTSP.program()->dump();
+		size_t uInstructions = (size_t)std::count(atDump.begin(), atDump.end(), '\n');
+
+		const unsigned uLoops = 100000;
+		bench_timer cT;
+		for (unsigned u = 0; u < uLoops; u++)
+			cTSP.evaluate();
+		double fEval = cT.elapsed_ns() / uLoops;
+		std::cout << std::left << std::setw(17) << sMode.first << std::right << std::setw(12) << uInstructions
+			<< std::setw(17) << std::fixed << std::setprecision(1) << fEval << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Controller script of 40 inputs (20 channels, each with a limiter block),
+/// full evaluate() against evaluate_changed() as the number of changed inputs varies.
+/// </summary>
+void bench_incremental()
+{
+	std::cout << "== incremental evaluation, 40 inputs ==\n";
+	std::cout << "changed      evaluate (ns)   evaluate_changed (ns)\n";
+
+	const unsigned uChannels = 20;
+	std::vector<float> afIn(uChannels * 2), afOut(uChannels);
+	std::set<ts_variable> asVars;
+	std::set<ts_boolean> asBools;
+	std::string atScript;
+	for (unsigned uC = 0; uC < uChannels; uC++)
+	{
+		std::string atX = "fIn" + std::to_string(uC * 2), atY = "fIn" + std::to_string(uC * 2 + 1), atOut = "fOut" + std::to_string(uC);
+		afIn[uC * 2] = (float)uC * .1f;
+		afIn[uC * 2 + 1] = 1.f - (float)uC * .05f;
+		asVars.insert({ atX, &afIn[uC * 2] });
+		asVars.insert({ atY, &afIn[uC * 2 + 1] });
+		asVars.insert({ atOut, &afOut[uC] });
+		atScript += atOut + " = sqrt(" + atX + " * " + atX + " + " + atY + " * " + atY + ") * 0.5 + atan(" + atX + " / (1 + abs(" + atY + ")));\n";
+		atScript += "if (" + atOut + " > 1.5) { " + atOut + " = 1.5 + ln(" + atOut + " - 0.5); }\n";
+	}
+	ts_parser cTSP = ts_parser(atScript, asVars, asBools);
+	if (cTSP.error().first)
+	{
+		std::cout << "compile error !\n";
+		return;
+	}
+	std::vector<unsigned> auSlots;
+	for (unsigned uIn = 0; uIn < uChannels * 2; uIn++)
+		auSlots.push_back((unsigned)cTSP.program()->var_slot("fIn" + std::to_string(uIn)));
+
+	const unsigned uLoops = 50000;
+	std::cout << std::fixed << std::setprecision(1);
+	for (unsigned uChanged : { 0u, 1u, 2u, 5u, 10u, 20u, 40u })
+	{
+		// the changed inputs, spread over the channels
+		std::vector<unsigned> auChanged;
+		for (unsigned u = 0; u < uChanged; u++)
+			auChanged.push_back(auSlots[(u * 2 * uChannels / std::max(uChanged, 1u) + (u & 1)) % (uChannels * 2)]);
+		auto change = [&](unsigned uLoop)
+			{
+				for (unsigned u = 0; u < uChanged; u++)
+					afIn[auChanged[u]] = (float)((uLoop + u) & 63) * .05f;
+			};
+
+		double afNs[2] = {};
+		for (unsigned uMode = 0; uMode < 2; uMode++)
+		{
+			cTSP.evaluate();
+			float fSum = 0.f;
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				change(u);
+				if (uMode == 0) cTSP.evaluate(); else cTSP.evaluate_changed(auChanged);
+				fSum += afOut[u % uChannels];
+			}
+			afNs[uMode] = cT.elapsed_ns() / uLoops;
+			uBenchSink = uBenchSink + (size_t)fSum;
+		}
+		std::cout << std::setw(7) << uChanged << std::setw(19) << afNs[0] << std::setw(24) << afNs[1] << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Inverse kinematics script over 100k rows,
+/// evaluate() per row (copying the row in and out) against evaluate_batch().
+/// </summary>
+void bench_evaluate_batch()
+{
+	std::cout << "== inverse kinematics, 100k rows ==\n";
+	std::cout << "mode                    time (ms)    ns/row\n";
+
+	const size_t uRows = 100000;
+	std::vector<float> afX(uRows), afY(uRows), afZ(uRows), afAlpha(uRows), afBeta(uRows), afGamma(uRows), afB(uRows), afD(uRows);
+	for (size_t u = 0; u < uRows; u++)
+	{
+		afX[u] = (float)((int)(u % 200) - 100) * .02f;
+		afY[u] = (float)(u % 37) * .05f;
+		afZ[u] = (float)(u % 53) * .04f - 1.f;
+	}
+
+	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_boolean> asBools;
+	ts_parser cTSP = ts_parser(atBenchIK, asVars, asBools);
+	if (cTSP.error().first)
+	{
+		std::cout << "compile error !\n";
+		return;
+	}
+
+	bench_timer cT;
+	for (size_t u = 0; u < uRows; u++)
+	{
+		fTarX = afX[u], fTarY = afY[u], fTarZ = afZ[u];
+		cTSP.evaluate();
+		afAlpha[u] = fAlpha, afBeta[u] = fBeta, afGamma[u] = fGamma;
+	}
+	double fRow = cT.elapsed_ns();
+
+	std::set<ts_variable> asColumns =
+	{
+		{ "fTarX", afX.data() }, { "fTarY", afY.data() }, { "fTarZ", afZ.data() },
+		{ "fAlpha", afAlpha.data() }, { "fBeta", afBeta.data() }, { "fGamma", afGamma.data() },
+		{ "fB", afB.data() }, { "fD", afD.data() }
+	};
+	std::set<ts_boolean> asBoolColumns;
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "evaluate per row   " << std::setw(14) << fRow / 1000000. << std::setw(10) << fRow / uRows << "\n";
+
+	// all instruction sets supported, strict and fast math
+	std::pair<const char*, ts_simd> asSimd[] = { { "scalar", ts_simd::scalar }, { "sse", ts_simd::sse }, { "avx2", ts_simd::avx2 }, { "avx512", ts_simd::avx512 } };
+	for (auto& sSimd : asSimd)
+	{
+		if ((unsigned)sSimd.second > (unsigned)ts_simd_supported()) continue;
+		for (ts_math eMath : { ts_math::strict, ts_math::fast })
+		{
+			cTSP.evaluate_batch(asColumns, asBoolColumns, uRows, eMath, sSimd.second);
+			cT = bench_timer();
+			cTSP.evaluate_batch(asColumns, asBoolColumns, uRows, eMath, sSimd.second);
+			double fBatch = cT.elapsed_ns();
+			std::string atMode = std::string("batch ") + sSimd.first + ((eMath == ts_math::fast) ? " fast" : "");
+			std::cout << std::left << std::setw(19) << atMode << std::right << std::setw(14) << fBatch / 1000000. << std::setw(10) << fBatch / uRows << "\n";
+		}
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Inverse kinematics script over 10M rows on a thread pool,
+/// scaling from one thread to all hardware threads.
+/// </summary>
+void bench_evaluate_parallel()
+{
+	std::cout << "== inverse kinematics, 10M rows, thread pool ==\n";
+	std::cout << "threads                 time (ms)    ns/row   speedup\n";
+
+	const size_t uRows = 10000000;
+	std::vector<float> afX(uRows), afY(uRows), afZ(uRows), afAlpha(uRows), afBeta(uRows), afGamma(uRows), afB(uRows), afD(uRows);
+	for (size_t u = 0; u < uRows; u++)
+	{
+		afX[u] = (float)((int)(u % 200) - 100) * .02f;
+		afY[u] = (float)(u % 37) * .05f;
+		afZ[u] = (float)(u % 53) * .04f - 1.f;
+	}
+
+	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_boolean> asBools;
+	ts_parser cTSP = ts_parser(atBenchIK, asVars, asBools);
+	if (cTSP.error().first)
+	{
+		std::cout << "compile error !\n";
+		return;
+	}
+
+	std::set<ts_variable> asColumns =
+	{
+		{ "fTarX", afX.data() }, { "fTarY", afY.data() }, { "fTarZ", afZ.data() },
+		{ "fAlpha", afAlpha.data() }, { "fBeta", afBeta.data() }, { "fGamma", afGamma.data() },
+		{ "fB", afB.data() }, { "fD", afD.data() }
+	};
+	std::set<ts_boolean> asBoolColumns;
+	std::cout << std::fixed << std::setprecision(2);
+
+	unsigned uMax = std::max(1u, std::thread::hardware_concurrency());
+	double fSingle = 0.;
+	for (unsigned uThreads = 1; uThreads <= uMax; uThreads++)
+	{
+		ts_thread_pool cPool(uThreads);
+		cTSP.evaluate_batch(asColumns, asBoolColumns, uRows, cPool);
+		bench_timer cT;
+		cTSP.evaluate_batch(asColumns, asBoolColumns, uRows, cPool);
+		double fBatch = cT.elapsed_ns();
+		if (uThreads == 1) fSingle = fBatch;
+		std::cout << std::left << std::setw(19) << uThreads << std::right << std::setw(14) << fBatch / 1000000. << std::setw(10) << fBatch / uRows << std::setw(10) << fSingle / fBatch << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Script of 8 independent axes (80 statements each), one evaluate() on the
+/// calling thread against the axes scheduled as tasks on the thread pool.
+/// </summary>
+void bench_evaluate_statements_parallel()
+{
+	std::cout << "== independent statements, 8 axes, thread pool ==\n";
+	std::cout << "threads              evaluate (us)   speedup\n";
+
+	const unsigned uAxes = 8, uStatements = 80;
+	std::vector<float> afIn(uAxes), afOut(uAxes);
+	std::set<ts_variable> asVars;
+	std::set<ts_boolean> asBools;
+	std::string atScript;
+	for (unsigned uA = 0; uA < uAxes; uA++)
+	{
+		std::string atIn = "fIn" + std::to_string(uA), atOut = "fOut" + std::to_string(uA);
+		afIn[uA] = (float)uA * .1f + .05f;
+		asVars.insert({ atIn, &afIn[uA] });
+		asVars.insert({ atOut, &afOut[uA] });
+		atScript += atOut + " = " + atIn + ";\n";
+		for (unsigned uS = 0; uS < uStatements; uS++)
+			atScript += atOut + " = sin(" + atOut + ") * 0.9 + atan2(" + atIn + ", 1.5 + abs(" + atOut + ")) + pow(abs(" + atOut + "), 0.3);\n";
+	}
+	ts_parser cTSP = ts_parser(atScript, asVars, asBools);
+	if (cTSP.error().first)
+	{
+		std::cout << "compile error !\n";
+		return;
+	}
+	if (!cTSP.program()->parallel()) std::cout << "(estimated work below the parallel threshold)\n";
+
+	const unsigned uLoops = 2000;
+	std::cout << std::fixed << std::setprecision(2);
+	bench_timer cT;
+	for (unsigned u = 0; u < uLoops; u++)
+		cTSP.evaluate();
+	double fSingle = cT.elapsed_ns() / uLoops;
+	uBenchSink = uBenchSink + (size_t)afOut[0];
+	std::cout << std::left << std::setw(21) << "calling thread" << std::right << std::setw(14) << fSingle / 1000. << std::setw(10) << 1. << "\n";
+
+	unsigned uMax = std::max(2u, std::thread::hardware_concurrency());
+	for (unsigned uThreads = 2; uThreads <= uMax; uThreads *= 2)
+	{
+		ts_thread_pool cPool(uThreads);
+		cTSP.evaluate(cPool);
+		cT = bench_timer();
+		for (unsigned u = 0; u < uLoops; u++)
+			cTSP.evaluate(cPool);
+		double fPool = cT.elapsed_ns() / uLoops;
+		uBenchSink = uBenchSink + (size_t)afOut[0];
+		std::cout << std::left << std::setw(21) << uThreads << std::right << std::setw(14) << fPool / 1000. << std::setw(10) << fSingle / fPool << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Guard condition with a cheap first test, short-circuit "&&" against the same
+/// test placed last (all operands evaluated) as the share of rejected entities varies.
+/// </summary>
+void bench_short_circuit()
+{
+	std::cout << "== guard condition, short-circuit ==\n";
+	std::cout << "rejected    guard first (ns)   guard last (ns)\n";
+
+	float fDist = 3.f, fRange = 5.f, fAngle = .2f, fCone = .5f, fHealth = 40.f, fMin = 10.f;
+	float fX = 1.f, fMinX = -8.f, fMaxX = 8.f, fY = 2.f, fMinY = -8.f, fMaxY = 8.f;
+	bool bEnabled = true, bHit = false;
+	std::set<ts_variable> asVars =
+	{
+		{ "fDist", &fDist }, { "fRange", &fRange }, { "fAngle", &fAngle }, { "fCone", &fCone }, { "fHealth", &fHealth }, { "fMin", &fMin },
+		{ "fX", &fX }, { "fMinX", &fMinX }, { "fMaxX", &fMaxX }, { "fY", &fY }, { "fMinY", &fMinY }, { "fMaxY", &fMaxY }
+	};
+	std::set<ts_boolean> asBools = { { "bEnabled", &bEnabled }, { "bHit", &bHit } };
+
+	const std::string atTests = "fDist < fRange && fAngle < fCone && fHealth > fMin && fX > fMinX && fX < fMaxX && fY > fMinY && fY < fMaxY";
+	ts_parser cFirst = ts_parser("bHit = bEnabled && " + atTests + ";", asVars, asBools);
+	ts_parser cLast = ts_parser("bHit = " + atTests + " && bEnabled;", asVars, asBools);
+	if ((cFirst.error().first) || (cLast.error().first))
+	{
+		std::cout << "compile error !\n";
+		return;
+	}
+
+	const unsigned uLoops = 200000;
+	std::vector<bool> abEnabled(1024);
+	std::cout << std::fixed << std::setprecision(1);
+	for (unsigned uRejected = 0; uRejected <= 100; uRejected += 25)
+	{
+		for (unsigned u = 0; u < 1024; u++)
+			abEnabled[u] = ((u * 7919u) % 100u) >= uRejected;
+
+		double afNs[2] = {};
+		ts_parser* apsTSP[2] = { &cFirst, &cLast };
+		for (unsigned uS = 0; uS < 2; uS++)
+		{
+			size_t uHits = 0;
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				bEnabled = abEnabled[u & 1023];
+				apsTSP[uS]->evaluate();
+				uHits += bHit ? 1 : 0;
+			}
+			afNs[uS] = cT.elapsed_ns() / uLoops;
+			uBenchSink = uBenchSink + uHits;
+		}
+		std::cout << std::setw(7) << uRejected << " %" << std::setw(19) << afNs[0] << std::setw(18) << afNs[1] << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Decision tree of 8 ranges : an "else if" chain against if statements of the negated preceding conditions.
+/// </summary>
+void bench_decision_tree()
+{
+	std::cout << "== decision tree, else if chain ==\n";
+	std::cout << "ranges    else if (ns)    negated ifs (ns)\n";
+
+	float fValue = 0.f, fClass = 0.f;
+	std::set<ts_variable> asVars = { { "fValue", &fValue }, { "fClass", &fClass } };
+	std::set<ts_boolean> asBools;
+
+	const unsigned uLoops = 200000;
+	std::cout << std::fixed << std::setprecision(1);
+	for (unsigned uRanges : { 2u, 4u, 8u })
+	{
+		std::string atChain, atNegated;
+		for (unsigned u = 0; u < uRanges; u++)
+		{
+			std::string atLimit = std::to_string(u + 1) + ". / " + std::to_string(uRanges), atClass = "fClass = " + std::to_string(u) + ";\n";
+			atChain += ((u) ? "else if (fValue < " : "if (fValue < ") + atLimit + ") " + atClass;
+			atNegated += "if (fValue < " + atLimit;
+			for (unsigned uP = 0; uP < u; uP++) atNegated += " && fValue >= " + std::to_string(uP + 1) + ". / " + std::to_string(uRanges);
+			atNegated += ") " + atClass;
+		}
+		ts_parser cChain = ts_parser(atChain, asVars, asBools);
+		ts_parser cNegated = ts_parser(atNegated, asVars, asBools);
+		if ((cChain.error().first) || (cNegated.error().first))
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+
+		double afNs[2] = {};
+		ts_parser* apsTSP[2] = { &cChain, &cNegated };
+		for (unsigned uS = 0; uS < 2; uS++)
+		{
+			double fSum = 0.;
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				fValue = (float)(u & 1023) / 1024.f;
+				apsTSP[uS]->evaluate();
+				fSum += fClass;
+			}
+			afNs[uS] = cT.elapsed_ns() / uLoops;
+			uBenchSink = uBenchSink + (size_t)fSum;
+		}
+		std::cout << std::setw(6) << uRanges << std::setw(16) << afNs[0] << std::setw(20) << afNs[1] << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Newton iteration of a square root until converged or capped : a "while" loop within one evaluation
+/// against the host calling a script of one step per iteration.
+/// </summary>
+void bench_solver_loop()
+{
+	std::cout << "== newton solver, loop in script ==\n";
+	std::cout << "cap       script loop (ns)    host loop (ns)\n";
+
+	float fValue = 0.f, fRoot = 0.f;
+	bool bDone = false;
+	std::set<ts_variable> asVars = { { "fValue", &fValue }, { "fRoot", &fRoot } };
+	std::set<ts_boolean> asBools = { { "bDone", &bDone } };
+
+	const unsigned uLoops = 100000;
+	std::cout << std::fixed << std::setprecision(1);
+	for (unsigned uCap : { 4u, 8u, 16u })
+	{
+		std::string atLoop = "fRoot = fValue * 0.5 + 0.5;\n"
+			"while (abs(fRoot * fRoot - fValue) > fValue * 0.000001; " + std::to_string(uCap) + ")\n"
+			"	fRoot = fRoot - (fRoot * fRoot - fValue) / (2 * fRoot);\n";
+		ts_parser cLoop = ts_parser(atLoop, asVars, asBools);
+		ts_parser cStart = ts_parser("fRoot = fValue * 0.5 + 0.5; bDone = abs(fRoot * fRoot - fValue) <= fValue * 0.000001;", asVars, asBools);
+		ts_parser cStep = ts_parser("fRoot = fRoot - (fRoot * fRoot - fValue) / (2 * fRoot); bDone = abs(fRoot * fRoot - fValue) <= fValue * 0.000001;", asVars, asBools);
+		if ((cLoop.error().first) || (cStart.error().first) || (cStep.error().first))
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+
+		double afNs[2] = {}, afSum[2] = {};
+		for (unsigned uS = 0; uS < 2; uS++)
+		{
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				fValue = 1.f + (float)(u & 1023) / 16.f;
+				if (uS == 0)
+					cLoop.evaluate();
+				else
+				{
+					cStart.evaluate();
+					for (unsigned uI = 0; (uI < uCap) && (!bDone); uI++) cStep.evaluate();
+				}
+				afSum[uS] += fRoot;
+			}
+			afNs[uS] = cT.elapsed_ns() / uLoops;
+			uBenchSink = uBenchSink + (size_t)afSum[uS];
+		}
+		std::cout << std::setw(6) << uCap << std::setw(20) << afNs[0] << std::setw(18) << afNs[1] << "\n";
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Inverse kinematics over 100k targets, the temporaries fB and fD as host variables
+/// against script locals (no host stores, two bindings less), interpreted and JIT compiled.
+/// </summary>
+void bench_script_locals()
+{
+	std::cout << "== inverse kinematics, host temporaries vs script locals ==\n";
+	std::cout << "temporaries       backend     ns/evaluate    instructions\n";
+
+	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asHosted =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_variable> asLocal =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fC", &fC }
+	};
+	std::set<ts_boolean> asBools;
+	std::string atLocal = std::string("float ") + atBenchIK;
+	atLocal.insert(atLocal.find("fD = "), "float ");
+
+	const unsigned uLoops = 100000;
+	std::cout << std::fixed << std::setprecision(1);
+	std::pair<const char*, ts_parser> asScripts[] = { { "host variables", ts_parser(atBenchIK, asHosted, asBools) }, { "script locals", ts_parser(atLocal, asLocal, asBools) } };
+	for (auto& sScript : asScripts)
+	{
+		ts_parser& cTSP = sScript.second;
+		if (cTSP.error().first)
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+		std::string atDump = cTSP.program()->dump();
+		size_t uInstructions = (size_t)std::count(atDump.begin(), atDump.end(), '\n');
+		for (ts_backend eBackend : { ts_backend::interpreter, ts_backend::jit })
+		{
+			if (cTSP.set_backend(eBackend) != TS_OK) continue;
+			float fSum = 0.f;
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				fTarX = (float)((int)(u % 200) - 100) * .02f;
+				fTarY = (float)(u % 37) * .05f;
+				fTarZ = (float)(u % 53) * .04f - 1.f;
+				cTSP.evaluate();
+				fSum += fAlpha + fBeta + fGamma;
+			}
+			std::cout << std::left << std::setw(18) << sScript.first << std::setw(12) << ((eBackend == ts_backend::jit) ? "jit" : "interpreter")
+				<< std::right << std::setw(11) << cT.elapsed_ns() / uLoops << std::setw(16) << uInstructions << "\n";
+			uBenchSink = uBenchSink + (size_t)fSum;
+		}
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Script functions against their bodies copied to each use, interpreted and JIT compiled :
+/// the law of cosines angle of the IK script (inlined at each call) and
+/// a cube root by 12 Newton steps for three values (a body large enough to be invoked).
+/// </summary>
+void bench_script_functions()
+{
+	std::cout << "== script functions, copied bodies vs inlined and invoked functions ==\n";
+	std::cout << "script            backend     ns/evaluate    instructions\n";
+
+	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	float fU = 0.f, fV = 0.f, fW = 0.f, fX = 0.f, fY = 0.f, fZ = 0.f, fR = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD },
+		{ "fU", &fU }, { "fV", &fV }, { "fW", &fW }, { "fX", &fX }, { "fY", &fY }, { "fZ", &fZ }, { "fR", &fR }
+	};
+	std::set<ts_boolean> asBools;
+
+	// the angle as function
+	std::string atAngle = std::string("func angle(a, b, c) { return acos((a * a + b * b - c * c) / (2. * a * b)); }\n") + atBenchIK;
+	atAngle.replace(atAngle.find("acos((fB * fB"), atAngle.find(";\nfBeta") - atAngle.find("acos((fB * fB"), "angle(fB, fC, fA)");
+	atAngle.replace(atAngle.find("acos((fA * fA"), atAngle.find(";\nfAlpha = fAlpha") - atAngle.find("acos((fA * fA"), "angle(fA, fC, fB)");
+
+	// the cube root copied by a host temporary and as function
+	auto step = [](const std::string& atR, const std::string& atV)
+		{
+			return atR + " = " + atR + " - (" + atR + " * " + atR + " * " + atR + " - " + atV + ") / (3. * " + atR + " * " + atR + ");\n";
+		};
+	std::string atCopies, atRoot = "func root3(v)\n{\nfloat r = v;\n";
+	for (unsigned u = 0; u < 12; u++) atRoot += step("r", "v");
+	atRoot += "return r;\n}\n";
+	for (const std::pair<const char*, const char*>& sUse : { std::make_pair("fU", "fX"), std::make_pair("fV", "fY"), std::make_pair("fW", "fZ") })
+	{
+		atCopies += std::string("fR = ") + sUse.first + ";\n";
+		for (unsigned u = 0; u < 12; u++) atCopies += step("fR", sUse.first);
+		atCopies += std::string(sUse.second) + " = fR;\n";
+		atRoot += std::string(sUse.second) + " = root3(" + sUse.first + ");\n";
+	}
+
+	const unsigned uLoops = 100000;
+	std::cout << std::fixed << std::setprecision(1);
+	std::pair<const char*, ts_parser> asScripts[] =
+	{
+		{ "angle copied", ts_parser(atBenchIK, asVars, asBools) }, { "angle inlined", ts_parser(atAngle, asVars, asBools) },
+		{ "root copied", ts_parser(atCopies, asVars, asBools) }, { "root invoked", ts_parser(atRoot, asVars, asBools) }
+	};
+	for (auto& sScript : asScripts)
+	{
+		ts_parser& cTSP = sScript.second;
+		if (cTSP.error().first)
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+		std::string atDump = cTSP.program()->dump();
+		size_t uInstructions = (size_t)std::count(atDump.begin(), atDump.end(), '\n');
+		for (ts_backend eBackend : { ts_backend::interpreter, ts_backend::jit })
+		{
+			if (cTSP.set_backend(eBackend) != TS_OK) continue;
+			float fSum = 0.f;
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				fTarX = (float)((int)(u % 200) - 100) * .02f;
+				fTarY = (float)(u % 37) * .05f;
+				fTarZ = (float)(u % 53) * .04f - 1.f;
+				fU = 1.f + (float)(u % 97);
+				fV = 2.f + (float)(u % 31);
+				fW = 3.f + (float)(u % 17);
+				cTSP.evaluate();
+				fSum += fAlpha + fBeta + fGamma + fX + fY + fZ;
+			}
+			std::cout << std::left << std::setw(18) << sScript.first << std::setw(12) << ((eBackend == ts_backend::jit) ? "jit" : "interpreter")
+				<< std::right << std::setw(11) << cT.elapsed_ns() / uLoops << std::setw(16) << uInstructions << "\n";
+			uBenchSink = uBenchSink + (size_t)fSum;
+		}
+	}
+	std::cout << "\n";
+}
+
+/// <summary>law of cosines angle as host function, scalar and batch variant</summary>
+te_type bench_angle(const te_type* afArgs, void*)
+{
+	return std::acos((afArgs[0] * afArgs[0] + afArgs[1] * afArgs[1] - afArgs[2] * afArgs[2]) / (te_type(2) * afArgs[0] * afArgs[1]));
+}
+void bench_angle_batch(const te_type* const* apfArgs, te_type* afResult, size_t uRows, void*)
+{
+	for (size_t u = 0; u < uRows; u++)
+		afResult[u] = std::acos((apfArgs[0][u] * apfArgs[0][u] + apfArgs[1][u] * apfArgs[1][u] - apfArgs[2][u] * apfArgs[2][u]) / (te_type(2) * apfArgs[0][u] * apfArgs[1][u]));
+}
+
+/// <summary>
+/// Host functions against script functions : the law of cosines angle of the IK script
+/// inlined and called on the host, per evaluate (interpreted and JIT compiled) and over 100k rows
+/// (a call per row against the batch variant).
+/// </summary>
+void bench_host_functions()
+{
+	std::cout << "== host functions, inlined script function vs host function ==\n";
+	std::cout << "script            backend     ns/evaluate    ns/row\n";
+
+	const size_t uRows = 100000;
+	std::vector<float> afX(uRows), afY(uRows), afZ(uRows), afAlpha(uRows), afBeta(uRows), afGamma(uRows), afB(uRows), afD(uRows);
+	for (size_t u = 0; u < uRows; u++)
+	{
+		afX[u] = (float)((int)(u % 200) - 100) * .02f;
+		afY[u] = (float)(u % 37) * .05f;
+		afZ[u] = (float)(u % 53) * .04f - 1.f;
+	}
+
+	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_boolean> asBools;
+	std::set<ts_variable> asColumns =
+	{
+		{ "fTarX", afX.data() }, { "fTarY", afY.data() }, { "fTarZ", afZ.data() },
+		{ "fAlpha", afAlpha.data() }, { "fBeta", afBeta.data() }, { "fGamma", afGamma.data() },
+		{ "fB", afB.data() }, { "fD", afD.data() }
+	};
+	std::set<ts_boolean> asBoolColumns;
+
+	// the angle as script function and as host function
+	std::string atScript = atBenchIK, atHost = atBenchIK;
+	for (std::string* patScript : { &atScript, &atHost })
+	{
+		patScript->replace(patScript->find("acos((fB * fB"), patScript->find(";\nfBeta") - patScript->find("acos((fB * fB"), "angle(fB, fC, fA)");
+		patScript->replace(patScript->find("acos((fA * fA"), patScript->find(";\nfAlpha = fAlpha") - patScript->find("acos((fA * fA"), "angle(fA, fC, fB)");
+	}
+	atScript = "func angle(a, b, c) { return acos((a * a + b * b - c * c) / (2. * a * b)); }\n" + atScript;
+
+	const unsigned uLoops = 100000;
+	std::cout << std::fixed << std::setprecision(1);
+	std::pair<const char*, ts_parser> asScripts[] =
+	{
+		{ "script function", ts_parser(atScript, asVars, asBools) },
+		{ "host function", ts_parser(atHost, asVars, asBools, std::set<ts_native>{ { "angle", 3, &bench_angle, nullptr, true, nullptr } }) },
+		{ "host batch", ts_parser(atHost, asVars, asBools, std::set<ts_native>{ { "angle", 3, &bench_angle, nullptr, true, &bench_angle_batch } }) }
+	};
+	for (auto& sScript : asScripts)
+	{
+		ts_parser& cTSP = sScript.second;
+		if (cTSP.error().first)
+		{
+			std::cout << "compile error !\n";
+			return;
+		}
+		for (ts_backend eBackend : { ts_backend::interpreter, ts_backend::jit })
+		{
+			if (cTSP.set_backend(eBackend) != TS_OK) continue;
+			float fSum = 0.f;
+			bench_timer cT;
+			for (unsigned u = 0; u < uLoops; u++)
+			{
+				fTarX = (float)((int)(u % 200) - 100) * .02f;
+				fTarY = (float)(u % 37) * .05f;
+				fTarZ = (float)(u % 53) * .04f - 1.f;
+				cTSP.evaluate();
+				fSum += fAlpha + fBeta + fGamma;
+			}
+			double fEvaluate = cT.elapsed_ns() / uLoops;
+			uBenchSink = uBenchSink + (size_t)fSum;
+
+			// the batch runs by the interpreter lanes, listed once
+			std::cout << std::left << std::setw(18) << sScript.first << std::setw(12) << ((eBackend == ts_backend::jit) ? "jit" : "interpreter")
+				<< std::right << std::setw(11) << fEvaluate;
+			if (eBackend == ts_backend::interpreter)
+			{
+				cTSP.evaluate_batch(asColumns, asBoolColumns, uRows);
+				cT = bench_timer();
+				cTSP.evaluate_batch(asColumns, asBoolColumns, uRows);
+				std::cout << std::setw(14) << cT.elapsed_ns() / uRows;
+			}
+			std::cout << "\n";
+		}
+	}
+	std::cout << "\n";
+}
+
+/// <summary>
+/// Inverse kinematics script for 10k entities,
+/// recompiled per entity against rebinding by name and rebinding by struct layout.
+/// </summary>
+void bench_rebind_entities()
+{
+	std::cout << "== inverse kinematics, 10k entities ==\n";
+	std::cout << "binding                 ns/entity\n";
+
+	struct entity
+	{
+		float fTarX, fTarY, fTarZ, fAlpha, fBeta, fGamma, fA, fB, fC, fD;
+	};
+	const size_t uEntities = 10000;
+	std::vector<entity> asEntities(uEntities);
+	for (size_t u = 0; u < uEntities; u++)
+		asEntities[u] = { (float)((int)(u % 200) - 100) * .02f, (float)(u % 37) * .05f, (float)(u % 53) * .04f - 1.f, 0.f, 0.f, 0.f, 2.f, 0.f, 3.f, 0.f };
+	auto entity_vars = [](entity& s) -> std::set<ts_variable>
+		{
+			return
+			{
+				{ "fTarX", &s.fTarX }, { "fTarY", &s.fTarY }, { "fTarZ", &s.fTarZ },
+				{ "fAlpha", &s.fAlpha }, { "fBeta", &s.fBeta }, { "fGamma", &s.fGamma },
+				{ "fA", &s.fA }, { "fB", &s.fB }, { "fC", &s.fC }, { "fD", &s.fD }
+			};
+		};
+	std::set<ts_boolean> asBools;
+	std::cout << std::fixed << std::setprecision(1);
+
+	// compile per entity (a subset, it is slow)
+	const size_t uCompiled = 200;
+	bench_timer cT;
+	for (size_t u = 0; u < uCompiled; u++)
+	{
+		std::set<ts_variable> asVars = entity_vars(asEntities[u]);
+		ts_parser cTSP = ts_parser(atBenchIK, asVars, asBools);
+		cTSP.evaluate();
+	}
+	std::cout << "compile per entity " << std::setw(15) << cT.elapsed_ns() / uCompiled << "\n";
+
+	// compile once, bind by name
+	std::set<ts_variable> asVars = entity_vars(asEntities[0]);
+	ts_parser cTSP = ts_parser(atBenchIK, asVars, asBools);
+	if (cTSP.error().first)
+	{
+		std::cout << "compile error !\n";
+		return;
+	}
+	cT = bench_timer();
+	for (size_t u = 0; u < uEntities; u++)
+	{
+		cTSP.context().bind(entity_vars(asEntities[u]), asBools);
+		cTSP.evaluate();
+	}
+	std::cout << "bind by name       " << std::setw(15) << cT.elapsed_ns() / uEntities << "\n";
+
+	// compile once, bind by layout
+	cTSP.context().bind(entity_vars(asEntities[0]), asBools);
+	cTSP.context().layout(asEntities[0]);
+	cT = bench_timer();
+	for (size_t u = 0; u < uEntities; u++)
+	{
+		cTSP.context().bind_instance(asEntities[u]);
+		cTSP.evaluate();
+	}
+	std::cout << "bind instance      " << std::setw(15) << cT.elapsed_ns() / uEntities << "\n\n";
+}
+
+/// <summary>inverse kinematics script, source of the compile time version</summary>
+struct bench_ik_source
+{
+	static constexpr std::string_view code() { return atBenchIK; }
+};
+
+/// <summary>
+/// C++ version of the inverse kinematics script
+/// (as in test_tinyscript.cpp)
+/// </summary>
+void IK_EndEffectorToTargetAngles(
+	float fTarX, float fTarY, float fTarZ,
+	float fA, float fC,
+	float& fAlpha, float& fBeta, float& fGamma)
+{
+	float fB = sqrt(fTarX * fTarX + fTarY * fTarY + fTarZ * fTarZ);
+	float fD = sqrt(fTarX * fTarX + fTarZ * fTarZ);
+	fAlpha = acos((fB * fB + fC * fC - fA * fA) / (2.f * fB * fC));
+	fBeta = acos((fA * fA + fC * fC - fB * fB) / (2.f * fA * fC));
+	fAlpha = fAlpha + atan(fTarX / fD);
+	fBeta = abs(3.141592654f - fBeta);
+	fGamma = -atan(fTarZ / fTarX);
+	if (fTarX < 0.f)
+	{
+		fGamma = 3.141592654f + fGamma;
+	}
+}
+
+/// <summary>
+/// Inverse kinematics over 100k targets,
+/// runtime parsed script against the compile time script and the C++ function.
+/// </summary>
+void bench_static_script()
+{
+	std::cout << "== inverse kinematics, compile time script ==\n";
+	std::cout << "version                 ns/target     checksum\n";
+
+	const size_t uTargets = 100000;
+	std::vector<float> afX(uTargets), afY(uTargets), afZ(uTargets);
+	for (size_t u = 0; u < uTargets; u++)
+	{
+		afX[u] = (float)((int)(u % 200) - 100) * .02f;
+		afY[u] = (float)(u % 37) * .05f;
+		afZ[u] = (float)(u % 53) * .04f - 1.f;
+	}
+
+	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
+	float fA = 2.f, fB = 0.f, fC = 3.f, fD = 0.f;
+	std::set<ts_variable> asVars =
+	{
+		{ "fTarX", &fTarX }, { "fTarY", &fTarY }, { "fTarZ", &fTarZ },
+		{ "fAlpha", &fAlpha }, { "fBeta", &fBeta }, { "fGamma", &fGamma },
+		{ "fA", &fA }, { "fB", &fB }, { "fC", &fC }, { "fD", &fD }
+	};
+	std::set<ts_boolean> asBools;
+	std::cout << std::fixed;
+	auto checksum = [](float f) { return (f == f) ? (double)f : 0.; };
+
+	// runtime parsed
+	bench_timer cT;
+	ts_parser cTSP = ts_parser(atBenchIK, asVars, asBools);
+	double fCompile = cT.elapsed_ns();
+	double fSum = 0.;
+	cT = bench_timer();
+	for (size_t u = 0; u < uTargets; u++)
+	{
+		fTarX = afX[u], fTarY = afY[u], fTarZ = afZ[u];
+		cTSP.evaluate();
+		fSum += checksum(fAlpha) + checksum(fBeta) + checksum(fGamma);
+	}
+	double fRuntime = cT.elapsed_ns() / uTargets;
+	std::cout << "ts_parser          " << std::setw(12) << std::setprecision(2) << fRuntime << std::setw(13) << std::setprecision(3) << fSum
+		<< "   (compile " << std::setprecision(0) << fCompile << " ns)\n";
+
+	// compile time script, variable slots in order of first appearance
+	using ik_script = ts_static_script<bench_ik_source>;
+	std::array<float*, ik_script::uVars> apfSlots = {};
+	for (const ts_variable& s : asVars)
+		if (ik_script::slot(s.m_name) >= 0) apfSlots[ik_script::slot(s.m_name)] = s.m_value;
+	fSum = 0.;
+	cT = bench_timer();
+	for (size_t u = 0; u < uTargets; u++)
+	{
+		fTarX = afX[u], fTarY = afY[u], fTarZ = afZ[u];
+		ik_script::evaluate(apfSlots.data());
+		fSum += checksum(fAlpha) + checksum(fBeta) + checksum(fGamma);
+	}
+	double fStatic = cT.elapsed_ns() / uTargets;
+	std::cout << "ts_static_script   " << std::setw(12) << std::setprecision(2) << fStatic << std::setw(13) << std::setprecision(3) << fSum << "\n";
+
+	// C++
+	fSum = 0.;
+	cT = bench_timer();
+	for (size_t u = 0; u < uTargets; u++)
+	{
+		IK_EndEffectorToTargetAngles(afX[u], afY[u], afZ[u], fA, fC, fAlpha, fBeta, fGamma);
+		fSum += checksum(fAlpha) + checksum(fBeta) + checksum(fGamma);
+	}
+	double fNative = cT.elapsed_ns() / uTargets;
+	std::cout << "C++                " << std::setw(12) << std::setprecision(2) << fNative << std::setw(13) << std::setprecision(3) << fSum << "\n\n";
+}
+
+int main()
+{
+	bench_variable_table();
+	bench_compile_statements();
+	bench_compile_source();
+	bench_compile_symbols();
+	bench_load_images();
+	bench_evaluate_script();
+	bench_optimize_script();
+	bench_incremental();
+	bench_evaluate_batch();
+	bench_evaluate_parallel();
+	bench_evaluate_statements_parallel();
+	bench_short_circuit();
+	bench_decision_tree();
+	bench_solver_loop();
+	bench_script_locals();
+	bench_script_functions();
+	bench_host_functions();
+	bench_rebind_entities();
+	bench_static_script();
+}
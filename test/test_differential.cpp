@@ -0,0 +1,1018 @@
+// SPDX-License-Identifier: Zlib
+/*
+ * TINYEXPR - Tiny recursive descent parser and evaluation engine in C
+ *
+ * Copyright (c) 2015-2020 Lewis Van Winkle
+ *
+ * http://CodePlea.com
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgement in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+ /*
+  * TINYEXPR++ - Tiny recursive descent parser and evaluation engine in C++
+  *
+  * Copyright (c) 2020-2024 Blake Madden
+  *
+  * C++ version of the TinyExpr library.
+  *
+  * This software is provided 'as-is', without any express or implied
+  * warranty. In no event will the authors be held liable for any damages
+  * arising from the use of this software.
+  *
+  * Permission is granted to anyone to use this software for any purpose,
+  * including commercial applications, and to alter it and redistribute it
+  * freely, subject to the following restrictions:
+  *
+  * 1. The origin of this software must not be misrepresented; you must not
+  * claim that you wrote the original software. If you use this software
+  * in a product, an acknowledgement in the product documentation would be
+  * appreciated but is not required.
+  * 2. Altered source versions must be plainly marked as such, and must not be
+  * misrepresented as being the original software.
+  * 3. This notice may not be removed or altered from any source distribution.
+  */
+
+  /*
+   * TINYSCRIPT++ - Tiny script parser based on TinyExpr in C++
+   *
+   * Copyright (c) 2024 Denis Reischl
+   *
+   * This software is provided 'as-is', without any express or implied
+   * warranty. In no event will the authors be held liable for any damages
+   * arising from the use of this software.
+   *
+   * Permission is granted to anyone to use this software for any purpose,
+   * including commercial applications, and to alter it and redistribute it
+   * freely, subject to the following restrictions:
+   *
+   * 1. The origin of this software must not be misrepresented; you must not
+   * claim that you wrote the original software. If you use this software
+   * in a product, an acknowledgement in the product documentation would be
+   * appreciated but is not required.
+   * 2. Altered source versions must be plainly marked as such, and must not be
+   * misrepresented as being the original software.
+   * 3. This notice may not be removed or altered from any source distribution.
+   */
+
+
+// dont forget to define that in "tinyexpr.cpp" as well if using float
+#define TE_FLOAT
+
+#include "../tinyscript.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <regex>
+#include <string>
+
+/// <summary>
+/// random script generator, floating point and boolean statements
+/// with builtins, comparisons, logic and nested if blocks, else branches, else if chains, loops, locals, functions and host functions
+/// </summary>
+struct script_generator
+{
+	std::mt19937 cRng;
+	const char* aatVars[6] = { "a", "b", "c", "d", "x", "y" };
+	const char* aatBools[3] = { "p", "q", "r" };
+	const char* aatFunctions[12] = { "sqrt", "abs", "sin", "cos", "atan", "acos", "exp", "floor", "ceil", "tanh", "ln", "log10" };
+	const char* aatNumbers[7] = { "2", "0.5", ".25", "3.", "1.5", "10", "0" };
+
+	/// <summary>single statement blocks as one line "if" statements, comments added</summary>
+	bool bOneLine = false;
+	/// <summary>else branches as a second if block, the condition kept in a guard boolean per depth (g0 .. g3)</summary>
+	bool bGuards = false;
+	/// <summary>"while" and "for" loops, capped by a constant or by the variable n</summary>
+	bool bLoops = false;
+	/// <summary>loops unrolled to if blocks, the condition kept in a guard boolean per depth (l0 .. l2)</summary>
+	bool bUnroll = false;
+	/// <summary>"float" and "bool" locals declared within the blocks (t0, t1 .. and f0, f1 ..), "for" loops declare them as well</summary>
+	bool bLocals = false;
+	/// <summary>the locals as host variables, declarations are assignments</summary>
+	bool bHosted = false;
+	/// <summary>functions h0, h1 .. defined first, called by the assignments (hosted : computed before the assignment)</summary>
+	bool bFunctions = false;
+	/// <summary>host functions mad, half and count (impure) called by the expressions and count() called as a statement</summary>
+	bool bNatives = false;
+	/// <summary>the host function calls written as the expressions they compute, count(e) is e (a statement of it dropped)</summary>
+	bool bExpanded = false;
+
+	/// <summary>locals in scope, the number of locals declared</summary>
+	std::vector<std::string> atLocals, atLocalBools;
+	unsigned uLocals = 0, uLocalBools = 0;
+
+	/// <summary>a function : the local declarations (hosted : the calls computed before each), the returned expression</summary>
+	struct function
+	{
+		unsigned uParams = 0;
+		std::string atLines, atReturn;
+	};
+	std::vector<function> asFunctions;
+	/// <summary>names of the function body generated, calls allowed, the calls computed before the current assignment (hosted)</summary>
+	std::vector<std::string> atBody;
+	bool bCalls = false;
+	std::string atHoisted;
+	/// <summary>hosted : the parameters, locals and results of the functions (host variables)</summary>
+	std::vector<std::string> atHostNames;
+	unsigned uResults = 0;
+
+	explicit script_generator(unsigned uSeed) : cRng(uSeed) {}
+
+	unsigned pick(unsigned uN) { return (unsigned)(cRng() % uN); }
+	std::string var()
+	{
+		if (atBody.size()) return atBody[pick((unsigned)atBody.size())];
+		if ((bLocals) && (atLocals.size()) && (pick(3) == 0)) return atLocals[pick((unsigned)atLocals.size())];
+		return aatVars[pick(6)];
+	}
+	std::string boolean()
+	{
+		if ((bLocals) && (atLocalBools.size()) && (pick(3) == 0)) return atLocalBools[pick((unsigned)atLocalBools.size())];
+		return aatBools[pick(3)];
+	}
+	std::string term() { return (pick(3) == 0) ? std::string(aatNumbers[pick(7)]) : var(); }
+
+	std::string expr(unsigned uDepth = 0)
+	{
+		unsigned uR = pick(100);
+		if ((uDepth > 3) || (uR < 30)) return term();
+		if (uR < 45) return std::string(aatFunctions[pick(12)]) + "(" + expr(uDepth + 1) + ")";
+		if (uR < 50) return "-" + expr(uDepth + 1);
+		if (uR < 60) return "(" + expr(uDepth + 1) + ")";
+		if (uR < 63) return "atan2(" + expr(uDepth + 1) + ", " + expr(uDepth + 1) + ")";
+		if (uR < 66) return "pow(" + expr(uDepth + 1) + ", " + expr(uDepth + 1) + ")";
+		if ((bCalls) && (asFunctions.size()) && (uR < 74)) return call(uDepth);
+		if ((bNatives) && (uR < 74)) return native(uDepth);
+		const char* aatOps[7] = { " + ", " - ", " * ", " / ", " % ", " ^ ", " + " };
+		return expr(uDepth + 1) + aatOps[pick(7)] + expr(uDepth + 1);
+	}
+
+	std::string operand() { return (pick(4) == 0) ? boolean() : (pick(3) == 0) ? expr(2) : term(); }
+
+	std::string condition()
+	{
+		const char* aatOps[7] = { " == ", " != ", " < ", " > ", " <= ", " >= ", " && " };
+		std::string at = operand();
+		for (unsigned u = pick(3); u > 0; u--)
+			at += std::string((pick(4) == 0) ? " || " : aatOps[pick(7)]) + operand();
+		return at;
+	}
+
+	std::string comment() { return (bOneLine) ? " // ; if (a) { /* } */" : ""; }
+
+	std::string statements(unsigned uN, unsigned uDepth = 0)
+	{
+		std::string at;
+		size_t uScope = atLocals.size(), uBoolScope = atLocalBools.size();
+		for (unsigned u = 0; u < uN; u++)
+		{
+			if ((bLocals) && (pick(4) == 0))
+			{
+				at += declaration() + ";" + comment() + "\n";
+				continue;
+			}
+			unsigned uR = pick(100);
+			if ((bNatives) && (uR < 5))
+			{
+				std::string atArg = expr();
+				at += (bExpanded) ? "" : "count(" + atArg + ");" + comment() + "\n";
+			}
+			else if (uR < 50)
+			{
+				std::string atVar = var();
+				bCalls = bFunctions;
+				atHoisted.clear();
+				std::string atExpr = expr();
+				bCalls = false;
+				at += atHoisted + atVar + " = " + atExpr + ";" + comment() + "\n";
+			}
+			else if (uR < 70)
+			{
+				std::string atBool = boolean();
+				at += atBool + " = " + condition() + ";" + comment() + "\n";
+			}
+			else if ((bLoops) && (uR < 80) && (uDepth < 2))
+				at += loop_statement(uDepth);
+			else if (uDepth < 3)
+				at += if_statement(uDepth);
+		}
+
+		// the locals of the block end with it
+		atLocals.resize(uScope);
+		atLocalBools.resize(uBoolScope);
+		return at;
+	}
+
+	/// <summary>a float or bool local, the value zero (false) if not initialized</summary>
+	std::string declaration()
+	{
+		bool bBool = (pick(3) == 0);
+		std::string atName = (bBool) ? "f" + std::to_string(uLocalBools++) : "t" + std::to_string(uLocals++);
+		std::string atValue = (pick(5) == 0) ? "" : (bBool) ? condition() : expr();
+		std::string at = atName + " = " + ((atValue.size()) ? atValue : (bBool) ? "false" : "0");
+		if (!bHosted) at = ((bBool) ? "bool " : "float ") + ((atValue.size()) ? at : atName);
+		if (bBool) atLocalBools.push_back(atName); else atLocals.push_back(atName);
+		return at;
+	}
+
+	std::string loop_statement(unsigned uDepth)
+	{
+		// a local declared by the initial statement, in scope until the loop ends
+		size_t uScope = atLocals.size(), uBoolScope = atLocalBools.size();
+		std::string atInit = ((bLocals) && (pick(3) == 0)) ? declaration() : "";
+		std::string atCondition = condition();
+		bool bFor = (atInit.size()) || (pick(2) == 0);
+		if ((bFor) && (atInit.empty())) atInit = var() + " = " + expr();
+		std::string atStep = (bFor) ? var() + " = " + expr() : "";
+		unsigned uCap = 1 + pick(4);
+		std::string atCap = (pick(3) == 0) ? "n" : std::to_string(uCap);
+		unsigned uBlock = 1 + pick(3);
+		std::string atBlock = statements(uBlock, uDepth + 1);
+		atLocals.resize(uScope);
+		atLocalBools.resize(uBoolScope);
+
+		if (!bUnroll)
+		{
+			std::string at = (bFor) ? "for (" + atInit + "; " + atCondition + "; " + atStep + "; " + atCap + ")" : "while (" + atCondition + "; " + atCap + ")";
+			if ((bOneLine) && (uBlock == 1) && (atBlock.size()))
+				return at + " " + atBlock;
+			return at + "\n{\n" + atBlock + "}\n";
+		}
+
+		// each iteration : the cap (n is 0 .. 4) and the condition, the block and the step
+		std::string atGuard = "l" + std::to_string(uDepth);
+		std::string at = ((bFor) ? atInit + ";\n" : "") + atGuard + " = true;\n";
+		for (unsigned u = 0; u < ((atCap == "n") ? 4 : uCap); u++)
+		{
+			at += "if (" + atGuard + ")\n{\n" + atGuard + " = (" + atCap + " > " + std::to_string(u) + ") && (" + atCondition + ");\n}\n";
+			at += "if (" + atGuard + ")\n{\n" + atBlock + ((bFor) ? atStep + ";\n" : "") + "}\n";
+		}
+		return at;
+	}
+
+	/// <summary>name of a parameter or local of a function, hosted names are unique</summary>
+	std::string function_name(unsigned uF, const char* atKind, unsigned uIx)
+	{
+		std::string at = atKind + std::to_string(uIx);
+		if (!bHosted) return at;
+		at = "h" + std::to_string(uF) + at;
+		atHostNames.push_back(at);
+		return at;
+	}
+
+	/// <summary>function definitions, bodies of declarations and a return of expressions of the parameters (some large bodies)</summary>
+	std::string functions(unsigned uN)
+	{
+		std::string at;
+		for (unsigned uF = 0; uF < uN; uF++)
+		{
+			function sF;
+			sF.uParams = 1 + pick(3);
+			for (unsigned u = 0; u < sF.uParams; u++) atBody.push_back(function_name(uF, "u", u));
+			std::string atParams;
+			for (unsigned u = 0; u < sF.uParams; u++) atParams += ((u) ? ", " : "") + atBody[u];
+			unsigned uDeclarations = (pick(3) == 0) ? 16 + pick(8) : pick(3);
+			bCalls = true;
+			for (unsigned u = 0; u < uDeclarations; u++)
+			{
+				atHoisted.clear();
+				std::string atName = function_name(uF, "w", u), atExpr = expr();
+				sF.atLines += atHoisted + ((bHosted) ? "" : "float ") + atName + " = " + atExpr + ";\n";
+				atBody.push_back(atName);
+			}
+			atHoisted.clear();
+			sF.atReturn = expr();
+			sF.atLines += atHoisted;
+			bCalls = false;
+			atBody.clear();
+			if (!bHosted) at += "func h" + std::to_string(uF) + "(" + atParams + ")\n{\n" + sF.atLines + "return " + sF.atReturn + ";\n}\n";
+			asFunctions.push_back(sF);
+		}
+		return at;
+	}
+
+	/// <summary>a call, hosted : the arguments stored to the parameters and the body computed before</summary>
+	std::string call(unsigned uDepth)
+	{
+		unsigned uF = pick((unsigned)asFunctions.size());
+		std::vector<std::string> atArgs;
+		for (unsigned u = 0; u < asFunctions[uF].uParams; u++) atArgs.push_back(expr(uDepth + 1));
+		if (!bHosted)
+		{
+			std::string at = "h" + std::to_string(uF) + "(";
+			for (unsigned u = 0; u < atArgs.size(); u++) at += ((u) ? ", " : "") + atArgs[u];
+			return at + ")";
+		}
+		for (unsigned u = 0; u < atArgs.size(); u++) atHoisted += "h" + std::to_string(uF) + "u" + std::to_string(u) + " = " + atArgs[u] + ";\n";
+		std::string atResult = "r" + std::to_string(uResults++);
+		atHostNames.push_back(atResult);
+		atHoisted += asFunctions[uF].atLines + atResult + " = " + asFunctions[uF].atReturn + ";\n";
+		return atResult;
+	}
+
+	/// <summary>a host function call, expanded : the expression it computes</summary>
+	std::string native(unsigned uDepth)
+	{
+		unsigned uF = pick(3);
+		std::string atA = expr(uDepth + 1);
+		if (uF == 0)
+		{
+			std::string atB = expr(uDepth + 1), atC = expr(uDepth + 1);
+			return (bExpanded) ? "((" + atA + ") * (" + atB + ") + (" + atC + "))" : "mad(" + atA + ", " + atB + ", " + atC + ")";
+		}
+		if (uF == 1) return (bExpanded) ? "((" + atA + ") * 0.5)" : "half(" + atA + ")";
+		return (bExpanded) ? "(" + atA + ")" : "count(" + atA + ")";
+	}
+
+	std::string if_statement(unsigned uDepth)
+	{
+		std::string atCondition = condition();
+		unsigned uBlock = 1 + pick(3);
+		std::string atBlock = statements(uBlock, uDepth + 1);
+
+		// no else branch, a block, a one line statement or an else if
+		std::string atElse;
+		unsigned uElse = pick(4), uElseBlock = 1 + pick(3);
+		if (uElse == 1) atElse = statements(uElseBlock, uDepth + 1);
+		else if (uElse == 2) atElse = statements(1, uDepth + 1);
+		else if ((uElse == 3) && (uDepth + 1 < 3)) atElse = if_statement(uDepth + 1);
+		else uElse = 0;
+
+		if ((bGuards) && (uElse))
+		{
+			std::string atGuard = "g" + std::to_string(uDepth);
+			return atGuard + " = " + atCondition + ";\nif (" + atGuard + ")\n{\n" + atBlock + "}\nif (" + atGuard + " == false)\n{\n" + atElse + "}\n";
+		}
+
+		// a one line block of an if statement in front of an else, the else would bind to it
+		std::string at;
+		bool bLine = (bOneLine) && (uBlock == 1) && (atBlock.size()) && ((!uElse) || (atBlock.compare(0, 3, "if ") != 0));
+		if (bLine)
+			at = "if (" + atCondition + ") /* one line */ " + atBlock;
+		else
+			at = "if (" + atCondition + ")\n{\n" + atBlock + "}\n";
+		if ((uElse) && (bOneLine) && (uElse != 1) && (atElse.size()))
+			at += "else " + atElse;
+		else if (uElse)
+			at += "else\n{\n" + atElse + "}\n";
+		return at;
+	}
+};
+
+/// <summary>the spaces of a script as runs of tabs, line breaks and spaces, the comments (atComment) left as they are</summary>
+std::string whitespace(const std::string& atScript, const std::string& atComment, std::mt19937& cRng)
+{
+	const char* aatRuns[6] = { " ", "\t", "\n", "\r\n", " \t ", "\n\t\t" };
+	std::string at;
+	for (size_t uPos = 0; uPos < atScript.size();)
+	{
+		if ((atComment.size()) && (atScript.compare(uPos, atComment.size(), atComment) == 0))
+		{
+			at += atComment;
+			uPos += atComment.size();
+		}
+		else if (atScript[uPos] == ' ')
+		{
+			at += aatRuns[cRng() % 6];
+			uPos++;
+		}
+		else
+			at += atScript[uPos++];
+	}
+	return at;
+}
+
+/// <summary>equal bits, any NaN equals any NaN</summary>
+bool same(float fA, float fB)
+{
+	if (std::isnan(fA) && std::isnan(fB)) return true;
+	return std::memcmp(&fA, &fB, sizeof(float)) == 0;
+}
+
+/// <summary>host functions of the generated scripts, count() adds the calls to the unsigned the context points to</summary>
+te_type mad(const te_type* afArgs, void*) { return afArgs[0] * afArgs[1] + afArgs[2]; }
+void mad_batch(const te_type* const* apfArgs, te_type* afResult, size_t uRows, void*)
+{
+	for (size_t uR = 0; uR < uRows; uR++) afResult[uR] = apfArgs[0][uR] * apfArgs[1][uR] + apfArgs[2][uR];
+}
+te_type half(te_type fA) { return fA * 0.5f; }
+te_type count(const te_type* afArgs, void* pvContext)
+{
+	(*static_cast<unsigned*>(pvContext))++;
+	return afArgs[0];
+}
+/// <summary>host function writing its argument to the log the context points to</summary>
+te_type trace(const te_type* afArgs, void* pvContext)
+{
+	*static_cast<std::string*>(pvContext) += std::to_string((int)afArgs[0]) + " ";
+	return afArgs[0];
+}
+
+/// <summary>
+/// a generated script against its reference form, both generated from the same seed (the reference written with host variables and plain blocks) :
+/// the interpreter, the JIT, incremental evaluation and a loaded image compared to the reference after each input,
+/// then all inputs at once as the rows of a batch
+/// </summary>
+struct reference_test
+{
+	/// <summary>names of the host variables and booleans of the reference only</summary>
+	std::vector<std::string> atHostVars, atHostBools;
+	/// <summary>the loop cap n a fraction as well</summary>
+	bool bFractions = false;
+	/// <summary>host functions mad, half and count, the count() calls of each engine compared to the interpreter</summary>
+	bool bNatives = false;
+
+	/// <returns>false if a script fails to compile or on any mismatch</returns>
+	bool run(const std::string& atScript, const std::string& atReference, script_generator& cGen, bool bJit)
+	{
+		// interpreter, JIT, incremental, loaded image and the reference, the calls of count() per engine
+		const unsigned uInputs = 8;
+		float af[5][7] = {};
+		bool ab[5][3] = {};
+		unsigned auCalls[4] = {};
+		std::vector<float> afHost(atHostVars.size());
+		std::unique_ptr<bool[]> abHost = std::make_unique<bool[]>(atHostBools.size());
+		std::set<ts_variable> asVars[5];
+		std::set<ts_boolean> asBools[5];
+		std::set<ts_native> asNatives[4];
+		for (unsigned uE = 0; uE < 5; uE++)
+		{
+			for (unsigned u = 0; u < 6; u++) asVars[uE].insert({ cGen.aatVars[u], &af[uE][u] });
+			asVars[uE].insert({ "n", &af[uE][6] });
+			for (unsigned u = 0; u < 3; u++) asBools[uE].insert({ cGen.aatBools[u], &ab[uE][u] });
+			if ((bNatives) && (uE < 4)) asNatives[uE] = { { "mad", 3, &mad, nullptr, true, &mad_batch }, ts_native::wrap<&half>("half"), { "count", 1, &count, &auCalls[uE], false, nullptr } };
+		}
+		for (size_t u = 0; u < atHostVars.size(); u++) asVars[4].insert({ atHostVars[u], &afHost[u] });
+		for (size_t u = 0; u < atHostBools.size(); u++) asBools[4].insert({ atHostBools[u], &abHost[u] });
+
+		ts_parser cInterpreter(atScript, asVars[0], asBools[0], asNatives[0]), cJit(atScript, asVars[1], asBools[1], asNatives[1]);
+		ts_parser cIncremental(atScript, asVars[2], asBools[2], asNatives[2]), cReference(atReference, asVars[4], asBools[4]);
+		std::ostringstream cOut;
+		if ((cInterpreter.error().first != TS_OK) || (cReference.error().first != TS_OK) || (cInterpreter.program()->write(cOut) != TS_OK)) return false;
+		std::string atImage = cOut.str();
+		ts_parser cLoaded(ts_image{ atImage }, asVars[3], asBools[3], asNatives[3]);
+		if (((bJit) && (cJit.set_backend(ts_backend::jit) != TS_OK)) || (cLoaded.error().first != TS_OK)) return false;
+
+		// the inputs as columns, the reference results per row
+		std::vector<float> aafColumns[7], aafResults[7];
+		std::vector<bool> aabColumns[3], aabResults[3];
+		std::uniform_real_distribution<float> cValue(-4.f, 4.f);
+		for (unsigned uIn = 0; uIn < uInputs; uIn++)
+		{
+			float afIn[7];
+			bool abIn[3];
+			for (unsigned u = 0; u < 6; u++) afIn[u] = cValue(cGen.cRng);
+			afIn[6] = ((bFractions) && (cGen.pick(6) == 0)) ? 2.5f : (float)cGen.pick(5);
+			for (unsigned u = 0; u < 3; u++) abIn[u] = (cGen.pick(2) == 0);
+			std::vector<unsigned> auVars, auBools;
+			for (unsigned uE = 0; uE < 5; uE++)
+			{
+				for (unsigned u = 0; u < 7; u++)
+				{
+					if ((uE == 2) && (af[uE][u] != afIn[u])) auVars.push_back((unsigned)cIncremental.program()->var_slot((u < 6) ? cGen.aatVars[u] : "n"));
+					af[uE][u] = afIn[u];
+				}
+				for (unsigned u = 0; u < 3; u++)
+				{
+					if ((uE == 2) && (ab[uE][u] != abIn[u])) auBools.push_back((unsigned)cIncremental.program()->bool_slot(cGen.aatBools[u]));
+					ab[uE][u] = abIn[u];
+				}
+			}
+			for (unsigned u = 0; u < 7; u++) aafColumns[u].push_back(afIn[u]);
+			for (unsigned u = 0; u < 3; u++) aabColumns[u].push_back(abIn[u]);
+
+			cInterpreter.evaluate();
+			cJit.evaluate();
+			cIncremental.evaluate_changed(auVars, auBools);
+			cLoaded.evaluate();
+			cReference.evaluate();
+			for (unsigned uE = 0; uE < 4; uE++)
+			{
+				for (unsigned u = 0; u < 7; u++) if (!same(af[uE][u], af[4][u])) return false;
+				for (unsigned u = 0; u < 3; u++) if (ab[uE][u] != ab[4][u]) return false;
+				if (auCalls[uE] != auCalls[0]) return false;
+			}
+			for (unsigned u = 0; u < 7; u++) aafResults[u].push_back(af[4][u]);
+			for (unsigned u = 0; u < 3; u++) aabResults[u].push_back(ab[4][u]);
+		}
+		// all rows at once, lanes masked by the blocks, count() called once per active lane
+		std::set<ts_variable> asColumns;
+		std::set<ts_boolean> asBoolColumns;
+		std::unique_ptr<bool[]> aabBatch[3];
+		for (unsigned u = 0; u < 7; u++) asColumns.insert({ (u < 6) ? cGen.aatVars[u] : "n", aafColumns[u].data() });
+		for (unsigned u = 0; u < 3; u++)
+		{
+			aabBatch[u] = std::make_unique<bool[]>(uInputs);
+			for (unsigned uR = 0; uR < uInputs; uR++) aabBatch[u][uR] = aabColumns[u][uR];
+			asBoolColumns.insert({ cGen.aatBools[u], aabBatch[u].get() });
+		}
+		unsigned uCalls = auCalls[0];
+		auCalls[0] = 0;
+		if ((cInterpreter.evaluate_batch(asColumns, asBoolColumns, uInputs) != TS_OK) || (auCalls[0] != uCalls)) return false;
+		for (unsigned uR = 0; uR < uInputs; uR++)
+		{
+			for (unsigned u = 0; u < 7; u++) if (!same(aafColumns[u][uR], aafResults[u][uR])) return false;
+			for (unsigned u = 0; u < 3; u++) if (aabBatch[u][uR] != aabResults[u][uR]) return false;
+		}
+		return true;
+	}
+};
+
+int main()
+{
+	// without the JIT the interpreter is compared against itself
+	float fProbe = 0.f;
+	std::set<ts_variable> asProbe = { { "x", &fProbe } };
+	std::set<ts_boolean> asNoBools;
+	const bool bJit = (ts_parser("x = 1;", asProbe, asNoBools).set_backend(ts_backend::jit) == TS_OK);
+	if (!bJit) std::cout << "JIT not available on this platform, the interpreter runs in its place\n";
+
+	const unsigned uScripts = 2000, uInputs = 16;
+	unsigned uCompiled = 0, uFailed = 0;
+
+	for (unsigned uSeed = 0; uSeed < uScripts; uSeed++)
+	{
+		script_generator cGen(uSeed);
+		std::string atScript = cGen.statements(2 + cGen.pick(9));
+
+		// separate variables for the interpreter, the JIT and the incremental evaluation
+		float afI[6] = {}, afJ[6] = {}, afK[6] = {};
+		bool abI[3] = {}, abJ[3] = {}, abK[3] = {};
+		std::set<ts_variable> asVarsI, asVarsJ, asVarsK;
+		std::set<ts_boolean> asBoolsI, asBoolsJ, asBoolsK;
+		for (unsigned u = 0; u < 6; u++)
+		{
+			asVarsI.insert({ cGen.aatVars[u], &afI[u] });
+			asVarsJ.insert({ cGen.aatVars[u], &afJ[u] });
+			asVarsK.insert({ cGen.aatVars[u], &afK[u] });
+		}
+		for (unsigned u = 0; u < 3; u++)
+		{
+			asBoolsI.insert({ cGen.aatBools[u], &abI[u] });
+			asBoolsJ.insert({ cGen.aatBools[u], &abJ[u] });
+			asBoolsK.insert({ cGen.aatBools[u], &abK[u] });
+		}
+
+		ts_parser cInterpreter(atScript, asVarsI, asBoolsI);
+		ts_parser cJit(atScript, asVarsJ, asBoolsJ);
+		ts_parser cIncremental(atScript, asVarsK, asBoolsK);
+		// every generated script compiles
+		if ((cInterpreter.error().first != TS_OK) || ((bJit) && (cJit.set_backend(ts_backend::jit) != TS_OK)))
+		{
+			std::cout << "compile error (seed " << uSeed << ")\n" << atScript << "\n";
+			uFailed++;
+			continue;
+		}
+		uCompiled++;
+
+		// randomized inputs, including zero and negative values, a random part changed per input
+		std::uniform_real_distribution<float> cValue(-4.f, 4.f);
+		for (unsigned uIn = 0; uIn < uInputs; uIn++)
+		{
+			std::vector<unsigned> auVars, auBools;
+			for (unsigned u = 0; u < 6; u++)
+			{
+				if ((uIn > 0) && (cGen.pick(2) == 0)) continue;
+				afI[u] = afJ[u] = afK[u] = (cGen.pick(8) == 0) ? 0.f : cValue(cGen.cRng);
+				auVars.push_back((unsigned)cIncremental.program()->var_slot(cGen.aatVars[u]));
+			}
+			for (unsigned u = 0; u < 3; u++)
+			{
+				if ((uIn > 0) && (cGen.pick(2) == 0)) continue;
+				abI[u] = abJ[u] = abK[u] = (cGen.pick(2) == 0);
+				auBools.push_back((unsigned)cIncremental.program()->bool_slot(cGen.aatBools[u]));
+			}
+
+			cInterpreter.evaluate();
+			cJit.evaluate();
+			cIncremental.evaluate_changed(auVars, auBools);
+
+			bool bSame = true;
+			for (unsigned u = 0; u < 6; u++) bSame = bSame && same(afI[u], afJ[u]) && same(afI[u], afK[u]);
+			for (unsigned u = 0; u < 3; u++) bSame = bSame && (abI[u] == abJ[u]) && (abI[u] == abK[u]);
+			if (!bSame)
+			{
+				std::cout << "mismatch (seed " << uSeed << ", input " << uIn << ")\n" << atScript << "\n";
+				uFailed++;
+				break;
+			}
+		}
+	}
+
+	std::cout << uCompiled << " scripts, " << uCompiled * uInputs << " inputs, " << uFailed << " mismatches\n";
+
+	// wide scripts of independent sections (own variables per section), sequential against the thread pool
+	const unsigned uWide = 20, uSections = 12;
+	unsigned uParallel = 0, uWideFailed = 0;
+	ts_thread_pool cPool(4);
+	for (unsigned uSeed = 0; uSeed < uWide; uSeed++)
+	{
+		script_generator cGen(10000 + uSeed);
+		std::string atScript;
+		std::vector<float> afS(uSections * 6), afP(uSections * 6);
+		std::unique_ptr<bool[]> abS = std::make_unique<bool[]>(uSections * 3), abP = std::make_unique<bool[]>(uSections * 3);
+		std::set<ts_variable> asVarsS, asVarsP;
+		std::set<ts_boolean> asBoolsS, asBoolsP;
+		for (unsigned uS = 0; uS < uSections; uS++)
+		{
+			std::string atSuffix = std::to_string(uS);
+			atScript += std::regex_replace(cGen.statements(80), std::regex("\\b[abcdxypqr]\\b"), "$&" + atSuffix);
+			for (unsigned u = 0; u < 6; u++)
+			{
+				asVarsS.insert({ cGen.aatVars[u] + atSuffix, &afS[uS * 6 + u] });
+				asVarsP.insert({ cGen.aatVars[u] + atSuffix, &afP[uS * 6 + u] });
+			}
+			for (unsigned u = 0; u < 3; u++)
+			{
+				asBoolsS.insert({ cGen.aatBools[u] + atSuffix, &abS[uS * 3 + u] });
+				asBoolsP.insert({ cGen.aatBools[u] + atSuffix, &abP[uS * 3 + u] });
+			}
+		}
+
+		// the pooled parser loads the program image of the sequential one (schedule included)
+		ts_parser cSequential(atScript, asVarsS, asBoolsS);
+		if (cSequential.error().first != TS_OK)
+		{
+			std::cout << "compile error (seed " << 10000 + uSeed << ")\n";
+			uWideFailed++;
+			continue;
+		}
+		std::ostringstream cImage;
+		cSequential.program()->write(cImage);
+		std::string atImage = cImage.str();
+		ts_parser cPooled(ts_image{ atImage }, asVarsP, asBoolsP);
+		uParallel += (cPooled.program()->parallel()) ? 1 : 0;
+
+		std::uniform_real_distribution<float> cValue(-4.f, 4.f);
+		for (unsigned uIn = 0; uIn < 4; uIn++)
+		{
+			for (size_t u = 0; u < afS.size(); u++) afS[u] = afP[u] = cValue(cGen.cRng);
+			for (size_t u = 0; u < uSections * 3; u++) abS[u] = abP[u] = (cGen.pick(2) == 0);
+
+			cSequential.evaluate();
+			cPooled.evaluate(cPool);
+
+			bool bSame = true;
+			for (size_t u = 0; u < afS.size(); u++) bSame = bSame && same(afS[u], afP[u]);
+			for (size_t u = 0; u < uSections * 3; u++) bSame = bSame && (abS[u] == abP[u]);
+			if (!bSame)
+			{
+				std::cout << "parallel mismatch (seed " << 10000 + uSeed << ", input " << uIn << ")\n";
+				uWideFailed++;
+				break;
+			}
+		}
+	}
+	std::cout << uWide << " wide scripts, " << uParallel << " scheduled on the pool, " << uWideFailed << " mismatches\n";
+
+	// one line "if" statements, comments and locals, spaces as runs of whitespace, read in chunks of random size, against the block form as a whole
+	const unsigned uSources = 500;
+	unsigned uSourceFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uSources; uSeed++)
+	{
+		script_generator cBlocks(20000 + uSeed), cOneLine(20000 + uSeed);
+		cOneLine.bOneLine = true;
+		cBlocks.bLocals = cOneLine.bLocals = (uSeed % 2 == 0);
+		std::string atBlocks = cBlocks.statements(2 + cBlocks.pick(9)), atOneLine = cOneLine.statements(2 + cOneLine.pick(9));
+		atOneLine = whitespace(atOneLine, cOneLine.comment(), cOneLine.cRng);
+
+		float af[6] = {};
+		bool ab[3] = {};
+		std::set<ts_variable> asVars;
+		std::set<ts_boolean> asBools;
+		for (unsigned u = 0; u < 6; u++) asVars.insert({ cBlocks.aatVars[u], &af[u] });
+		for (unsigned u = 0; u < 3; u++) asBools.insert({ cBlocks.aatBools[u], &ab[u] });
+
+		ts_program cWhole(atBlocks, asVars, asBools);
+		size_t uPos = 0;
+		std::mt19937 cChunks(uSeed);
+		ts_program cChunked(ts_source([&](char* pc, size_t uSize)
+			{
+				size_t uRead = std::min({ uSize, (size_t)(1 + cChunks() % 16), atOneLine.size() - uPos });
+				std::memcpy(pc, atOneLine.data() + uPos, uRead);
+				uPos += uRead;
+				return uRead;
+			}), asVars, asBools);
+		if ((cWhole.error().first != TS_OK) || (cWhole.error() != cChunked.error()) || (cWhole.dump() != cChunked.dump()))
+		{
+			std::cout << "source mismatch (seed " << 20000 + uSeed << ")\n" << atOneLine << "\n";
+			uSourceFailed++;
+		}
+	}
+
+	// tabs and line breaks separating the statements and keywords, against the same scripts separated by spaces
+	const std::pair<const char*, const char*> asSeparated[] =
+	{
+		{ "if (a > 1)\n\tx = 1;\ny = 2;", "if (a > 1) x = 1; y = 2;" },
+		{ "if\t(a > 1)\r\n{\r\n\tx = 1;\r\n}\r\nif (p)\n\ty\v=\f2;", "if (a > 1) { x = 1; } if (p) y = 2;" },
+		{ "if (a > 1)\n\tx = 1;\nelse\n\ty = 2;", "if (a > 1) x = 1; else y = 2;" },
+		{ "if (a > 1)\r\n{\r\n\tx = 1;\r\n}\r\nelse\r\nif (a < 0)\r\n\ty = 3;\r\nelse\tif (p)\n{\n\ty = 2;\n}", "if (a > 1) { x = 1; } else if (a < 0) y = 3; else if (p) { y = 2; }" },
+		{ "if (a > 1) x = 1; else\v\fy = 2;", "if (a > 1) x = 1; else y = 2;" },
+		{ "float\tt = 3;\nbool\tf = t > a;\nif (f) x = t;", "float t = 3; bool f = t > a; if (f) x = t;" },
+		{ "for (float\ni = 0; i < 3; i = i + 1)\n\tx = x + i;", "for (float i = 0; i < 3; i = i + 1) x = x + i;" },
+		{ "func\nsq(u)\n{\n\treturn\tu * u;\n}\nx = sq(a);", "func sq(u) { return u * u; } x = sq(a);" },
+		{ "func\tsq(u) {\r\nfloat\tw = u;\r\nreturn\r\nw * u; }\tp = sq(a) > 1;", "func sq(u) { float w = u; return w * u; } p = sq(a) > 1;" }
+	};
+	for (const std::pair<const char*, const char*>& sPair : asSeparated)
+	{
+		float af[6] = {};
+		bool ab[3] = {};
+		std::set<ts_variable> asVars;
+		std::set<ts_boolean> asBools;
+		for (unsigned u = 0; u < 6; u++) asVars.insert({ script_generator(0).aatVars[u], &af[u] });
+		for (unsigned u = 0; u < 3; u++) asBools.insert({ script_generator(0).aatBools[u], &ab[u] });
+		ts_program cSeparated(sPair.first, asVars, asBools), cSpaces(sPair.second, asVars, asBools);
+		if ((cSeparated.error().first != TS_OK) || (cSpaces.error().first != TS_OK) || (cSeparated.dump() != cSpaces.dump()))
+		{
+			std::cout << "whitespace mismatch\n" << sPair.first << "\n";
+			uSourceFailed++;
+		}
+	}
+	std::cout << uSources << " sources, " << uSourceFailed << " mismatches\n";
+
+	// else branches and else if chains (one line forms as well) against if blocks of guard booleans
+	const unsigned uElses = 500;
+	unsigned uElseFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uElses; uSeed++)
+	{
+		script_generator cElse(40000 + uSeed), cGuards(40000 + uSeed);
+		cElse.bOneLine = (uSeed % 2 == 0);
+		cGuards.bGuards = true;
+		std::string atElse = cElse.statements(2 + cElse.pick(9)), atGuards = cGuards.statements(2 + cGuards.pick(9));
+
+		float afE[6] = {}, afG[6] = {};
+		bool abE[3] = {}, abG[7] = {};
+		std::set<ts_variable> asVarsE, asVarsG;
+		std::set<ts_boolean> asBoolsE, asBoolsG;
+		for (unsigned u = 0; u < 6; u++)
+		{
+			asVarsE.insert({ cElse.aatVars[u], &afE[u] });
+			asVarsG.insert({ cElse.aatVars[u], &afG[u] });
+		}
+		for (unsigned u = 0; u < 3; u++)
+		{
+			asBoolsE.insert({ cElse.aatBools[u], &abE[u] });
+			asBoolsG.insert({ cElse.aatBools[u], &abG[u] });
+		}
+		for (unsigned u = 0; u < 4; u++) asBoolsG.insert({ "g" + std::to_string(u), &abG[3 + u] });
+
+		ts_parser cBranches(atElse, asVarsE, asBoolsE), cGuarded(atGuards, asVarsG, asBoolsG);
+		bool bFailed = (cBranches.error().first != TS_OK) || (cGuarded.error().first != TS_OK);
+		std::uniform_real_distribution<float> cValue(-4.f, 4.f);
+		for (unsigned uIn = 0; (uIn < 4) && (!bFailed); uIn++)
+		{
+			for (unsigned u = 0; u < 6; u++) afE[u] = afG[u] = cValue(cElse.cRng);
+			for (unsigned u = 0; u < 3; u++) abE[u] = abG[u] = (cElse.pick(2) == 0);
+			cBranches.evaluate();
+			cGuarded.evaluate();
+			for (unsigned u = 0; u < 6; u++) bFailed = bFailed || !same(afE[u], afG[u]);
+			for (unsigned u = 0; u < 3; u++) bFailed = bFailed || (abE[u] != abG[u]);
+		}
+		if (bFailed)
+		{
+			std::cout << "else mismatch (seed " << 40000 + uSeed << ")\n" << atElse << "\n";
+			uElseFailed++;
+		}
+	}
+	std::cout << uElses << " else chains, " << uElseFailed << " mismatches\n";
+
+	// compiled program images loaded against more variables (other slots), corrupted images rejected
+	const unsigned uImages = 500;
+	unsigned uImageFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uImages; uSeed++)
+	{
+		script_generator cGen(30000 + uSeed);
+		std::string atScript = cGen.statements(2 + cGen.pick(9));
+
+		float afC[6] = {}, afL[6] = {}, afExtra[2] = {};
+		bool abC[3] = {}, abL[3] = {}, abExtra[2] = {};
+		std::set<ts_variable> asVarsC, asVarsL = { { "aa", &afExtra[0] }, { "e0", &afExtra[1] } };
+		std::set<ts_boolean> asBoolsC, asBoolsL = { { "aa", &abExtra[0] }, { "pp", &abExtra[1] } };
+		for (unsigned u = 0; u < 6; u++)
+		{
+			asVarsC.insert({ cGen.aatVars[u], &afC[u] });
+			asVarsL.insert({ cGen.aatVars[u], &afL[u] });
+		}
+		for (unsigned u = 0; u < 3; u++)
+		{
+			asBoolsC.insert({ cGen.aatBools[u], &abC[u] });
+			asBoolsL.insert({ cGen.aatBools[u], &abL[u] });
+		}
+
+		ts_parser cCompiled(atScript, asVarsC, asBoolsC);
+		std::ostringstream cOut;
+		if ((cCompiled.error().first != TS_OK) || (cCompiled.program()->write(cOut) != TS_OK))
+		{
+			std::cout << "compile error (seed " << 30000 + uSeed << ")\n" << atScript << "\n";
+			uImageFailed++;
+			continue;
+		}
+		bool bFailed = false;
+		std::string atImage = cOut.str();
+
+		// one image in ten through a mapped file
+		std::unique_ptr<ts_parser> pcLoaded;
+		if (uSeed % 10 == 0)
+		{
+			std::string atPath = "test_differential_image.tspi";
+			std::ofstream(atPath, std::ios::binary).write(atImage.data(), (std::streamsize)atImage.size());
+			{
+				ts_mapped_file cFile(atPath);
+				pcLoaded = std::make_unique<ts_parser>(cFile.image(), asVarsL, asBoolsL);
+			}
+			std::remove(atPath.c_str());
+		}
+		else
+			pcLoaded = std::make_unique<ts_parser>(ts_image{ atImage }, asVarsL, asBoolsL);
+		bFailed = bFailed || (pcLoaded->error().first != TS_OK);
+
+		std::uniform_real_distribution<float> cValue(-4.f, 4.f);
+		for (unsigned uIn = 0; (uIn < 4) && (!bFailed); uIn++)
+		{
+			for (unsigned u = 0; u < 6; u++) afC[u] = afL[u] = cValue(cGen.cRng);
+			for (unsigned u = 0; u < 3; u++) abC[u] = abL[u] = (cGen.pick(2) == 0);
+			cCompiled.evaluate();
+			pcLoaded->evaluate();
+			for (unsigned u = 0; u < 6; u++) bFailed = bFailed || !same(afC[u], afL[u]);
+			for (unsigned u = 0; u < 3; u++) bFailed = bFailed || (abC[u] != abL[u]);
+		}
+
+		// a changed byte, a truncated image, a missing variable
+		std::string atCorrupt = atImage;
+		atCorrupt[cGen.pick((unsigned)atCorrupt.size())] ^= (char)(1 + cGen.pick(255));
+		bFailed = bFailed || (ts_program(ts_image{ atCorrupt }, asVarsL, asBoolsL).error().first == TS_OK);
+		bFailed = bFailed || (ts_program(ts_image{ std::string_view(atImage).substr(0, cGen.pick((unsigned)atImage.size())) }, asVarsL, asBoolsL).error().first == TS_OK);
+		std::set<ts_variable> asMissing = asVarsC;
+		asMissing.erase(asMissing.begin());
+		bool bUsed = std::regex_search(cCompiled.program()->dump(), std::regex("\\b" + asVarsC.begin()->m_name + "\\b"));
+		bFailed = bFailed || (bUsed && (ts_program(ts_image{ atImage }, asMissing, asBoolsC).error().first == TS_OK));
+		if (bFailed)
+		{
+			std::cout << "image mismatch (seed " << 30000 + uSeed << ")\n" << atScript << "\n";
+			uImageFailed++;
+		}
+	}
+	std::cout << uImages << " images, " << uImageFailed << " mismatches\n";
+
+	// loops (one line forms as well) against loops unrolled to if blocks
+	const unsigned uLoops = 500;
+	unsigned uLoopFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uLoops; uSeed++)
+	{
+		script_generator cLoops(50000 + uSeed), cUnrolled(50000 + uSeed);
+		cLoops.bOneLine = (uSeed % 2 == 0);
+		cLoops.bLoops = cUnrolled.bLoops = cUnrolled.bUnroll = true;
+		std::string atLoops = cLoops.statements(2 + cLoops.pick(9)), atUnrolled = cUnrolled.statements(2 + cUnrolled.pick(9));
+
+		reference_test sTest;
+		sTest.atHostBools = { "l0", "l1", "l2" };
+		sTest.bFractions = true;
+		if (!sTest.run(atLoops, atUnrolled, cLoops, bJit))
+		{
+			std::cout << "loop mismatch (seed " << 50000 + uSeed << ")\n" << atLoops << "\n";
+			uLoopFailed++;
+		}
+	}
+	std::cout << uLoops << " loops, " << uLoopFailed << " mismatches\n";
+
+	// script locals against the same script with host variables, the locals no script variables of the host
+	const unsigned uLocalScripts = 500;
+	unsigned uLocalFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uLocalScripts; uSeed++)
+	{
+		script_generator cLocals(60000 + uSeed), cHosted(60000 + uSeed);
+		cLocals.bOneLine = (uSeed % 2 == 0);
+		cLocals.bLoops = cHosted.bLoops = cLocals.bLocals = cHosted.bLocals = cHosted.bHosted = true;
+		std::string atLocals = cLocals.statements(2 + cLocals.pick(9)), atHosted = cHosted.statements(2 + cHosted.pick(9));
+
+		reference_test sTest;
+		for (unsigned u = 0; u < cHosted.uLocals; u++) sTest.atHostVars.push_back("t" + std::to_string(u));
+		for (unsigned u = 0; u < cHosted.uLocalBools; u++) sTest.atHostBools.push_back("f" + std::to_string(u));
+		float af[7] = {};
+		bool ab[3] = {};
+		std::set<ts_variable> asVars = { { "n", &af[6] } };
+		std::set<ts_boolean> asBools;
+		for (unsigned u = 0; u < 6; u++) asVars.insert({ cLocals.aatVars[u], &af[u] });
+		for (unsigned u = 0; u < 3; u++) asBools.insert({ cLocals.aatBools[u], &ab[u] });
+		bool bHidden = (cLocals.uLocals == 0) || (ts_program(atLocals, asVars, asBools).var_slot("t0") == TS_FAIL);
+		if ((!bHidden) || (!sTest.run(atLocals, atHosted, cLocals, bJit)))
+		{
+			std::cout << "locals mismatch (seed " << 60000 + uSeed << ")\n" << atLocals << "\n";
+			uLocalFailed++;
+		}
+	}
+	std::cout << uLocalScripts << " local scripts, " << uLocalFailed << " mismatches\n";
+
+	// script functions (inlined and invoked) against the calls computed by host variables
+	const unsigned uFunctionScripts = 500;
+	unsigned uFunctionFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uFunctionScripts; uSeed++)
+	{
+		script_generator cFunctions(70000 + uSeed), cHosted(70000 + uSeed);
+		cFunctions.bLoops = cHosted.bLoops = cFunctions.bFunctions = cHosted.bFunctions = cHosted.bHosted = true;
+		unsigned uDefinitions = 1 + cFunctions.pick(3);
+		cHosted.pick(3);
+		std::string atFunctions = cFunctions.functions(uDefinitions), atHosted = cHosted.functions(uDefinitions);
+		atFunctions += cFunctions.statements(2 + cFunctions.pick(9));
+		atHosted += cHosted.statements(2 + cHosted.pick(9));
+
+		reference_test sTest;
+		sTest.atHostVars = cHosted.atHostNames;
+		if (!sTest.run(atFunctions, atHosted, cFunctions, bJit))
+		{
+			std::cout << "functions mismatch (seed " << 70000 + uSeed << ")\n" << atFunctions << "\n";
+			uFunctionFailed++;
+		}
+	}
+	std::cout << uFunctionScripts << " function scripts, " << uFunctionFailed << " mismatches\n";
+
+	// host function calls against the expressions they compute, the calls of the impure count() against the interpreter
+	const unsigned uNativeScripts = 500;
+	unsigned uNativeFailed = 0;
+	for (unsigned uSeed = 0; uSeed < uNativeScripts; uSeed++)
+	{
+		script_generator cNatives(80000 + uSeed), cExpanded(80000 + uSeed);
+		cNatives.bLoops = cExpanded.bLoops = cNatives.bNatives = cExpanded.bNatives = cExpanded.bExpanded = true;
+		std::string atNatives = cNatives.statements(2 + cNatives.pick(9)), atExpanded = cExpanded.statements(2 + cExpanded.pick(9));
+
+		reference_test sTest;
+		sTest.bNatives = true;
+		if (!sTest.run(atNatives, atExpanded, cNatives, bJit))
+		{
+			std::cout << "host functions mismatch (seed " << 80000 + uSeed << ")\n" << atNatives << "\n";
+			uNativeFailed++;
+		}
+	}
+	std::cout << uNativeScripts << " host function scripts, " << uNativeFailed << " mismatches\n";
+
+	// impure host functions behind "&&" and "||", in script functions (inlined and invoked) and their arguments : the calls in the order written
+	std::string atInvoked = "func g(u)\n{\nfloat w = trace(u);\n";
+	for (unsigned u = 0; u < 40; u++) atInvoked += "w = w * 0.5 + u;\n";
+	atInvoked += "return w;\n}\n";
+	const std::pair<std::string, std::string> asOrdered[] =
+	{
+		{ "q = trace(1) > 0 && trace(2) > 0;", "1 2 " },
+		{ "func f(u) { return trace(u); } p = false; q = p && f(7) > 0;", "" },
+		{ "func f(u) { return trace(u); } q = trace(1) > 0 && f(2) > 0;", "1 2 " },
+		{ "func f(u) { return u; } q = trace(1) > 0 && f(trace(2)) > 0;", "1 2 " },
+		{ "func f(u) { return trace(u); } q = f(1) > 0 || f(2) > 0; if (f(3) > 0 && f(4) > 9) x = f(5);", "1 3 4 " },
+		{ "func f(u) { return trace(u) + trace(u + 1); } x = f(1) + f(3); p = x < 0 && f(5) > 0;", "1 2 3 4 " },
+		{ atInvoked + "p = false; q = p && g(1) > 0; q = q || g(2) > 0; q = trace(3) > 0 || g(4) > 0;", "2 3 " }
+	};
+	unsigned uOrderedFailed = 0;
+	for (const std::pair<std::string, std::string>& sOrdered : asOrdered)
+	{
+		// interpreter, JIT and loaded image, the calls of each written to its log
+		float af[3] = {};
+		bool ab[3][2] = {};
+		std::string atLogs[3];
+		std::set<ts_variable> asVars[3];
+		std::set<ts_boolean> asBools[3];
+		std::set<ts_native> asNatives[3];
+		for (unsigned uE = 0; uE < 3; uE++)
+		{
+			asVars[uE] = { { "x", &af[uE] } };
+			asBools[uE] = { { "p", &ab[uE][0] }, { "q", &ab[uE][1] } };
+			asNatives[uE] = { { "trace", 1, &trace, &atLogs[uE], false, nullptr } };
+		}
+		ts_parser cInterpreter(sOrdered.first, asVars[0], asBools[0], asNatives[0]), cJit(sOrdered.first, asVars[1], asBools[1], asNatives[1]);
+		std::ostringstream cOut;
+		bool bFailed = (cInterpreter.error().first != TS_OK) || (cInterpreter.program()->write(cOut) != TS_OK) ||
+			((bJit) && (cJit.set_backend(ts_backend::jit) != TS_OK));
+		std::string atImage = cOut.str();
+		ts_parser cLoaded(ts_image{ atImage }, asVars[2], asBools[2], asNatives[2]);
+		bFailed = bFailed || (cLoaded.error().first != TS_OK);
+		if (!bFailed)
+		{
+			cInterpreter.evaluate();
+			cJit.evaluate();
+			cLoaded.evaluate();
+			for (unsigned uE = 0; uE < 3; uE++) bFailed = bFailed || (atLogs[uE] != sOrdered.second);
+		}
+		if (bFailed)
+		{
+			std::cout << "host function order mismatch : \"" << atLogs[0] << "\" instead of \"" << sOrdered.second << "\"\n" << sOrdered.first << "\n";
+			uOrderedFailed++;
+		}
+	}
+	std::cout << sizeof(asOrdered) / sizeof(asOrdered[0]) << " host function orders, " << uOrderedFailed << " mismatches\n";
+
+	return ((uFailed) || (uWideFailed) || (uSourceFailed) || (uElseFailed) || (uImageFailed) || (uLoopFailed) || (uLocalFailed) || (uFunctionFailed) || (uNativeFailed) || (uOrderedFailed)) ? 1 : 0;
+}
@@ -73,7 +73,13 @@
 #define TE_FLOAT
 
 #include "../tinyscript.h"
+#include <cfenv>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+#include <thread>
 
 #define PI 3.141592654f
 
@@ -117,6 +123,45 @@ void IK_EndEffectorToTargetAngles(
 	}
 }
 
+/// <summary>
+/// compile "r = condition;" with a = 1, b = 2, p = true and q = false,
+/// compare r to the expected value
+/// </summary>
+bool check_condition(const std::string& atCondition, bool bExpected)
+{
+	float fA = 1.f, fB = 2.f;
+	bool bP = true, bQ = false, bR = !bExpected;
+	std::set<ts_variable> asVars = { { "a", &fA }, { "b", &fB } };
+	std::set<ts_boolean> asBools = { { "p", &bP }, { "q", &bQ }, { "r", &bR } };
+	ts_parser cTSP("r = " + atCondition + ";", asVars, asBools);
+	if (cTSP.error().first == TS_OK)
+		cTSP.evaluate();
+	if ((cTSP.error().first == TS_OK) && (bR == bExpected))
+		return true;
+	std::cout << "failed : r = " << atCondition << "; (expected " << (bExpected ? "true" : "false") << ")\n";
+	return false;
+}
+
+/// <summary>number of instructions of the operation in a program dump</summary>
+size_t count_op(const std::string& atDump, const std::string& atOp)
+{
+	std::istringstream atS(atDump);
+	std::string atLine;
+	size_t uCount = 0;
+	while (std::getline(atS, atLine))
+	{
+		std::istringstream atL(atLine);
+		std::string atIx, atName;
+		atL >> atIx >> atName;
+		if (atName == atOp) uCount++;
+	}
+	return uCount;
+}
+
+/// <summary>impure host functions of the variable the context points to : add one and return it, return it</summary>
+te_type bump(const te_type*, void* pvContext) { return *static_cast<te_type*>(pvContext) += 1.f; }
+te_type peek(const te_type*, void* pvContext) { return *static_cast<te_type*>(pvContext); }
+
 int main()
 {
 	float fTarX = 0.f, fTarY = 0.f, fTarZ = 0.f, fAlpha = 0.f, fBeta = 0.f, fGamma = 0.f;
@@ -192,4 +237,228 @@ int main()
 				cTSP.evaluate();
 				std::cout << "Alpha, Beta, Gamma (TinyScript++) : " << fAlpha << ", " << fBeta << ", " << fGamma << "\n\n";
 			}
+
+	// evaluate all targets at once (one column per variable, fA and fC are the same for all rows)
+	std::vector<float> afX, afY, afZ, afAlpha(8), afBeta(8), afGamma(8), afB(8), afD(8);
+	for (float fX : { -1.1f, 1.2f })
+		for (float fY : { .5f, 1.9f })
+			for (float fZ : { 1.3f, 1.4f })
+				afX.push_back(fX), afY.push_back(fY), afZ.push_back(fZ);
+	std::set<ts_variable> asColumns =
+	{
+		{ "fTarX", afX.data() },
+		{ "fTarY", afY.data() },
+		{ "fTarZ", afZ.data() },
+		{ "fAlpha", afAlpha.data() },
+		{ "fBeta", afBeta.data() },
+		{ "fGamma", afGamma.data() },
+		{ "fB", afB.data() },
+		{ "fD", afD.data() }
+	};
+	std::set<ts_boolean> asBoolColumns = { };
+	cTSP.evaluate_batch(asColumns, asBoolColumns, afX.size());
+	for (size_t uRow = 0; uRow < afX.size(); uRow++)
+	{
+		IK_EndEffectorToTargetAngles(afX[uRow], afY[uRow], afZ[uRow], fA, fC, fAlpha, fBeta, fGamma);
+		std::cout << "Target (x/y/z) : " << afX[uRow] << "/ " << afY[uRow] << "/ " << afZ[uRow] << "\n";
+		std::cout << "Alpha, Beta, Gamma (C++)          : " << fAlpha << ", " << fBeta << ", " << fGamma << "\n";
+		std::cout << "Alpha, Beta, Gamma (TinyScript++) : " << afAlpha[uRow] << ", " << afBeta[uRow] << ", " << afGamma[uRow] << " (batch)\n\n";
+	}
+
+	// same program on one thread per target, each thread binds its row to a context of its own
+	std::fill(afAlpha.begin(), afAlpha.end(), 0.f);
+	std::fill(afBeta.begin(), afBeta.end(), 0.f);
+	std::fill(afGamma.begin(), afGamma.end(), 0.f);
+	std::vector<std::thread> acThreads;
+	for (size_t uRow = 0; uRow < afX.size(); uRow++)
+		acThreads.emplace_back([&, uRow]()
+			{
+				std::set<ts_variable> asRow =
+				{
+					{ "fTarX", &afX[uRow] }, { "fTarY", &afY[uRow] }, { "fTarZ", &afZ[uRow] },
+					{ "fAlpha", &afAlpha[uRow] }, { "fBeta", &afBeta[uRow] }, { "fGamma", &afGamma[uRow] },
+					{ "fB", &afB[uRow] }, { "fD", &afD[uRow] }
+				};
+				ts_context cContext(cTSP.program());
+				cContext.bind(asRow, asBoolColumns);
+				cContext.evaluate();
+			});
+	for (std::thread& cThread : acThreads)
+		cThread.join();
+	for (size_t uRow = 0; uRow < afX.size(); uRow++)
+		std::cout << "Alpha, Beta, Gamma (TinyScript++) : " << afAlpha[uRow] << ", " << afBeta[uRow] << ", " << afGamma[uRow] << " (thread " << uRow << ")\n";
+
+	// conditions follow the C++ precedence : "||" below "&&" below equality below relations
+	unsigned uFailed = 0;
+	const std::vector<std::pair<std::string, bool>> asConditions =
+	{
+		{ "p || q && false", true },
+		{ "q && p || p", true },
+		{ "p && a < b", true },
+		{ "a < b == p", true },
+		{ "b < a == q", true },
+		{ "a == b || a != b && p", true },
+		{ "q || a >= b || b <= a", false },
+		{ "(p || q) && false", false },
+		{ "((p || q) && ((a < b) || q))", true },
+		{ "(p && (q || (b > a)))", true },
+		{ "((((a)))) < b", true },
+		{ "true && false", false },
+		{ "false || true", true },
+		{ "true == p", true },
+		{ "false != q", false },
+		{ "p == q", false },
+		{ "p != q", true },
+		{ "p", true },
+		{ "q", false },
+	};
+	for (const auto& s : asConditions)
+		if (!check_condition(s.first, s.second)) uFailed++;
+
+	// the right operand of "&&" and "||" is skipped if the left one decides
+	// (evaluated, comparing the NaN raises the invalid operation flag),
+	// an operand first evaluated in a skipped right operand is evaluated again where it is used next
+	{
+		float fA = std::numeric_limits<float>::quiet_NaN(), fB = 2.f;
+		bool bP = true, bQ = false, bR = false, bS = true;
+		std::set<ts_variable> asVars = { { "a", &fA }, { "b", &fB } };
+		std::set<ts_boolean> asBools = { { "p", &bP }, { "q", &bQ }, { "r", &bR }, { "s", &bS } };
+		ts_parser cTSP("r = p || a < b; s = q && a < b;", asVars, asBools);
+		std::feclearexcept(FE_ALL_EXCEPT);
+		if (cTSP.error().first == TS_OK)
+			cTSP.evaluate();
+		if ((cTSP.error().first != TS_OK) || (bR != true) || (bS != false) || (std::fetestexcept(FE_INVALID)))
+		{
+			std::cout << "failed : right operand skipped\n";
+			uFailed++;
+		}
+	}
+	if (!check_condition("(q && a < b) || a < b", true)) uFailed++;
+	if (!check_condition("(p || b < a) && b < a", false)) uFailed++;
+
+	// the optimized program computes the same values as the program compiled statement by statement
+	{
+		ts_parser cNone(atCode, asVars, asBools, ts_optimize::none);
+		ts_parser cFull(atCode, asVars, asBools, ts_optimize::full);
+		const std::vector<float*> apfResults = { &fAlpha, &fBeta, &fGamma, &fB, &fD };
+		for (float fX : { -1.1f, 1.2f, 0.f })
+			for (float fY : { .5f, 1.9f })
+				for (float fZ : { 1.3f, -1.4f })
+				{
+					std::vector<float> afNone, afFull;
+					fTarX = fX, fTarY = fY, fTarZ = fZ;
+					cNone.evaluate();
+					for (float* pf : apfResults) afNone.push_back(*pf);
+					cFull.evaluate();
+					for (float* pf : apfResults) afFull.push_back(*pf);
+					if (std::memcmp(afNone.data(), afFull.data(), afNone.size() * sizeof(float)))
+					{
+						std::cout << "failed : optimized result, target " << fX << "/ " << fY << "/ " << fZ << "\n";
+						uFailed++;
+					}
+				}
+	}
+
+	// the dump shows the folded constant (2. * 3.) and one multiplication "a * b" for both statements
+	{
+		float fX = 0.f, fY = 0.f, fA = 3.f, fB = 4.f;
+		std::set<ts_variable> asOpt = { { "x", &fX }, { "y", &fY }, { "a", &fA }, { "b", &fB } };
+		std::set<ts_boolean> asNoBools = { };
+		const char* atOpt = "x = a * (2. * 3.) + a * b; y = a * b - 1.;";
+		ts_parser cNone(atOpt, asOpt, asNoBools, ts_optimize::none);
+		ts_parser cFull(atOpt, asOpt, asNoBools, ts_optimize::full);
+		std::string atNone = cNone.program()->dump(), atFull = cFull.program()->dump();
+		cFull.evaluate();
+		if ((count_op(atNone, "mul") != 4) || (count_op(atFull, "mul") != 2) || (atFull.find(", 6\n") == std::string::npos) ||
+			(fX != 30.f) || (fY != 11.f))
+		{
+			std::cout << "failed : optimized dump\n" << atNone << "\n" << atFull << "\n";
+			uFailed++;
+		}
+	}
+
+	// impure host functions read and write a script variable through their context,
+	// no value of it is reused, stored ahead or scheduled across their calls
+	{
+		float fProbe = 0.f;
+		std::set<ts_variable> asProbe = { { "x", &fProbe } };
+		std::set<ts_boolean> asNoBools = { };
+		const bool bJit = (ts_parser("x = 1;", asProbe, asNoBools).set_backend(ts_backend::jit) == TS_OK);
+
+		float fA = 0.f, fX = 0.f, fY = 0.f, fZ = 0.f;
+		std::set<ts_variable> asNativeVars = { { "a", &fA }, { "x", &fX }, { "y", &fY }, { "z", &fZ } };
+		std::set<ts_native> asNatives = { { "bump", 1, &bump, &fA, false, nullptr }, { "peek", 1, &peek, &fA, false, nullptr } };
+		std::string atInvoked = "func g(u)\n{\nfloat w = bump(u);\n";
+		for (unsigned u = 0; u < 40; u++) atInvoked += "w = w + u;\n";
+		atInvoked += "return w;\n}\n";
+
+		// a = 1 and x, y, z = 0 before, a, x, y and z after
+		struct impure_test
+		{
+			std::string atScript;
+			float afExpected[4];
+		};
+		const impure_test asImpure[] =
+		{
+			{ "x = a; y = bump(0); z = a;", { 2.f, 1.f, 2.f, 2.f } },
+			{ "a = 3; y = peek(0); a = 5;", { 5.f, 0.f, 3.f, 0.f } },
+			{ "x = a * 2; y = bump(0); z = a * 2;", { 2.f, 2.f, 2.f, 4.f } },
+			{ "func f(u) { return bump(u); } x = a; y = f(0); z = a;", { 2.f, 1.f, 2.f, 2.f } },
+			{ atInvoked + "x = a; y = g(0); z = a;", { 2.f, 1.f, 2.f, 2.f } },
+		};
+		for (const impure_test& sTest : asImpure)
+			for (ts_backend eBackend : { ts_backend::interpreter, ts_backend::jit })
+			{
+				if ((eBackend == ts_backend::jit) && (!bJit)) continue;
+				ts_parser cTSP(sTest.atScript, asNativeVars, asNoBools, asNatives);
+				fA = 1.f, fX = fY = fZ = 0.f;
+				if ((cTSP.error().first == TS_OK) && (cTSP.set_backend(eBackend) == TS_OK))
+					cTSP.evaluate();
+				const float afResult[4] = { fA, fX, fY, fZ };
+				if ((cTSP.error().first != TS_OK) || (std::memcmp(afResult, sTest.afExpected, sizeof(afResult))))
+				{
+					std::cout << "failed : impure host function " << ((eBackend == ts_backend::jit) ? "(JIT) " : "") << sTest.atScript << "\n";
+					uFailed++;
+				}
+			}
+
+		// incremental evaluation of no changed input calls bump() and loads a again
+		ts_parser cIncremental("x = a; y = bump(0); z = a;", asNativeVars, asNoBools, asNatives);
+		fA = 1.f;
+		cIncremental.evaluate();
+		cIncremental.evaluate_changed({}, {});
+		if ((fA != 3.f) || (fX != 2.f) || (fZ != 3.f))
+		{
+			std::cout << "failed : impure host function, incremental\n";
+			uFailed++;
+		}
+
+		// on the thread pool, a is loaded before and after bump() among independent statements
+		std::string atWide = "x = a; y = bump(0);\n";
+		float afWide[16] = {};
+		for (unsigned uV = 0; uV < 16; uV++)
+		{
+			asNativeVars.insert({ "b" + std::to_string(uV), &afWide[uV] });
+			for (unsigned u = 0; u < 30; u++)
+				atWide += "b" + std::to_string(uV) + " = atan2(pow(b" + std::to_string(uV) + ", 0.5), 1.5);\n";
+		}
+		atWide += "z = a;";
+		ts_parser cPooled(atWide, asNativeVars, asNoBools, asNatives);
+		ts_thread_pool cPool(4);
+		bool bPooled = cPooled.program()->parallel();
+		for (unsigned u = 0; (u < 100) && (bPooled); u++)
+		{
+			fA = 1.f, fX = fY = fZ = 0.f;
+			cPooled.evaluate(cPool);
+			bPooled = (fA == 2.f) && (fX == 1.f) && (fZ == 2.f);
+		}
+		if (!bPooled)
+		{
+			std::cout << "failed : impure host function, thread pool\n";
+			uFailed++;
+		}
+	}
+
+	std::cout << "\n" << uFailed << " checks failed\n";
+	return (uFailed) ? 1 : 0;
 }
\ No newline at end of file
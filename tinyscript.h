@@ -73,8 +73,27 @@
 #define __TINYSCRIPT_PLUS_PLUS_H__
 
 #include "tinyexpr-plusplus/tinyexpr.h"
+#include <algorithm>
 #include <sstream>
+#include <istream>
+#include <ostream>
 #include <array>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <charconv>
+#include <unordered_map>
+#include <map>
+#include <limits>
+#include <bitset>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <utility>
 
 #define TS_OK 0
 #define TS_FAIL -1
@@ -125,1371 +144,7076 @@ public:
 };
 
 /// <summary>
-/// compile simple scripts using TinyExpr++
+/// native host function, called by scripts as "name(arguments)" directly from the compiled code (never by TinyExpr++) :
+/// pure functions of constant arguments are folded when compiled, impure ones are called on each evaluation in script order
+/// and may read or write the bound script variables through their context (not the rows of a batch)
+/// (functions evaluated on a thread pool are called concurrently)
 /// </summary>
-class ts_parser
+class ts_native
 {
 public:
-	/// <param name="atScript">the Script code</param>
-	/// <param name="asVars">the script variables</param>
-	/// <param name="asBools">the script booleans</param>
-	explicit ts_parser(std::string_view atCode, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools)
+	using name_type = std::string;
+	/// <summary>scalar call : the uArity argument values, the context pointer</summary>
+	using function_type = te_type(*)(const te_type* afArgs, void* pvContext);
+	/// <summary>batch call : uRows rows of the uArity argument columns to the result column, the context pointer</summary>
+	using batch_type = void(*)(const te_type* const* apfArgs, te_type* afResult, size_t uRows, void* pvContext);
+
+	/// <summary>maximum number of arguments</summary>
+	static constexpr unsigned uMaxArity = 8;
+
+	/// <summary>operator needed for std::set</summary>
+	[[nodiscard]]
+	bool
+		operator<(const ts_native& that) const
 	{
-		pasVars = std::make_shared<std::set<ts_variable>>(asVars);
-		pasBools = std::make_shared<std::set<ts_boolean>>(asBools);
+		return te_string_less{}(atName, that.atName);
+	}
 
-		// remove comments
-		atScript = {};
-		bool bSingleLine = false, bMultiLine = false;
-		for (size_t n = 0; n < atCode.size(); n++)
-		{
-			std::array<char, 2> at = { atCode[n], ((n + 1) < atCode.size()) ? atCode[n + 1] : ' ' };
+	/// <summary>
+	/// host function of plain te_type arguments (no context), called through a thunk it is inlined to :
+	/// ts_native::wrap<&my_function>("my_function")
+	/// </summary>
+	template<auto pfTyped>
+	static ts_native wrap(name_type atName, bool bPure = true)
+	{
+		return { std::move(atName), arity(pfTyped), &thunk<pfTyped>, nullptr, bPure, nullptr };
+	}
 
-			if (bSingleLine == true && at[0] == '\n')
-			{
-				// single line comment flag ?
-				bSingleLine = false;
-			}
-			else if (bMultiLine == true && at[0] == '*' && at[1] == '/')
-			{
-				// multiple line comment ? 
-				bMultiLine = false;
-				n++;
-			}
-			else if (bSingleLine || bMultiLine)
-			{
-				// is in comment
-				continue;
-			}
-			else if (at[0] == '/' && at[1] == '/')
-			{
-				// new comment
-				bSingleLine = true;
-				n++;
-			}
-			else if (at[0] == '/' && at[1] == '*')
+	/// <summary>The name as it would appear in a script.</summary>
+	name_type atName;
+	/// <summary>number of arguments (0..uMaxArity)</summary>
+	unsigned uArity = 0;
+	/// <summary>the function</summary>
+	function_type pfFunction = nullptr;
+	/// <summary>context pointer passed to each call (may be nullptr)</summary>
+	void* pvContext = nullptr;
+	/// <summary>true if the result only depends on the arguments and the call has no side effects</summary>
+	bool bPure = true;
+	/// <summary>batch variant evaluating whole lanes of rows with one call (optional)</summary>
+	batch_type pfBatch = nullptr;
+
+private:
+	template<typename... A>
+	static constexpr unsigned arity(te_type(*)(A...)) { return (unsigned)sizeof...(A); }
+
+	template<auto pfTyped, size_t... uIx>
+	static te_type call(const te_type* afArgs, std::index_sequence<uIx...>) { return pfTyped(afArgs[uIx]...); }
+
+	template<auto pfTyped>
+	static te_type thunk(const te_type* afArgs, void*) { return call<pfTyped>(afArgs, std::make_index_sequence<arity(pfTyped)>{}); }
+};
+
+/// <summary>operation codes of a compiled script</summary>
+enum struct ts_opcode : unsigned
+{
+	/// <summary>stop execution</summary>
+	op_end = 0,
+	/// <summary>r[a] = *var[b]</summary>
+	op_load_var,
+	/// <summary>r[a] = *bool[b] ? 1 : 0</summary>
+	op_load_bool,
+	/// <summary>*var[a] = r[b]</summary>
+	op_store_var,
+	/// <summary>*bool[a] = r[b] != 0</summary>
+	op_store_bool,
+	/// <summary>r[a] = r[b]</summary>
+	op_mov,
+	/// <summary>r[a] = -r[b]</summary>
+	op_neg,
+	/// <summary>r[a] = r[b] + r[c]</summary>
+	op_add,
+	/// <summary>r[a] = r[b] - r[c]</summary>
+	op_sub,
+	/// <summary>r[a] = r[b] * r[c]</summary>
+	op_mul,
+	/// <summary>r[a] = r[b] / r[c]</summary>
+	op_div,
+	/// <summary>r[a] = fmod(r[b], r[c])</summary>
+	op_mod,
+	/// <summary>r[a] = pow(r[b], r[c])</summary>
+	op_pow,
+	/// <summary>r[a] = sqrt(r[b])</summary>
+	op_sqrt,
+	/// <summary>r[a] = fabs(r[b])</summary>
+	op_abs,
+	/// <summary>r[a] = atan2(r[b], r[c])</summary>
+	op_atan2,
+	/// <summary>r[a] = builtin function c (r[b])</summary>
+	op_call,
+	/// <summary>r[a] = r[b] == r[c]</summary>
+	op_equal,
+	/// <summary>r[a] = r[b] != r[c]</summary>
+	op_unequal,
+	/// <summary>r[a] = r[b] > r[c]</summary>
+	op_greater,
+	/// <summary>r[a] = r[b] < r[c]</summary>
+	op_less,
+	/// <summary>r[a] = r[b] >= r[c]</summary>
+	op_greater_equal,
+	/// <summary>r[a] = r[b] <= r[c]</summary>
+	op_less_equal,
+	/// <summary>r[a] = r[b] != 0 && r[c] != 0</summary>
+	op_and,
+	/// <summary>r[a] = r[b] != 0 || r[c] != 0</summary>
+	op_or,
+	/// <summary>r[a] = TinyExpr++ expression b (fallback for expressions not compiled inline)</summary>
+	op_tinyexpr,
+	/// <summary>pc = b</summary>
+	op_jump,
+	/// <summary>if r[a] == 0 : pc = b</summary>
+	op_jump_false,
+	/// <summary>loop entry, iterations left r[a] = r[c], if not r[a] > 0 : pc = b (the loop end)</summary>
+	op_loop,
+	/// <summary>loop end, r[a] = r[a] - r[c], if r[a] > 0 : pc = b (back to the loop start)</summary>
+	op_next,
+	/// <summary>execute the function body at b up to its op_end, the body stores its result to *var[a]</summary>
+	op_invoke,
+	/// <summary>r[a] = host function c (argument registers of native call b)</summary>
+	op_native,
+};
+
+/// <summary>a single instruction of a compiled script</summary>
+struct ts_instruction
+{
+	/// <summary>the operation</summary>
+	ts_opcode eOp;
+	/// <summary>destination register or slot</summary>
+	unsigned uA;
+	/// <summary>first operand register, source register or jump target</summary>
+	unsigned uB;
+	/// <summary>second operand register or function index</summary>
+	unsigned uC;
+};
+
+/// <summary>TinyExpr++ builtin function compiled inline</summary>
+struct ts_builtin
+{
+	/// <summary>the name as it would appear in a formula</summary>
+	const char* atName;
+	/// <summary>number of arguments</summary>
+	unsigned uArity;
+	/// <summary>operation code used for this function</summary>
+	ts_opcode eOp;
+	/// <summary>function address (op_call functions)</summary>
+	te_type(*pfFunc)(te_type);
+};
+
+/// <summary>
+/// TinyExpr++ builtins TinyScript++ compiles to instructions,
+/// any other function is evaluated by TinyExpr++ itself
+/// </summary>
+inline const std::array<ts_builtin, 18>& ts_builtins()
+{
+	static const std::array<ts_builtin, 18> asBuiltins =
+	{ {
+		{ "abs", 1, ts_opcode::op_abs, [](te_type f) -> te_type { return std::fabs(f); } },
+		{ "acos", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::acos(f); } },
+		{ "asin", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::asin(f); } },
+		{ "atan", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::atan(f); } },
+		{ "atan2", 2, ts_opcode::op_atan2, nullptr },
+		{ "ceil", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::ceil(f); } },
+		{ "cos", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::cos(f); } },
+		{ "cosh", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::cosh(f); } },
+		{ "exp", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::exp(f); } },
+		{ "floor", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::floor(f); } },
+		{ "ln", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::log(f); } },
+		{ "log10", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::log10(f); } },
+		{ "pow", 2, ts_opcode::op_pow, nullptr },
+		{ "sin", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::sin(f); } },
+		{ "sinh", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::sinh(f); } },
+		{ "sqrt", 1, ts_opcode::op_sqrt, nullptr },
+		{ "tan", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::tan(f); } },
+		{ "tanh", 1, ts_opcode::op_call, [](te_type f) -> te_type { return std::tanh(f); } },
+	} };
+	return asBuiltins;
+}
+
+/// <summary>instruction set used by batch evaluation, the value is the lane width</summary>
+enum struct ts_simd : unsigned
+{
+	/// <summary>no SIMD, one lane at a time</summary>
+	scalar = 1,
+	/// <summary>SSE2, 4 lanes</summary>
+	sse = 4,
+	/// <summary>AVX2, 8 lanes</summary>
+	avx2 = 8,
+	/// <summary>AVX-512F, 16 lanes</summary>
+	avx512 = 16,
+	/// <summary>best instruction set supported by the CPU</summary>
+	automatic = ~0u
+};
+
+/// <summary>math mode of batch evaluation</summary>
+enum struct ts_math : unsigned
+{
+	/// <summary>results are bit identical to evaluate()</summary>
+	strict = 0,
+	/// <summary>
+	/// acos, asin and atan use SIMD polynomial approximations
+	/// (error against std:: in float : atan 3 ulp, asin 2 ulp, acos 2 ulp)
+	/// </summary>
+	fast
+};
+
+/// <summary>optimization of the compiled program</summary>
+enum struct ts_optimize : unsigned
+{
+	/// <summary>instructions as compiled, statement by statement</summary>
+	none = 0,
+	/// <summary>whole script : constant folding, common subexpressions, dead stores (results bit identical)</summary>
+	full
+};
+
+/// <summary>backend of evaluate()</summary>
+enum struct ts_backend : unsigned
+{
+	/// <summary>portable bytecode interpreter</summary>
+	interpreter = 0,
+	/// <summary>x86-64 machine code compiled per context (falls back to the interpreter elsewhere)</summary>
+	jit
+};
+
+// JIT backend (x86-64 with mmap or VirtualAlloc)
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(_WIN32) || defined(__unix__) || defined(__APPLE__))
+#define TS_JIT_X64
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#define TS_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef TS_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef TS_UNDEF_NOMINMAX
+#endif
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+// memory mapped program images (mmap or MapViewOfFile, read into memory elsewhere)
+#if defined(_WIN32)
+#define TS_MAPPED_WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#define TS_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef TS_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef TS_UNDEF_NOMINMAX
+#endif
+#elif defined(__unix__) || defined(__APPLE__)
+#define TS_MAPPED_POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+// SIMD batch kernels (x86 and float type only)
+#if defined(TE_FLOAT) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define TS_SIMD_X86
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// instruction set of a single function, every call within is inlined
+// (functions called by a flattened kernel but compiled for the default instruction set are not inlined)
+// TS_INLINE forces inlining of the compile time script nodes
+#if defined(__GNUC__) || defined(__clang__)
+#define TS_TARGET(atISA) __attribute__((target(atISA)))
+#define TS_FLATTEN __attribute__((flatten))
+#define TS_NOINLINE __attribute__((noinline))
+#define TS_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#define TS_TARGET(atISA)
+#define TS_FLATTEN
+#define TS_NOINLINE __declspec(noinline)
+#define TS_INLINE __forceinline
+#else
+#define TS_TARGET(atISA)
+#define TS_FLATTEN
+#define TS_NOINLINE
+#define TS_INLINE inline
+#endif
+
+/// <summary>
+/// lane operations without SIMD, all lane operations work on uWidth values at the given addresses
+/// (compare operations return 1 or 0, as the interpreter does)
+/// </summary>
+struct ts_lanes_scalar
+{
+	/// <summary>lanes per operation</summary>
+	static constexpr unsigned uWidth = 1;
+
+	static void add(te_type* a, const te_type* b, const te_type* c) { *a = *b + *c; }
+	static void sub(te_type* a, const te_type* b, const te_type* c) { *a = *b - *c; }
+	static void mul(te_type* a, const te_type* b, const te_type* c) { *a = *b * *c; }
+	static void div(te_type* a, const te_type* b, const te_type* c) { *a = *b / *c; }
+	static void neg(te_type* a, const te_type* b) { *a = -*b; }
+	static void abs(te_type* a, const te_type* b) { *a = std::fabs(*b); }
+	static void sqrt(te_type* a, const te_type* b) { *a = std::sqrt(*b); }
+	static void equal(te_type* a, const te_type* b, const te_type* c) { *a = (*b == *c) ? (te_type)1 : (te_type)0; }
+	static void unequal(te_type* a, const te_type* b, const te_type* c) { *a = (*b != *c) ? (te_type)1 : (te_type)0; }
+	static void greater(te_type* a, const te_type* b, const te_type* c) { *a = (*b > *c) ? (te_type)1 : (te_type)0; }
+	static void less(te_type* a, const te_type* b, const te_type* c) { *a = (*b < *c) ? (te_type)1 : (te_type)0; }
+	static void greater_equal(te_type* a, const te_type* b, const te_type* c) { *a = (*b >= *c) ? (te_type)1 : (te_type)0; }
+	static void less_equal(te_type* a, const te_type* b, const te_type* c) { *a = (*b <= *c) ? (te_type)1 : (te_type)0; }
+	static void logic_and(te_type* a, const te_type* b, const te_type* c) { *a = ((*b != (te_type)0) && (*c != (te_type)0)) ? (te_type)1 : (te_type)0; }
+	static void logic_or(te_type* a, const te_type* b, const te_type* c) { *a = ((*b != (te_type)0) || (*c != (te_type)0)) ? (te_type)1 : (te_type)0; }
+	/// <summary>a = (m != 0) ? b : c</summary>
+	static void select(te_type* a, const te_type* m, const te_type* b, const te_type* c) { *a = (*m != (te_type)0) ? *b : *c; }
+	/// <summary>a = magnitude of b with the sign of c</summary>
+	static void copy_sign(te_type* a, const te_type* b, const te_type* c) { *a = std::copysign(*b, *c); }
+	/// <summary>a = f</summary>
+	static void splat(te_type* a, te_type f) { *a = f; }
+	/// <summary>a = b for lanes with bit set in uBits</summary>
+	static void blend(te_type* a, const te_type* b, unsigned uBits) { if (uBits & 1) *a = *b; }
+	/// <summary>bit set for lanes equal zero</summary>
+	static unsigned zero_mask(const te_type* a) { return (*a == (te_type)0) ? 1 : 0; }
+};
+
+#ifdef TS_SIMD_X86
+
+/// <summary>SSE2 lane operations, 4 lanes</summary>
+struct ts_lanes_sse
+{
+	static constexpr unsigned uWidth = 4;
+
+	TS_TARGET("sse2") static void add(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(b), _mm_loadu_ps(c))); }
+	TS_TARGET("sse2") static void sub(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_sub_ps(_mm_loadu_ps(b), _mm_loadu_ps(c))); }
+	TS_TARGET("sse2") static void mul(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_mul_ps(_mm_loadu_ps(b), _mm_loadu_ps(c))); }
+	TS_TARGET("sse2") static void div(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_div_ps(_mm_loadu_ps(b), _mm_loadu_ps(c))); }
+	TS_TARGET("sse2") static void neg(float* a, const float* b) { _mm_storeu_ps(a, _mm_xor_ps(_mm_loadu_ps(b), _mm_set1_ps(-0.f))); }
+	TS_TARGET("sse2") static void abs(float* a, const float* b) { _mm_storeu_ps(a, _mm_andnot_ps(_mm_set1_ps(-0.f), _mm_loadu_ps(b))); }
+	TS_TARGET("sse2") static void sqrt(float* a, const float* b) { _mm_storeu_ps(a, _mm_sqrt_ps(_mm_loadu_ps(b))); }
+	TS_TARGET("sse2") static void equal(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_and_ps(_mm_cmpeq_ps(_mm_loadu_ps(b), _mm_loadu_ps(c)), _mm_set1_ps(1.f))); }
+	TS_TARGET("sse2") static void unequal(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(b), _mm_loadu_ps(c)), _mm_set1_ps(1.f))); }
+	TS_TARGET("sse2") static void greater(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(b), _mm_loadu_ps(c)), _mm_set1_ps(1.f))); }
+	TS_TARGET("sse2") static void less(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(b), _mm_loadu_ps(c)), _mm_set1_ps(1.f))); }
+	TS_TARGET("sse2") static void greater_equal(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(b), _mm_loadu_ps(c)), _mm_set1_ps(1.f))); }
+	TS_TARGET("sse2") static void less_equal(float* a, const float* b, const float* c) { _mm_storeu_ps(a, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(b), _mm_loadu_ps(c)), _mm_set1_ps(1.f))); }
+	TS_TARGET("sse2") static void logic_and(float* a, const float* b, const float* c)
+	{
+		__m128 m = _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(b), _mm_setzero_ps()), _mm_cmpneq_ps(_mm_loadu_ps(c), _mm_setzero_ps()));
+		_mm_storeu_ps(a, _mm_and_ps(m, _mm_set1_ps(1.f)));
+	}
+	TS_TARGET("sse2") static void logic_or(float* a, const float* b, const float* c)
+	{
+		__m128 m = _mm_or_ps(_mm_cmpneq_ps(_mm_loadu_ps(b), _mm_setzero_ps()), _mm_cmpneq_ps(_mm_loadu_ps(c), _mm_setzero_ps()));
+		_mm_storeu_ps(a, _mm_and_ps(m, _mm_set1_ps(1.f)));
+	}
+	TS_TARGET("sse2") static void select(float* a, const float* m, const float* b, const float* c)
+	{
+		__m128 sM = _mm_cmpneq_ps(_mm_loadu_ps(m), _mm_setzero_ps());
+		_mm_storeu_ps(a, _mm_or_ps(_mm_and_ps(sM, _mm_loadu_ps(b)), _mm_andnot_ps(sM, _mm_loadu_ps(c))));
+	}
+	TS_TARGET("sse2") static void copy_sign(float* a, const float* b, const float* c)
+	{
+		__m128 sS = _mm_set1_ps(-0.f);
+		_mm_storeu_ps(a, _mm_or_ps(_mm_andnot_ps(sS, _mm_loadu_ps(b)), _mm_and_ps(sS, _mm_loadu_ps(c))));
+	}
+	TS_TARGET("sse2") static void splat(float* a, float f) { _mm_storeu_ps(a, _mm_set1_ps(f)); }
+	TS_TARGET("sse2") static void blend(float* a, const float* b, unsigned uBits)
+	{
+		__m128i sBit = _mm_setr_epi32(1, 2, 4, 8);
+		__m128 sM = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)uBits), sBit), sBit));
+		_mm_storeu_ps(a, _mm_or_ps(_mm_and_ps(sM, _mm_loadu_ps(b)), _mm_andnot_ps(sM, _mm_loadu_ps(a))));
+	}
+	TS_TARGET("sse2") static unsigned zero_mask(const float* a) { return (unsigned)_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(a), _mm_setzero_ps())); }
+};
+
+/// <summary>AVX2 lane operations, 8 lanes</summary>
+struct ts_lanes_avx2
+{
+	static constexpr unsigned uWidth = 8;
+
+	TS_TARGET("avx2") static void add(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_add_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c))); }
+	TS_TARGET("avx2") static void sub(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_sub_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c))); }
+	TS_TARGET("avx2") static void mul(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_mul_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c))); }
+	TS_TARGET("avx2") static void div(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_div_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c))); }
+	TS_TARGET("avx2") static void neg(float* a, const float* b) { _mm256_storeu_ps(a, _mm256_xor_ps(_mm256_loadu_ps(b), _mm256_set1_ps(-0.f))); }
+	TS_TARGET("avx2") static void abs(float* a, const float* b) { _mm256_storeu_ps(a, _mm256_andnot_ps(_mm256_set1_ps(-0.f), _mm256_loadu_ps(b))); }
+	TS_TARGET("avx2") static void sqrt(float* a, const float* b) { _mm256_storeu_ps(a, _mm256_sqrt_ps(_mm256_loadu_ps(b))); }
+	TS_TARGET("avx2") static void equal(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c), _CMP_EQ_OQ), _mm256_set1_ps(1.f))); }
+	TS_TARGET("avx2") static void unequal(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c), _CMP_NEQ_UQ), _mm256_set1_ps(1.f))); }
+	TS_TARGET("avx2") static void greater(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c), _CMP_GT_OQ), _mm256_set1_ps(1.f))); }
+	TS_TARGET("avx2") static void less(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c), _CMP_LT_OQ), _mm256_set1_ps(1.f))); }
+	TS_TARGET("avx2") static void greater_equal(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c), _CMP_GE_OQ), _mm256_set1_ps(1.f))); }
+	TS_TARGET("avx2") static void less_equal(float* a, const float* b, const float* c) { _mm256_storeu_ps(a, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_loadu_ps(c), _CMP_LE_OQ), _mm256_set1_ps(1.f))); }
+	TS_TARGET("avx2") static void logic_and(float* a, const float* b, const float* c)
+	{
+		__m256 m = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_setzero_ps(), _CMP_NEQ_UQ), _mm256_cmp_ps(_mm256_loadu_ps(c), _mm256_setzero_ps(), _CMP_NEQ_UQ));
+		_mm256_storeu_ps(a, _mm256_and_ps(m, _mm256_set1_ps(1.f)));
+	}
+	TS_TARGET("avx2") static void logic_or(float* a, const float* b, const float* c)
+	{
+		__m256 m = _mm256_or_ps(_mm256_cmp_ps(_mm256_loadu_ps(b), _mm256_setzero_ps(), _CMP_NEQ_UQ), _mm256_cmp_ps(_mm256_loadu_ps(c), _mm256_setzero_ps(), _CMP_NEQ_UQ));
+		_mm256_storeu_ps(a, _mm256_and_ps(m, _mm256_set1_ps(1.f)));
+	}
+	TS_TARGET("avx2") static void select(float* a, const float* m, const float* b, const float* c)
+	{
+		__m256 sM = _mm256_cmp_ps(_mm256_loadu_ps(m), _mm256_setzero_ps(), _CMP_NEQ_UQ);
+		_mm256_storeu_ps(a, _mm256_blendv_ps(_mm256_loadu_ps(c), _mm256_loadu_ps(b), sM));
+	}
+	TS_TARGET("avx2") static void copy_sign(float* a, const float* b, const float* c)
+	{
+		__m256 sS = _mm256_set1_ps(-0.f);
+		_mm256_storeu_ps(a, _mm256_or_ps(_mm256_andnot_ps(sS, _mm256_loadu_ps(b)), _mm256_and_ps(sS, _mm256_loadu_ps(c))));
+	}
+	TS_TARGET("avx2") static void splat(float* a, float f) { _mm256_storeu_ps(a, _mm256_set1_ps(f)); }
+	TS_TARGET("avx2") static void blend(float* a, const float* b, unsigned uBits)
+	{
+		__m256i sBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		__m256 sM = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)uBits), sBit), sBit));
+		_mm256_storeu_ps(a, _mm256_blendv_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b), sM));
+	}
+	TS_TARGET("avx2") static unsigned zero_mask(const float* a) { return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a), _mm256_setzero_ps(), _CMP_EQ_OQ)); }
+};
+
+/// <summary>
+/// AVX-512F lane operations, 16 lanes
+/// (zero masking variants with all lanes set avoid _mm512_undefined_ps() of some GCC headers)
+/// </summary>
+struct ts_lanes_avx512
+{
+	static constexpr unsigned uWidth = 16;
+
+	TS_TARGET("avx512f") static void add(float* a, const float* b, const float* c) { _mm512_storeu_ps(a, _mm512_add_ps(_mm512_loadu_ps(b), _mm512_loadu_ps(c))); }
+	TS_TARGET("avx512f") static void sub(float* a, const float* b, const float* c) { _mm512_storeu_ps(a, _mm512_sub_ps(_mm512_loadu_ps(b), _mm512_loadu_ps(c))); }
+	TS_TARGET("avx512f") static void mul(float* a, const float* b, const float* c) { _mm512_storeu_ps(a, _mm512_mul_ps(_mm512_loadu_ps(b), _mm512_loadu_ps(c))); }
+	TS_TARGET("avx512f") static void div(float* a, const float* b, const float* c) { _mm512_storeu_ps(a, _mm512_div_ps(_mm512_loadu_ps(b), _mm512_loadu_ps(c))); }
+	TS_TARGET("avx512f") static void neg(float* a, const float* b)
+	{
+		_mm512_storeu_ps(a, _mm512_castsi512_ps(_mm512_maskz_xor_epi32(0xFFFF, _mm512_castps_si512(_mm512_loadu_ps(b)), _mm512_set1_epi32((int)0x80000000))));
+	}
+	TS_TARGET("avx512f") static void abs(float* a, const float* b)
+	{
+		_mm512_storeu_ps(a, _mm512_castsi512_ps(_mm512_maskz_and_epi32(0xFFFF, _mm512_castps_si512(_mm512_loadu_ps(b)), _mm512_set1_epi32(0x7FFFFFFF))));
+	}
+	TS_TARGET("avx512f") static void sqrt(float* a, const float* b) { _mm512_storeu_ps(a, _mm512_maskz_sqrt_ps(0xFFFF, _mm512_loadu_ps(b))); }
+	TS_TARGET("avx512f") static void equal(float* a, const float* b, const float* c) { one(a, _mm512_cmp_ps_mask(_mm512_loadu_ps(b), _mm512_loadu_ps(c), _CMP_EQ_OQ)); }
+	TS_TARGET("avx512f") static void unequal(float* a, const float* b, const float* c) { one(a, _mm512_cmp_ps_mask(_mm512_loadu_ps(b), _mm512_loadu_ps(c), _CMP_NEQ_UQ)); }
+	TS_TARGET("avx512f") static void greater(float* a, const float* b, const float* c) { one(a, _mm512_cmp_ps_mask(_mm512_loadu_ps(b), _mm512_loadu_ps(c), _CMP_GT_OQ)); }
+	TS_TARGET("avx512f") static void less(float* a, const float* b, const float* c) { one(a, _mm512_cmp_ps_mask(_mm512_loadu_ps(b), _mm512_loadu_ps(c), _CMP_LT_OQ)); }
+	TS_TARGET("avx512f") static void greater_equal(float* a, const float* b, const float* c) { one(a, _mm512_cmp_ps_mask(_mm512_loadu_ps(b), _mm512_loadu_ps(c), _CMP_GE_OQ)); }
+	TS_TARGET("avx512f") static void less_equal(float* a, const float* b, const float* c) { one(a, _mm512_cmp_ps_mask(_mm512_loadu_ps(b), _mm512_loadu_ps(c), _CMP_LE_OQ)); }
+	TS_TARGET("avx512f") static void logic_and(float* a, const float* b, const float* c) { one(a, nonzero(b) & nonzero(c)); }
+	TS_TARGET("avx512f") static void logic_or(float* a, const float* b, const float* c) { one(a, nonzero(b) | nonzero(c)); }
+	TS_TARGET("avx512f") static void select(float* a, const float* m, const float* b, const float* c)
+	{
+		_mm512_storeu_ps(a, _mm512_mask_mov_ps(_mm512_loadu_ps(c), nonzero(m), _mm512_loadu_ps(b)));
+	}
+	TS_TARGET("avx512f") static void copy_sign(float* a, const float* b, const float* c)
+	{
+		__m512i sS = _mm512_set1_epi32((int)0x80000000);
+		__m512i sB = _mm512_maskz_andnot_epi32(0xFFFF, sS, _mm512_castps_si512(_mm512_loadu_ps(b)));
+		_mm512_storeu_ps(a, _mm512_castsi512_ps(_mm512_maskz_or_epi32(0xFFFF, sB, _mm512_maskz_and_epi32(0xFFFF, sS, _mm512_castps_si512(_mm512_loadu_ps(c))))));
+	}
+	TS_TARGET("avx512f") static void splat(float* a, float f) { _mm512_storeu_ps(a, _mm512_set1_ps(f)); }
+	TS_TARGET("avx512f") static void blend(float* a, const float* b, unsigned uBits) { _mm512_mask_storeu_ps(a, (__mmask16)uBits, _mm512_loadu_ps(b)); }
+	TS_TARGET("avx512f") static unsigned zero_mask(const float* a) { return (unsigned)_mm512_cmp_ps_mask(_mm512_loadu_ps(a), _mm512_setzero_ps(), _CMP_EQ_OQ); }
+
+private:
+	/// <summary>a = 1 for lanes set in the mask, 0 otherwise</summary>
+	TS_TARGET("avx512f") static void one(float* a, __mmask16 uM) { _mm512_storeu_ps(a, _mm512_maskz_mov_ps(uM, _mm512_set1_ps(1.f))); }
+	/// <summary>mask of lanes not equal zero</summary>
+	TS_TARGET("avx512f") static __mmask16 nonzero(const float* a) { return _mm512_cmp_ps_mask(_mm512_loadu_ps(a), _mm512_setzero_ps(), _CMP_NEQ_UQ); }
+};
+
+/// <summary>best instruction set supported by this CPU and operating system</summary>
+inline ts_simd ts_simd_supported()
+{
+	static const ts_simd eSupported = []()
+		{
+#if defined(_MSC_VER)
+			int anInfo[4] = {};
+			__cpuid(anInfo, 0);
+			int nMax = anInfo[0];
+			__cpuid(anInfo, 1);
+			bool bXSave = (anInfo[2] & (1 << 27)) != 0, bAVX = (anInfo[2] & (1 << 28)) != 0;
+			unsigned long long uXCR0 = (bXSave) ? _xgetbv(0) : 0;
+			if ((nMax >= 7) && bAVX && ((uXCR0 & 0x6) == 0x6))
 			{
-				// new comment
-				bMultiLine = true;
-				n++;
+				__cpuidex(anInfo, 7, 0);
+				if ((anInfo[1] & (1 << 16)) && ((uXCR0 & 0xE6) == 0xE6)) return ts_simd::avx512;
+				if (anInfo[1] & (1 << 5)) return ts_simd::avx2;
 			}
-			else
-				atScript += at[0];
-		}
+			return ts_simd::sse;
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f")) return ts_simd::avx512;
+			if (__builtin_cpu_supports("avx2")) return ts_simd::avx2;
+			if (__builtin_cpu_supports("sse2")) return ts_simd::sse;
+			return ts_simd::scalar;
+#endif
+		}();
+	return eSupported;
+}
 
-		// cleanup the script
-		atScript.erase(std::remove(atScript.begin(), atScript.end(), '\r'), atScript.end());
-		atScript.erase(std::remove(atScript.begin(), atScript.end(), '\n'), atScript.end());
-		atScript.erase(std::remove(atScript.begin(), atScript.end(), '\t'), atScript.end());
-		atScript.erase(std::remove(atScript.begin(), atScript.end(), '\v'), atScript.end());
-		atScript.erase(std::remove(atScript.begin(), atScript.end(), '\f'), atScript.end());
-		atScript.erase(std::remove(atScript.begin(), atScript.end(), '\0'), atScript.end());
+#else
 
-		// add separator after curly close brace to ensure statement split
-		size_t uFind = 0;
-		while ((uFind = atScript.find("}", uFind)) != std::string::npos) atScript.insert(++uFind, 1, ';');
+/// <summary>best instruction set supported by this CPU and operating system</summary>
+inline ts_simd ts_simd_supported() { return ts_simd::scalar; }
 
-		// split the statements
-		std::stringstream atS(atScript);
-		std::string atStatement;
-		std::vector<std::string> aatSme;
-		while (std::getline(atS, atStatement, ';'))
-			aatSme.push_back(atStatement);
+#endif
 
-		// split the statements again by curly braces
-		std::vector<std::string> aatSmeSplit;
-		for (std::string& at : aatSme)
+/// <summary>
+/// polynomial approximations of some builtins using lane operations
+/// (Cephes single precision kernels, branches replaced by selects)
+/// </summary>
+template<class V> struct ts_lanes_fast_math
+{
+	/// <summary>a = c[0] * z^(n-1) + ... + c[n-1]</summary>
+	template<size_t N> static void horner(te_type* a, const te_type* z, const std::array<te_type, N>& afC)
+	{
+		alignas(64) te_type afK[V::uWidth];
+		V::splat(a, afC[0]);
+		for (size_t uIx = 1; uIx < N; uIx++)
 		{
-			// remove spaces at start and end
-			while ((at.size()) && (at.front() == ' '))
-				at.erase(at.begin());
-			while ((at.size()) && (at.back() == ' '))
-				at.erase(at.end() - 1);
+			V::mul(a, a, z);
+			V::splat(afK, afC[uIx]);
+			V::add(a, a, afK);
+		}
+	}
 
-			// skip empty
-			if (!at.size()) continue;
+	/// <summary>a = atan(x)</summary>
+	static void atan(te_type* a, const te_type* x)
+	{
+		constexpr unsigned W = V::uWidth;
+		alignas(64) te_type afAx[W], afK[W], afBig[W], afMid[W], afT[W], afU[W], afR[W], afY[W], afZ[W];
+		V::abs(afAx, x);
+		V::splat(afK, (te_type)2.414213562373095); V::greater(afBig, afAx, afK);
+		V::splat(afK, (te_type)0.4142135623730950); V::greater(afMid, afAx, afK);
 
-			// add curly braces for one line "if" statements to split them later
-			if (at.substr(0, 2) == "if")
-			{
-				std::size_t uLast = at.find_last_of(')');
-				if (at.substr(uLast + 1).size())
-				{
-					if (at.find('{') == std::string::npos)
-					{
-						at.insert(uLast + 1, 1, '{');
-						if (at.find('}') == std::string::npos)
-							at.insert(at.size(), 1, '}');
-					}
-				}
-			}
+		// reduce : -1/x above tan(3pi/8), (x-1)/(x+1) above tan(pi/8)
+		V::splat(afK, (te_type)-1); V::div(afT, afK, afAx);
+		V::splat(afK, (te_type)1); V::sub(afU, afAx, afK); V::add(afR, afAx, afK); V::div(afU, afU, afR);
+		V::select(afR, afMid, afU, afAx);
+		V::select(afR, afBig, afT, afR);
+		V::splat(afT, (te_type)0); V::splat(afU, (te_type)0.78539816339744831); V::select(afY, afMid, afU, afT);
+		V::splat(afU, (te_type)1.5707963267948966); V::select(afY, afBig, afU, afY);
+
+		// y += ((((c0 z + c1) z + c2) z + c3) z) x + x
+		V::mul(afZ, afR, afR);
+		horner(afT, afZ, std::array<te_type, 4>{ (te_type)8.05374449538e-2, (te_type)-1.38776856032e-1, (te_type)1.99777106478e-1, (te_type)-3.33329491539e-1 });
+		V::mul(afT, afT, afZ); V::mul(afT, afT, afR); V::add(afT, afT, afR);
+		V::add(afY, afY, afT);
+		V::copy_sign(a, afY, x);
+	}
 
-			// search for braces and sort indices
-			uFind = 0;
-			std::vector<size_t> auFound;
-			while ((uFind = at.find("{", uFind)) != std::string::npos) auFound.push_back(uFind++);
-			uFind = 0;
-			while ((uFind = at.find("}", uFind)) != std::string::npos) auFound.push_back(uFind++);
-			sort(auFound.begin(), auFound.end());
+	/// <summary>a = asin(x)</summary>
+	static void asin(te_type* a, const te_type* x)
+	{
+		constexpr unsigned W = V::uWidth;
+		alignas(64) te_type afAx[W], afK[W], afBig[W], afT[W], afZ[W], afR[W];
+		V::abs(afAx, x);
+		V::splat(afK, (te_type)0.5); V::greater(afBig, afAx, afK);
 
-			// split by found
-			uFind = 0;
-			for (size_t uF : auFound)
-			{
-				// add string to delimiter, delimiter string separately
-				if (uFind < uF)
-					aatSmeSplit.push_back(at.substr(uFind, uF - uFind));
-				aatSmeSplit.push_back(at.substr(uF, 1));
-				uFind = uF + 1;
-			}
-			if (uFind < at.size()) aatSmeSplit.push_back(at.substr(uFind, at.size() - uFind));
+		// reduce above 0.5 : z = (1 - x) / 2, x = sqrt(z)
+		V::splat(afK, (te_type)1); V::sub(afT, afK, afAx);
+		V::splat(afK, (te_type)0.5); V::mul(afT, afT, afK);
+		V::sqrt(afR, afT);
+		V::mul(afZ, afAx, afAx);
+		V::select(afZ, afBig, afT, afZ);
+		V::select(afR, afBig, afR, afAx);
+
+		// p = ((((c0 z + c1) z + c2) z + c3) z + c4) z x + x
+		horner(afT, afZ, std::array<te_type, 5>{ (te_type)4.2163199048e-2, (te_type)2.4181311049e-2, (te_type)4.5470025998e-2, (te_type)7.4953002686e-2, (te_type)1.6666752422e-1 });
+		V::mul(afT, afT, afZ); V::mul(afT, afT, afR); V::add(afT, afT, afR);
+
+		// above 0.5 : pi/2 - 2p
+		V::add(afR, afT, afT);
+		V::splat(afK, (te_type)1.5707963267948966); V::sub(afR, afK, afR);
+		V::select(afT, afBig, afR, afT);
+		V::copy_sign(a, afT, x);
+	}
+
+	/// <summary>a = acos(x)</summary>
+	static void acos(te_type* a, const te_type* x)
+	{
+		constexpr unsigned W = V::uWidth;
+		alignas(64) te_type afK[W], afLow[W], afHigh[W], afT[W], afS[W], afR[W];
+		V::splat(afK, (te_type)-0.5); V::less(afLow, x, afK);
+		V::splat(afK, (te_type)0.5); V::greater(afHigh, x, afK);
+
+		// |x| above 0.5 : s = 2 asin(sqrt((1 - |x|) / 2))
+		V::abs(afT, x);
+		V::splat(afK, (te_type)1); V::sub(afT, afK, afT);
+		V::splat(afK, (te_type)0.5); V::mul(afT, afT, afK);
+		V::sqrt(afT, afT);
+		asin(afS, afT);
+		V::add(afS, afS, afS);
+
+		// x above 0.5 : s, x below -0.5 : pi - s, otherwise pi/2 - asin(x)
+		asin(afR, x);
+		V::splat(afK, (te_type)1.5707963267948966); V::sub(afR, afK, afR);
+		V::splat(afK, (te_type)3.14159265358979323846); V::sub(afT, afK, afS);
+		V::select(afR, afLow, afT, afR);
+		V::select(a, afHigh, afS, afR);
+	}
+};
+
+/// <summary>
+/// worker threads for parallel batch evaluation
+/// (the calling thread is worker 0, one job runs at a time)
+/// </summary>
+class ts_thread_pool
+{
+public:
+	/// <param name="uThreads">number of workers including the calling thread</param>
+	explicit ts_thread_pool(unsigned uThreads = std::thread::hardware_concurrency())
+	{
+		if (uThreads == 0) uThreads = 1;
+		for (unsigned uIx = 1; uIx < uThreads; uIx++)
+			acThreads.emplace_back([this, uIx]() { work(uIx); });
+	}
+	ts_thread_pool(const ts_thread_pool&) = delete;
+	ts_thread_pool& operator=(const ts_thread_pool&) = delete;
+	~ts_thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> cLock(cMutex);
+			bStop = true;
 		}
+		cStart.notify_all();
+		for (std::thread& c : acThreads) c.join();
+	}
 
-		// set level flags vector size to 1
-		aeFlags.resize(1);
+	/// <summary>number of workers including the calling thread</summary>
+	unsigned size() const { return (unsigned)acThreads.size() + 1; }
 
-		// loop through statements and compile them
-		for (std::string& at : aatSmeSplit)
+	/// <summary>run the job on all workers, returns when all workers are done</summary>
+	/// <param name="fnJob">the job, called with the worker index</param>
+	void run(const std::function<void(unsigned)>& fnJob)
+	{
+		std::lock_guard<std::mutex> cRunLock(cRun);
 		{
-			if (at == "{")
-				block_level_up();
-			else if (at == "}")
+			std::lock_guard<std::mutex> cLock(cMutex);
+			pfnJob = &fnJob;
+			uBusy = (unsigned)acThreads.size();
+			uGeneration++;
+		}
+		cStart.notify_all();
+		fnJob(0);
+
+		std::unique_lock<std::mutex> cLock(cMutex);
+		cDone.wait(cLock, [this]() { return uBusy == 0; });
+		pfnJob = nullptr;
+	}
+
+private:
+	/// <summary>worker thread loop</summary>
+	void work(unsigned uIx)
+	{
+		uint64_t uSeen = 0;
+		for (;;)
+		{
+			const std::function<void(unsigned)>* pfn = nullptr;
 			{
-				if (uBlockLevel > 0)
-					block_level_down();
-				else
-				{
-					nErr = TS_FAIL;
-					return;
-				}
+				std::unique_lock<std::mutex> cLock(cMutex);
+				cStart.wait(cLock, [this, uSeen]() { return bStop || (uGeneration != uSeen); });
+				if (bStop) return;
+				uSeen = uGeneration;
+				pfn = pfnJob;
 			}
-			else
+			(*pfn)(uIx);
 			{
-				// compile statements and add to script vector
-				apsStatements_compiled.push_back(std::make_shared<ts_statement>(ts_statement(at, pasVars, pasBools, uBlockLevel)));
-				auto nE = apsStatements_compiled.back()->error();
-				if (nE)
-				{
-					nErr = nE;
-					apsStatements_compiled.clear();
-					return;
-				}
+				std::lock_guard<std::mutex> cLock(cMutex);
+				if (--uBusy == 0) cDone.notify_one();
 			}
 		}
+	}
+
+	/// <summary>the worker threads (worker 1..n)</summary>
+	std::vector<std::thread> acThreads;
+	/// <summary>guards the job state</summary>
+	std::mutex cMutex;
+	/// <summary>one job at a time</summary>
+	std::mutex cRun;
+	/// <summary>signals a new job or stop</summary>
+	std::condition_variable cStart;
+	/// <summary>signals all workers done</summary>
+	std::condition_variable cDone;
+	/// <summary>the current job</summary>
+	const std::function<void(unsigned)>* pfnJob = nullptr;
+	/// <summary>job counter</summary>
+	uint64_t uGeneration = 0;
+	/// <summary>worker threads still running the current job</summary>
+	unsigned uBusy = 0;
+	/// <summary>exit the worker threads</summary>
+	bool bStop = false;
+};
+
+class ts_context;
+
+/// <summary>
+/// script code read in chunks while compiling (a string, a stream or a callback),
+/// the compiler keeps the current chunk and statement only
+/// </summary>
+class ts_source
+{
+public:
+	/// <summary>chunk reader : fills the buffer, returns the number of characters read, 0 at the end</summary>
+	using reader = std::function<size_t(char*, size_t)>;
 
-		// block level back to zero ?
-		if (uBlockLevel != 0) nErr = TS_FAIL;
+	/// <param name="_atCode">the whole script (one chunk, not copied)</param>
+	explicit ts_source(std::string_view _atCode) : atCode(_atCode) {}
+	/// <param name="cStream">the stream, read to its end</param>
+	explicit ts_source(std::istream& cStream)
+		: fnRead([&cStream](char* pc, size_t uSize) { cStream.read(pc, (std::streamsize)uSize); return (size_t)cStream.gcount(); })
+	{
 	}
+	/// <param name="_fnRead">the chunk reader</param>
+	explicit ts_source(reader _fnRead) : fnRead(std::move(_fnRead)) {}
 
-	/// <summary>evaluate script based on current variable values</summary>
-	void evaluate()
+	/// <summary>the next chunk, empty at the end (valid until the next call)</summary>
+	std::string_view next()
 	{
-		if (!nErr)
+		if (!fnRead)
 		{
-			// delete all flags and set level to zero
-			for (uBlockLevel = 0; uBlockLevel < (unsigned)aeFlags.size(); uBlockLevel++)
-				aeFlags[uBlockLevel] = ts_runtime_flags::none;
-			uBlockLevel = 0;
+			std::string_view at = atCode;
+			atCode = {};
+			return at;
+		}
+		acBuffer.resize(uChunk);
+		return std::string_view(acBuffer.data(), std::min(fnRead(acBuffer.data(), uChunk), uChunk));
+	}
 
-			for (auto& s : apsStatements_compiled)
-			{
-				// get statement block level
-				unsigned uLevelThis = s->level();
+private:
+	/// <summary>size of a chunk read by the reader</summary>
+	static constexpr size_t uChunk = 1 << 16;
 
-				// skip if false flag and level higher
-				if ((uLevelThis > uBlockLevel) && ((unsigned)aeFlags[uBlockLevel] & (unsigned)ts_runtime_flags::if_false))
-					continue;
+	/// <summary>the script if given as a whole</summary>
+	std::string_view atCode;
+	/// <summary>the chunk reader, empty if given as a whole</summary>
+	reader fnRead;
+	/// <summary>the current chunk of the reader</summary>
+	std::vector<char> acBuffer;
+};
 
-				// delete all higher flags if smaller level
-				if (uLevelThis < uBlockLevel)
-				{
-					for (; uBlockLevel > uLevelThis; uBlockLevel--)
-						aeFlags[uBlockLevel] = ts_runtime_flags::none;
-				}
+/// <summary>compiled program image as written by ts_program::write() (a view, for example of a ts_mapped_file)</summary>
+struct ts_image
+{
+	/// <summary>the image bytes</summary>
+	std::string_view atData;
+};
 
-				// set new block level and process
-				uBlockLevel = uLevelThis;
-				switch (s->type())
-				{
-				case ts_parser::ts_types::sm_expr_float:
-				case ts_parser::ts_types::sm_expr_bool:
-					s->evaluate();
-					aeFlags[uBlockLevel] = ts_runtime_flags::none;
-					break;
-				case ts_parser::ts_types::sm_if:
-					s->evaluate();
-					aeFlags[uBlockLevel] = s->boolean() ? ts_runtime_flags::if_true : ts_runtime_flags::if_false;
-					break;
-				case ts_parser::ts_types::sm_if_else:
-					break;
-				case ts_parser::ts_types::sm_undefined:
-				default:
-					return;
-				}
+/// <summary>read only file mapped to memory (read into memory where mapping is not supported)</summary>
+class ts_mapped_file
+{
+public:
+	/// <param name="atPath">the file</param>
+	explicit ts_mapped_file(const std::string& atPath)
+	{
+#if defined(TS_MAPPED_WIN32)
+		hFile = CreateFileA(atPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER sSize = {};
+		if ((hFile == INVALID_HANDLE_VALUE) || (!GetFileSizeEx(hFile, &sSize))) return;
+		bOpen = true;
+		uSize = (size_t)sSize.QuadPart;
+		if (uSize == 0) return;
+		hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (hMapping) pcData = (const char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!pcData) bOpen = false, uSize = 0;
+#elif defined(TS_MAPPED_POSIX)
+		int nFile = open(atPath.c_str(), O_RDONLY);
+		struct stat sStat = {};
+		if (nFile < 0) return;
+		if (fstat(nFile, &sStat) == 0)
+		{
+			bOpen = true;
+			uSize = (size_t)sStat.st_size;
+			if (uSize)
+			{
+				void* p = mmap(nullptr, uSize, PROT_READ, MAP_PRIVATE, nFile, 0);
+				if (p != MAP_FAILED) pcData = (const char*)p;
+				else bOpen = false, uSize = 0;
 			}
 		}
+		close(nFile);
+#else
+		std::ifstream cFile(atPath, std::ios::binary);
+		if (!cFile) return;
+		acBuffer.assign(std::istreambuf_iterator<char>(cFile), std::istreambuf_iterator<char>());
+		bOpen = true;
+		pcData = acBuffer.data();
+		uSize = acBuffer.size();
+#endif
 	}
-
-	/// <summary>returns error message and position</summary>
-	std::pair<int64_t, uint32_t> error()
+	ts_mapped_file(const ts_mapped_file&) = delete;
+	ts_mapped_file& operator=(const ts_mapped_file&) = delete;
+	~ts_mapped_file()
 	{
-		return std::make_pair(nErr, (uErrLine << 16) + (uErrMark & 0xFFFF));
+#if defined(TS_MAPPED_WIN32)
+		if (pcData) UnmapViewOfFile(pcData);
+		if (hMapping) CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#elif defined(TS_MAPPED_POSIX)
+		if (pcData) munmap((void*)pcData, uSize);
+#endif
 	}
 
+	/// <summary>true if the file was opened and mapped</summary>
+	bool is_open() const { return bOpen; }
+	/// <summary>the file contents as program image</summary>
+	ts_image image() const { return { std::string_view(pcData, uSize) }; }
+
 private:
+	/// <summary>true if the file was opened and mapped</summary>
+	bool bOpen = false;
+	/// <summary>the mapped contents</summary>
+	const char* pcData = nullptr;
+	/// <summary>size of the file</summary>
+	size_t uSize = 0;
+#if defined(TS_MAPPED_WIN32)
+	/// <summary>file and mapping handles</summary>
+	HANDLE hFile = INVALID_HANDLE_VALUE, hMapping = nullptr;
+#elif !defined(TS_MAPPED_POSIX)
+	/// <summary>the contents read</summary>
+	std::vector<char> acBuffer;
+#endif
+};
 
-	/// <summary>possible statement types</summary>
-	enum struct ts_types : unsigned
-	{
-		sm_undefined = 0,
-		sm_expr_float,
-		sm_expr_bool,
-		sm_if,
-		sm_if_else
-	};
+/// <summary>
+/// compiled script, immutable once constructed
+/// (shared as pointer to const by any number of ts_context instances)
+/// </summary>
+class ts_program
+{
+	friend class ts_context;
 
-	/// <summary>flags used during evaluation process</summary>
-	enum struct ts_runtime_flags : unsigned
+public:
+	/// <param name="atScript">the Script code</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_program(std::string_view atCode, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, ts_optimize eOptimize = ts_optimize::full)
+		: ts_program(ts_source(atCode), asVars, asBools, {}, eOptimize)
 	{
-		none = 0b00000000,
-		if_true = 0b00000001,
-		if_false = 0b00000010,
-	};
+	}
 
-	/// <summary>state in the current statement compilation process</summary>
-	struct state
-	{
-		/// <param name="_atStatement">the statement string</param>
-		/// <param name="_pasVars">shared pointer to the script variables</param>
-		/// <param name="_pasBools">shared pointer to the script booleans</param>
-		explicit state(std::string& _atStatement,
-			std::shared_ptr<std::set<ts_variable>> _pasVars,
-			std::shared_ptr<std::set<ts_boolean>> _pasBools
-		)
-			: atStatement(_atStatement)
-			, pasVars(_pasVars)
-			, pasBools(_pasBools)
-		{
-		}
-
-		/// <summary>possible comparisation tokens</summary>
-		enum struct token_compare_type : unsigned
-		{
-			TOK_EQUAL = 1,
-			TOK_UNEQUAL,
-			TOK_GREATER,
-			TOK_LESS,
-			TOK_GREATER_EQUAL,
-			TOK_LESS_EQUAL,
-			TOK_AND,
-			TOK_OR
-		};
+	/// <param name="atScript">the Script code</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="asNatives">the host functions the script calls</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_program(std::string_view atCode, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, const std::set<ts_native>& asNatives,
+		ts_optimize eOptimize = ts_optimize::full)
+		: ts_program(ts_source(atCode), asVars, asBools, asNatives, eOptimize)
+	{
+	}
 
-		/// <summary>possible token type enumeration</summary>
-		enum struct token_type : unsigned
-		{
-			TOK_NULL = 0,
-			TOK_EQUAL = (unsigned)token_compare_type::TOK_EQUAL,
-			TOK_UNEQUAL = (unsigned)token_compare_type::TOK_UNEQUAL,
-			TOK_GREATER = (unsigned)token_compare_type::TOK_GREATER,
-			TOK_LESS = (unsigned)token_compare_type::TOK_LESS,
-			TOK_GREATER_EQUAL = (unsigned)token_compare_type::TOK_GREATER_EQUAL,
-			TOK_LESS_EQUAL = (unsigned)token_compare_type::TOK_LESS_EQUAL,
-			TOK_AND = (unsigned)token_compare_type::TOK_AND,
-			TOK_OR = (unsigned)token_compare_type::TOK_OR,
-			TOK_ERROR,
-			TOK_END,
-			TOK_OPEN,
-			TOK_CLOSE,
-			TOK_OPEN_CURLY,
-			TOK_CLOSE_CURLY,
-			TOK_NUMBER,
-			TOK_IF,
-			TOK_ELSE,
-			TOK_VAR_FLOAT,
-			TOK_VAR_BOOL,
-			TOK_ASSIGN,
-			TOK_TRUE,
-			TOK_FALSE
-		};
+	/// <param name="cSource">the Script code, compiled while read</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_program(ts_source cSource, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, ts_optimize eOptimize = ts_optimize::full)
+		: ts_program(std::move(cSource), asVars, asBools, {}, eOptimize)
+	{
+	}
 
-		/// <summary>get the next token in current statement stream</summary>
-		void next_token()
+	/// <param name="cSource">the Script code, compiled while read</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="asNatives">the host functions the script calls</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_program(ts_source cSource, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, const std::set<ts_native>& asNatives,
+		ts_optimize eOptimize = ts_optimize::full)
+	{
+		// resolve the variable sets once to a flat symbol table, script locals are added while compiled
+		std::shared_ptr<symbol_table> psTable = std::make_shared<symbol_table>(asVars, asBools, asNatives);
+		psSymbols = psTable;
+		if (!valid(asNatives))
 		{
-			eType = token_type::TOK_NULL;
-
-			do
-			{
-				// end of expression
-				if (uNext >= atStatement.size())
-				{
-					eType = token_type::TOK_END;
-					return;
-				}
-
-				// Try reading a number
-				if ((peek() >= '0' && peek() <= '9') || peek() == '.')
-				{
-					pop_number();
-				}
-				else
-				{
-					// Look for a variable or builtin function call.
-					if (isalpha(peek()))
-					{
-						pop_vocable();
-					}
-					else
-					{
-						// Look for operator or special.. otherwise move forward or throw error
-						pop_operator();
-					}
-				}
-			} while (eType == token_type::TOK_NULL);
+			nErr = TS_FAIL;
+			return;
 		}
-		/// <summary>get current token type</summary>
-		token_type get_type() { return eType; }
-		/// <summary>get remaining statement string</summary>
-		std::string remaining() { return atStatement.substr(uNext); }
-		/// <summary>get the value unsigned (usually an index)</summary>
-		unsigned value_unsigned() { return std::get<unsigned>(sValue); }
-		/// <summary>get the value floating</summary>
-		te_type value_floating() { return std::get<te_type>(sValue); }
 
-	private:
-		/// <summary>peek next character in expression</summary>
-		char peek() { if (uNext < atStatement.size()) return atStatement[uNext]; else return 0; }
-		/// <summary>pop next character in expression</summary>
-		char pop() { if (uNext++ < atStatement.size()) return atStatement[uNext - 1]; else return 0; }
-		/// <summary>pop next number in expression</summary>
-		void pop_number() 
-		{ 
-			size_t uIx = 0; 
-#ifdef TE_FLOAT
-			te_type fRet = std::stof(atStatement.substr(uNext), &uIx);
-#else
-			te_type fRet = std::stod(atStatement.substr(uNext), &uIx);
-#endif
-			uNext += uIx; sValue = (te_type)fRet; 
-			eType = token_type::TOK_NUMBER; 
-		}
-		/// <summary>pop next vocable</summary>
-		void pop_vocable()
+		// loop through statements and compile them
+		script_lexer cLexer(cSource);
+		script_lexer::piece_type eType;
+		std::string_view at;
+		std::vector<open_if> asOpenIfs;
+		bool bEnded = false;
+		bool bDefining = false, bBody = false;
+		std::string atFunction;
+		symbol_table::function sFunction;
+		while (cLexer.next(eType, at))
 		{
-			std::string at = {};
-			while (isalpha(peek()) || isdigit(peek()) || (peek() == '_')) at.push_back(pop());
-
-			int nIx = find_vars(at);
-			if (nIx < 0)
+			// a function definition, the body statements kept until its block ends
+			if (bDefining)
 			{
-				nIx = find_bools(at);
-				if (nIx < 0)
+				if ((eType == script_lexer::piece_type::block_begin) && (!bBody))
+					bBody = true;
+				else if ((eType == script_lexer::piece_type::statement) && (bBody))
+					sFunction.atBody.emplace_back(at);
+				else if ((eType == script_lexer::piece_type::block_end) && (bBody))
 				{
-					if (at == "if")
-						eType = token_type::TOK_IF;
-					else if (at == "else")
-						eType = token_type::TOK_ELSE;
-					else if (at == "true")
-						eType = token_type::TOK_TRUE;
-					else if (at == "false")
-						eType = token_type::TOK_FALSE;
-					else
-					{
-						eType = token_type::TOK_ERROR;
-						return;
-					}
+					bDefining = false;
+					nErr = define_function(atFunction, std::move(sFunction), psTable);
 				}
 				else
+					nErr = TS_FAIL;
+				if (nErr)
 				{
-					sValue = (unsigned)nIx;
-					eType = token_type::TOK_VAR_BOOL;
+					sCode = bytecode();
+					return;
 				}
+				bEnded = false;
+				continue;
 			}
-			else
-			{
-				sValue = (unsigned)nIx;
-				eType = token_type::TOK_VAR_FLOAT;
-			}
-		}
-		/// <summary>
-		/// Look for an operator or special character. 
-		/// (or move forward or throw error for unknown character)
-		/// </summary>
-		void pop_operator()
-		{
-			std::array<char, 2> at = { pop(),  peek() };
-			switch (at[0])
+
+			switch (eType)
 			{
-			case '(': eType = token_type::TOK_OPEN; break;
-			case ')': eType = token_type::TOK_CLOSE; break;
-			case '{': eType = token_type::TOK_OPEN_CURLY; break;
-			case '}': eType = token_type::TOK_CLOSE_CURLY; break;
-			case '&':
-				if (at[1] == '&')
-				{
-					eType = token_type::TOK_AND;
-					pop();
-				}
-				else
-				{
-					// integer operations not supported currently
-					eType = token_type::TOK_ERROR;
-				}
+			case script_lexer::piece_type::block_begin:
+				// a block following an ended block is no part of its if statements
+				if (bEnded) close_ifs(asOpenIfs, uBlockLevel, psTable);
+				block_level_up();
 				break;
-			case '|':
-				if (at[1] == '|')
+			case script_lexer::piece_type::line_begin:
+				block_level_up();
+				break;
+			case script_lexer::piece_type::block_end:
+				if (uBlockLevel > 0)
 				{
-					eType = token_type::TOK_OR;
-					pop();
+					// if statements within end with the block, an "else" may follow the if statement of the block
+					block_level_down();
+					close_ifs(asOpenIfs, uBlockLevel + 1, psTable);
+					psTable->end_scope(uBlockLevel);
 				}
 				else
 				{
-					// integer operations not supported currently
-					eType = token_type::TOK_ERROR;
+					nErr = TS_FAIL;
+					return;
 				}
 				break;
-			case '=':
-			{
-				if (at[1] == '=')
-				{
-					eType = token_type::TOK_EQUAL;
-					pop();
-				}
-				else
-					eType = token_type::TOK_ASSIGN;
+			case script_lexer::piece_type::line_end:
+				block_level_down();
+				psTable->end_scope(uBlockLevel);
 				break;
-			}
-			case '!':
-			{
-				if (at[1] == '=')
+			case script_lexer::piece_type::else_branch:
+				if ((!bEnded) || (!open_else(asOpenIfs, psTable)))
 				{
-					eType = token_type::TOK_UNEQUAL;
-					pop();
+					nErr = TS_FAIL;
+					sCode = bytecode();
+					return;
 				}
-				else
-					eType = token_type::TOK_ERROR;
 				break;
-			}
-			case '>':
+			case script_lexer::piece_type::statement:
 			{
-				if (at[1] == '=')
+				// statements on this level or below end all if blocks they are not part of
+				close_ifs(asOpenIfs, uBlockLevel, psTable);
+
+				// compile statement to the instruction stream
+				ts_statement cStatement = ts_statement(at, psTable, sCode, uBlockLevel);
+				auto nE = cStatement.error();
+				if (nE)
 				{
-					eType = token_type::TOK_GREATER_EQUAL;
-					pop();
+					nErr = nE;
+					sCode = bytecode();
+					return;
 				}
-				else
-					eType = token_type::TOK_GREATER;
-				break;
-			}
-			case '<':
-			{
-				if (at[1] == '=')
+
+				switch (cStatement.type())
 				{
-					eType = token_type::TOK_LESS_EQUAL;
-					pop();
+				case ts_program::ts_types::sm_if:
+					// skip the block by a forward jump if the condition is false
+					asOpenIfs.push_back({ uBlockLevel, sCode.emit(ts_opcode::op_jump_false, cStatement.condition(), 0, 0) });
+					break;
+				case ts_program::ts_types::sm_loop:
+					// leave the loop if the condition is false, the loop end jumps back with the block end
+					asOpenIfs.push_back({ uBlockLevel, sCode.emit(ts_opcode::op_jump_false, cStatement.condition(), 0, 0), cStatement.loop(), std::string(cStatement.step()), cStatement.scope() });
+					break;
+				case ts_program::ts_types::sm_undefined:
+					// not supported yet, evaluation stops here
+					sCode.emit(ts_opcode::op_end, 0, 0, 0);
+					break;
+				case ts_program::ts_types::sm_function:
+					// functions are defined on top level only
+					if (uBlockLevel != 0)
+						nErr = TS_FAIL;
+					bDefining = true;
+					bBody = false;
+					atFunction = cStatement.function_name();
+					sFunction = symbol_table::function();
+					sFunction.atParams = cStatement.parameters();
+					break;
+				default:
+					break;
 				}
-				else
-					eType = token_type::TOK_LESS;
-				break;
-			}
-
-
-			case ' ': case '\t': case '\n': case '\r': break;
-			default: eType = token_type::TOK_ERROR; break;
 			}
-		}
-		/// <summary>find a string in bools list</summary>
-		const int find_bools(std::string& atName)
-		{
-			auto ps = std::find_if(pasBools->begin(), pasBools->end(),
-				[atName](const ts_boolean& a) { return a.atName == atName; });
-			if (ps == pasBools->end() || ps->atName != atName)
-			{
-				return -1;
+			break;
 			}
-			else
+			bEnded = (eType == script_lexer::piece_type::block_end) || (eType == script_lexer::piece_type::line_end);
+
+			// a loop step failed to compile
+			if (nErr)
 			{
-				std::ptrdiff_t nI = std::distance(pasBools->begin(), ps);
-				return (int)nI;
+				sCode = bytecode();
+				return;
 			}
 		}
-		/// <summary>find a string in variables list</summary>
-		const int find_vars(std::string& atName)
+
+		// block level back to zero, no definition open ?
+		if ((uBlockLevel != 0) || (bDefining)) nErr = TS_FAIL;
+
+		// close all blocks, end the script, the invoked function bodies follow
+		close_ifs(asOpenIfs, 0, psTable);
+		sCode.emit(ts_opcode::op_end, 0, 0, 0);
+		if (nErr == TS_OK) append_bodies(*psTable);
+
+		if ((nErr == TS_OK) && (eOptimize == ts_optimize::full))
+			optimize();
+		if (nErr == TS_OK)
 		{
-			auto ps = std::find_if(pasVars->begin(), pasVars->end(),
-				[atName](const ts_variable& a) { return a.m_name == atName; });
-			if (ps == pasVars->end() || ps->m_name != atName)
-			{
-				return -1;
-			}
-			else
-			{
-				std::ptrdiff_t nI = std::distance(pasVars->begin(), ps);
-				return (int)nI;
-			}
+			build_dependencies();
+			build_schedule();
 		}
+	}
 
-		/// <summary>the actual statement</summary>
-		std::string atStatement;
-		/// <summary>all variables used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_variable>> pasVars;
-		/// <summary>all booleans used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_boolean>> pasBools;
-		/// <summary>the current value</summary>
-		std::variant<unsigned, te_type, te_type*> sValue;
-		/// <summary>current token type</summary>
-		token_type eType;
-		/// <summary>current character index in the string</summary>
-		size_t uNext = 0;
-	};
-
-	/// <summary>TinyExpr statement class</summary>
-	class ts_statement_float_expr
+	/// <param name="sImage">compiled program image written by write(), not kept (nothing compiled or analyzed besides TinyExpr++ expressions)</param>
+	/// <param name="asVars">the script variables, names of the image resolved to these</param>
+	/// <param name="asBools">the script booleans, names of the image resolved to these</param>
+	explicit ts_program(ts_image sImage, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools)
+		: ts_program(sImage, asVars, asBools, {})
 	{
-	public:
-		ts_statement_float_expr() {}
+	}
 
-		/// <summary>operator needed to assign</summary>
-		ts_statement_float_expr& operator=(const ts_statement_float_expr& s)
+	/// <param name="sImage">compiled program image written by write(), not kept (nothing compiled or analyzed besides TinyExpr++ expressions)</param>
+	/// <param name="asVars">the script variables, names of the image resolved to these</param>
+	/// <param name="asBools">the script booleans, names of the image resolved to these</param>
+	/// <param name="asNatives">the host functions, names of the image resolved to these (arity and purity as compiled)</param>
+	explicit ts_program(ts_image sImage, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, const std::set<ts_native>& asNatives)
+	{
+		std::shared_ptr<symbol_table> psTable = std::make_shared<symbol_table>(asVars, asBools, asNatives);
+		psSymbols = psTable;
+		nErr = (valid(asNatives)) ? load(sImage.atData, *psTable) : TS_FAIL;
+		if (nErr)
 		{
-			this->pcTEP = s.pcTEP;
-			this->atStatement = s.atStatement;
-			this->pasVars = s.pasVars;
-			this->uDestIx = s.uDestIx;
-			this->nErr = s.nErr;
-			return *this;
+			sCode = bytecode();
+			sDependencies = dependencies();
+			sSchedule = schedule();
 		}
+	}
 
-		/// <param name="_atStatement">the statement string</param>
-		/// <param name="_pasVars">shared pointer to the script variables</param>
-		ts_statement_float_expr(std::string& _atStatement,
-			std::shared_ptr<std::set<ts_variable>> _pasVars,
-			unsigned _uDestIx
-		)
-			: atStatement(_atStatement)
-			, uDestIx(_uDestIx)
-			, pasVars(_pasVars)
-		{
-			if (_uDestIx >= (unsigned)_pasVars->size())
-			{
-				nErr = TS_FAIL;
-				return;
-			}
+	/// <summary>version of the compiled program image, images of other versions are rejected;
+	/// raise it whenever the layout of the image or the meaning of an instruction changes</summary>
+	static constexpr uint32_t uImageVersion = 1;
 
-			// create TinyExpr parser
-			pcTEP = std::make_shared<te_parser>();
+	/// <summary>instructions a script function body may have before it is invoked instead of inlined at each call</summary>
+	static constexpr size_t uInlineLimit = 64;
 
-			// convert and set variables
-			std::set<ts_variable> as = *(_pasVars.get());
-			std::set<te_variable> asTE;
-			for (const ts_variable& s : as)
-			{
-				// name, value, type, context
-				te_variable sTE = { s.m_name, s.m_value, s.m_type, nullptr };
-				asTE.insert(sTE);
-			}
-			pcTEP->set_variables_and_functions(asTE);
+	/// <summary>
+	/// write the compiled program as image, loaded by ts_program(ts_image, ...) :
+	/// header (version, value type, checksum), symbol names, register frame, instructions, TinyExpr++ expressions,
+	/// host function names and calls, dependency graph and parallel schedule
+	/// </summary>
+	/// <param name="cOut">the stream, opened binary</param>
+	/// <returns>TS_OK, TS_FAIL if the script did not compile or writing failed</returns>
+	int64_t write(std::ostream& cOut) const
+	{
+		if (nErr) return TS_FAIL;
 
-			// compile
-			if (!pcTEP->compile(_atStatement))
+		std::string atPayload;
+		auto put = [&atPayload](const auto& x) { atPayload.append((const char*)&x, sizeof(x)); };
+		auto put_string = [&](std::string_view at) { put((uint32_t)at.size()); atPayload.append(at); };
+
+		// names by slot, the host names resolved when loaded, the script locals following them
+		put((uint32_t)psSymbols->atVarNames.size());
+		put((uint32_t)psSymbols->uHostVars);
+		for (const std::string& at : psSymbols->atVarNames) put_string(at);
+		put((uint32_t)psSymbols->atBoolNames.size());
+		put((uint32_t)psSymbols->uHostBools);
+		for (const std::string& at : psSymbols->atBoolNames) put_string(at);
+
+		// register frame, constants and instructions
+		put((uint32_t)sCode.afFrame.size());
+		for (te_type f : sCode.afFrame) put(f);
+		put((uint32_t)sCode.auConstants.size());
+		for (const auto& sC : sCode.auConstants)
+		{
+			put(sC.first);
+			put((uint32_t)sC.second);
+		}
+		put((uint32_t)sCode.asCode.size());
+		for (const ts_instruction& sI : sCode.asCode)
+		{
+			put((uint32_t)sI.eOp);
+			put((uint32_t)sI.uA);
+			put((uint32_t)sI.uB);
+			put((uint32_t)sI.uC);
+		}
+
+		// TinyExpr++ expressions and their slots
+		put((uint32_t)sCode.apsFallbacks.size());
+		for (const std::shared_ptr<tinyexpr_fallback>& psF : sCode.apsFallbacks)
+		{
+			put_string(psF->atExpression);
+			put((uint32_t)psF->auSlots.size());
+			for (unsigned uSlot : psF->auSlots) put((uint32_t)uSlot);
+		}
+
+		// host functions by index (resolved by name when loaded), the argument registers of the calls
+		put((uint32_t)psSymbols->asNatives.size());
+		for (const ts_native& s : psSymbols->asNatives)
+		{
+			put_string(s.atName);
+			put((uint32_t)s.uArity);
+			put((uint32_t)s.bPure);
+		}
+		put((uint32_t)sCode.asNatives.size());
+		for (const native_call& sC : sCode.asNatives)
+		{
+			put((uint32_t)sC.auArgs.size());
+			for (unsigned uR : sC.auArgs) put((uint32_t)uR);
+		}
+
+		// dependency rows by slot
+		put((uint32_t)sDependencies.uWords);
+		for (uint64_t uBits : sDependencies.auAlways) put(uBits);
+		for (size_t uSlot = 0; uSlot + 1 < sDependencies.auRowBegin.size(); uSlot++)
+		{
+			put((uint32_t)(sDependencies.auRowBegin[uSlot + 1] - sDependencies.auRowBegin[uSlot]));
+			for (size_t uE = sDependencies.auRowBegin[uSlot]; uE < sDependencies.auRowBegin[uSlot + 1]; uE++)
 			{
-				// error compiling
-				nErr = pcTEP->get_last_error_position();
+				put((uint32_t)sDependencies.auWords[uE]);
+				put(sDependencies.auBits[uE]);
 			}
 		}
-		/// <summary></summary>
-		int64_t error() { return nErr; }
-		/// <summary>evaluate compiled statement</summary>
-		void evaluate()
+
+		// tasks
+		put((uint32_t)sSchedule.bParallel);
+		put((uint32_t)sSchedule.asTasks.size());
+		for (const schedule::task& sTask : sSchedule.asTasks)
 		{
-			if (pasVars->size() && !nErr)
+			put((uint32_t)sTask.asRanges.size());
+			for (const std::pair<unsigned, unsigned>& sR : sTask.asRanges)
 			{
-				te_type* pf = std::next(pasVars->begin(), uDestIx)->m_value;
-				if (pf) *pf = pcTEP->evaluate();
+				put((uint32_t)sR.first);
+				put((uint32_t)sR.second);
 			}
+			put((uint32_t)sTask.auSuccessors.size());
+			for (unsigned uS : sTask.auSuccessors) put((uint32_t)uS);
 		}
 
-	private:
-		/// <summary>TinyExpr parser</summary>
-		std::shared_ptr<te_parser> pcTEP;
-		/// <summary>the actual statement</summary>
-		std::string atStatement;
-		/// <summary>all variables used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_variable>> pasVars;
-		/// <summary>destination index in pasVars</summary>
-		unsigned uDestIx = 0;
-		/// <summary>0 if statement compiled</summary>
-		int64_t nErr = TS_OK;
-	};
+		image_header sHeader = image_header::current();
+		sHeader.uPayload = atPayload.size();
+		sHeader.uChecksum = name_index::hash(atPayload);
+		cOut.write((const char*)&sHeader, sizeof(sHeader));
+		cOut.write(atPayload.data(), (std::streamsize)atPayload.size());
+		return (cOut) ? TS_OK : TS_FAIL;
+	}
 
-	/// <summary>TinyScript boolean expression statement class</summary>
-	class ts_statement_bool_expr
+
+	/// <summary>returns error message and position</summary>
+	std::pair<int64_t, uint32_t> error() const
 	{
-	public:
-		ts_statement_bool_expr() {}
+		return std::make_pair(nErr, (uErrLine << 16) + (uErrMark & 0xFFFF));
+	}
 
-		/// <summary>operator needed to assign</summary>
-		ts_statement_bool_expr& operator=(const ts_statement_bool_expr& s)
+	/// <summary>
+	/// readable listing of the compiled instructions, to inspect the optimized program
+	/// (registers as "r" and index, constant registers as their value)
+	/// </summary>
+	std::string dump() const
+	{
+		static constexpr const char* aatOps[] =
 		{
-			this->asTermsCompiled = std::move(s.asTermsCompiled);
-			this->aasEvaluationValues = std::vector<std::vector<term>>();
-			aasEvaluationValues.resize(s.aasEvaluationValues.size());
-			this->atStatement = s.atStatement;
-			this->pasVars = s.pasVars;
-			this->pasBools = s.pasBools;
-			this->pbDestBool = s.pbDestBool;
-			this->uDestIx = s.uDestIx;
-			this->nErr = s.nErr;
-			this->psState = s.psState;
-			return *this;
-		}
+			"end", "load_var", "load_bool", "store_var", "store_bool", "mov", "neg", "add", "sub", "mul", "div", "mod", "pow",
+			"sqrt", "abs", "atan2", "call", "equal", "unequal", "greater", "less", "greater_equal", "less_equal", "and", "or",
+			"tinyexpr", "jump", "jump_false", "loop", "next", "invoke", "native"
+		};
+		std::vector<bool> abConstant(sCode.afFrame.size(), false);
+		for (const auto& s : sCode.auConstants) abConstant[s.second] = true;
 
-		/// <param name="_atStatement">the statement string</param>
-		/// <param name="_pasVars">shared pointer to the script variables</param>
-		ts_statement_bool_expr(std::string& _atStatement,
-			std::shared_ptr<std::set<ts_variable>> _pasVars,
-			std::shared_ptr<std::set<ts_boolean>> _pasBools,
-			std::shared_ptr<bool> _pbDestBool,
-			unsigned _uDestIx
-		)
-			: atStatement(_atStatement)
-			, uDestIx(_uDestIx)
-			, pasBools(_pasBools)
-			, pasVars(_pasVars)
-			, pbDestBool(_pbDestBool)
+		std::ostringstream atS;
+		atS.precision(std::numeric_limits<te_type>::max_digits10);
+		auto reg = [&](unsigned uR)
+			{
+				if (abConstant[uR]) atS << sCode.afFrame[uR];
+				else atS << "r" << uR;
+			};
+		for (size_t uPc = 0; uPc < sCode.asCode.size(); uPc++)
 		{
-			if ((_pbDestBool == nullptr) && (_uDestIx >= (unsigned)_pasBools->size()))
+			const ts_instruction& s = sCode.asCode[uPc];
+			std::string atOp = aatOps[(unsigned)s.eOp];
+			std::string atIx = std::to_string(uPc);
+			atS << std::string((atIx.size() < 4) ? 4 - atIx.size() : 0, ' ') << atIx << "  " << atOp << std::string((atOp.size() < 14) ? 14 - atOp.size() : 1, ' ');
+			switch (s.eOp)
 			{
-				nErr = TS_FAIL;
-				return;
+			case ts_opcode::op_end: break;
+			case ts_opcode::op_load_var: reg(s.uA); atS << ", " << psSymbols->atVarNames[s.uB]; break;
+			case ts_opcode::op_load_bool: reg(s.uA); atS << ", " << psSymbols->atBoolNames[s.uB]; break;
+			case ts_opcode::op_store_var: atS << psSymbols->atVarNames[s.uA] << ", "; reg(s.uB); break;
+			case ts_opcode::op_store_bool: atS << psSymbols->atBoolNames[s.uA] << ", "; reg(s.uB); break;
+			case ts_opcode::op_call: reg(s.uA); atS << ", " << ts_builtins()[s.uC].atName << ", "; reg(s.uB); break;
+			case ts_opcode::op_tinyexpr: reg(s.uA); atS << ", \"" << sCode.apsFallbacks[s.uB]->atExpression << "\""; break;
+			case ts_opcode::op_jump: atS << s.uB; break;
+			case ts_opcode::op_jump_false: reg(s.uA); atS << ", " << s.uB; break;
+			case ts_opcode::op_loop:
+			case ts_opcode::op_next: reg(s.uA); atS << ", " << s.uB << ", "; reg(s.uC); break;
+			case ts_opcode::op_invoke: atS << psSymbols->atVarNames[s.uA] << ", " << s.uB; break;
+			case ts_opcode::op_native:
+				reg(s.uA); atS << ", " << psSymbols->asNatives[s.uC].atName;
+				for (unsigned uR : sCode.asNatives[s.uB].auArgs) { atS << ", "; reg(uR); }
+				break;
+			case ts_opcode::op_mov:
+			case ts_opcode::op_neg:
+			case ts_opcode::op_sqrt:
+			case ts_opcode::op_abs:
+				reg(s.uA); atS << ", "; reg(s.uB); break;
+			default:
+				reg(s.uA); atS << ", "; reg(s.uB); atS << ", "; reg(s.uC); break;
 			}
+			atS << "\n";
+		}
+		return atS.str();
+	}
 
-			// create state class
-			psState = std::make_shared<state>(state(_atStatement, _pasVars, _pasBools));
+	/// <summary>true if the estimated work justifies evaluating independent statements concurrently, see ts_context::evaluate(ts_thread_pool&)</summary>
+	bool parallel() const { return sSchedule.bParallel; }
 
-			// start with level null and one values level
-			unsigned uLevel = 0;
-			aasEvaluationValues.resize(1);
-			do
-			{
-				psState->next_token();
-				switch (psState->get_type())
-				{
-				case ts_parser::state::token_type::TOK_OPEN:
-					uLevel++;
-					if (uLevel >= aasEvaluationValues.size())
-						aasEvaluationValues.resize(uLevel + 1);
-					break;
-				case ts_parser::state::token_type::TOK_CLOSE:
-					if (uLevel > 0)
-						uLevel--;
-					else
-					{
-						nErr = TS_FAIL;
-						return;
-					}
-					break;
-				case ts_parser::state::token_type::TOK_NULL:
-				case ts_parser::state::token_type::TOK_ERROR:
-				case ts_parser::state::token_type::TOK_OPEN_CURLY:
-				case ts_parser::state::token_type::TOK_CLOSE_CURLY:
-				case ts_parser::state::token_type::TOK_ASSIGN:
-				case ts_parser::state::token_type::TOK_IF:
-				case ts_parser::state::token_type::TOK_ELSE:
-					nErr = TS_FAIL;
-					return;
+	/// <summary>slot of a script variable (for ts_context::evaluate_changed()), TS_FAIL if not a script variable</summary>
+	int64_t var_slot(std::string_view atName) const
+	{
+		int nIx = psSymbols->find_var(atName);
+		return (nIx < 0) ? TS_FAIL : (int64_t)nIx;
+	}
 
-				case ts_parser::state::token_type::TOK_NUMBER:
-				{
-					// get the actual number
-					te_type fValue = psState->value_floating();
-					term_level s = { term_level_type::floating_const, uLevel, (te_type)fValue };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_TRUE:
-				{
-					term_level s = { term_level_type::boolean_const, uLevel, (bool)true };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_FALSE:
-				{
-					term_level s = { term_level_type::boolean_const, uLevel, (bool)false };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_VAR_FLOAT:
-				{
-					// get the variable index
-					unsigned uIx = psState->value_unsigned();
+	/// <summary>slot of a script boolean (for ts_context::evaluate_changed()), TS_FAIL if not a script boolean</summary>
+	int64_t bool_slot(std::string_view atName) const
+	{
+		int nIx = psSymbols->find_bool(atName);
+		return (nIx < 0) ? TS_FAIL : (int64_t)nIx;
+	}
 
-					// return error if wrong index or type
-					if (uIx >= _pasVars->size())
-					{
-						nErr = TS_FAIL;
-						return;
-					}
+private:
 
-					term_level s = { term_level_type::floating, uLevel, (unsigned)uIx };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_VAR_BOOL:
-				{
-					// get the variable index
-					unsigned uIx = psState->value_unsigned();
+	/// <summary>header of a compiled program image, images of another build (version, value type, instruction set) are stale</summary>
+	struct image_header
+	{
+		/// <summary>the header of this build</summary>
+		static image_header current()
+		{
+			return { { 'T', 'S', 'P', 'I' }, uImageVersion, 0x01020304u, (uint32_t)sizeof(te_type),
+				(uint32_t)ts_opcode::op_native + 1, (uint32_t)ts_builtins().size(), 0, 0 };
+		}
 
-					// return error if wrong index or type
-					if (uIx >= _pasBools->size())
-					{
-						nErr = TS_FAIL;
-						return;
-					}
+		/// <summary>"TSPI"</summary>
+		char acMagic[4];
+		/// <summary>image version</summary>
+		uint32_t uVersion;
+		/// <summary>byte order marker</summary>
+		uint32_t uByteOrder;
+		/// <summary>size of the value type (float or double)</summary>
+		uint32_t uValueSize;
+		/// <summary>number of operation codes</summary>
+		uint32_t uOpcodes;
+		/// <summary>number of inline compiled builtins</summary>
+		uint32_t uBuiltins;
+		/// <summary>size of the payload following the header</summary>
+		uint64_t uPayload;
+		/// <summary>hash of the payload</summary>
+		uint64_t uChecksum;
+	};
 
-					term_level s = { term_level_type::boolean, uLevel, (unsigned)uIx };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_OR:
-				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_OR };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_AND:
-				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_AND };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_UNEQUAL:
-				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_UNEQUAL };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_GREATER:
-				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_GREATER };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_LESS:
-				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_LESS };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_GREATER_EQUAL:
-				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_GREATER_EQUAL };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_LESS_EQUAL:
+	/// <summary>compiled symbol table, defined with the compiler types below</summary>
+	struct symbol_table;
+
+	/// <summary>load a compiled program image, resolve the names and validate every instruction</summary>
+	/// <param name="sTable">the symbol table of this program, the script locals of the image are added</param>
+	/// <returns>TS_OK, TS_FAIL if stale, corrupt or a name used is not found</returns>
+	int64_t load(std::string_view atImage, symbol_table& sTable)
+	{
+		// header and checksum
+		image_header sHeader = {}, sCurrent = image_header::current();
+		if (atImage.size() < sizeof(image_header)) return TS_FAIL;
+		std::memcpy(&sHeader, atImage.data(), sizeof(image_header));
+		sCurrent.uPayload = sHeader.uPayload;
+		sCurrent.uChecksum = sHeader.uChecksum;
+		if (std::memcmp(&sHeader, &sCurrent, sizeof(image_header)) != 0) return TS_FAIL;
+		std::string_view atPayload = atImage.substr(sizeof(image_header));
+		if ((atPayload.size() != sHeader.uPayload) || (name_index::hash(atPayload) != sHeader.uChecksum)) return TS_FAIL;
+
+		// reads fail past the end
+		const char* pc = atPayload.data();
+		size_t uLeft = atPayload.size();
+		bool bOk = true;
+		auto bytes = [&](size_t uSize) -> const char*
+			{
+				if ((!bOk) || (uSize > uLeft))
 				{
-					term_level s = { term_level_type::operative, uLevel, (state::token_compare_type)state::token_compare_type::TOK_LESS_EQUAL };
-					asTermsCompiled.push_back(s);
-				}
-				break;
-				case ts_parser::state::token_type::TOK_END:
-				default:
-					break;
+					bOk = false;
+					return nullptr;
 				}
-			} while (psState->get_type() != state::token_type::TOK_END);
+				const char* p = pc;
+				pc += uSize, uLeft -= uSize;
+				return p;
+			};
+		auto get = [&](auto& x) { if (const char* p = bytes(sizeof(x))) std::memcpy(&x, p, sizeof(x)); };
+		auto get_count = [&](size_t uMinSize)
+			{
+				uint32_t uCount = 0;
+				get(uCount);
+				if ((size_t)uCount * uMinSize > uLeft) bOk = false;
+				return (bOk) ? uCount : 0u;
+			};
+		auto get_string = [&]()
+			{
+				uint32_t uSize = 0;
+				get(uSize);
+				const char* p = bytes(uSize);
+				return (p) ? std::string_view(p, uSize) : std::string_view();
+			};
+
+		// the image slots resolved to the slots of this symbol table, the locals get new slots
+		const unsigned uNone = ~0u;
+		uint32_t uHost = 0;
+		std::vector<unsigned> auVars(get_count(4)), auBools;
+		get(uHost);
+		for (size_t uIx = 0; uIx < auVars.size(); uIx++)
+		{
+			std::string_view atName = get_string();
+			int nIx = (uIx < uHost) ? sTable.find_var(atName) : (int)sTable.add_local(atName, false);
+			auVars[uIx] = (nIx < 0) ? uNone : (unsigned)nIx;
+		}
+		auBools.resize(get_count(4));
+		get(uHost);
+		for (size_t uIx = 0; uIx < auBools.size(); uIx++)
+		{
+			std::string_view atName = get_string();
+			int nIx = (uIx < uHost) ? sTable.find_bool(atName) : (int)sTable.add_local(atName, true);
+			auBools[uIx] = (nIx < 0) ? uNone : (unsigned)nIx;
 		}
+		auto var = [&](unsigned& uSlot) { bOk = bOk && (uSlot < auVars.size()) && (auVars[uSlot] != uNone); if (bOk) uSlot = auVars[uSlot]; };
+		auto boolean = [&](unsigned& uSlot) { bOk = bOk && (uSlot < auBools.size()) && (auBools[uSlot] != uNone); if (bOk) uSlot = auBools[uSlot]; };
 
-		/// <summary></summary>
-		[[nodiscard]] int64_t error() { return nErr; }
-		/// <summary>evaluate compiled statement</summary>
-		void evaluate()
+		// register frame and constants
+		sCode.afFrame.resize(get_count(sizeof(te_type)));
+		for (te_type& f : sCode.afFrame) get(f);
+		const size_t uFrame = sCode.afFrame.size();
+		for (uint32_t uC = get_count(12); uC > 0; uC--)
+		{
+			uint64_t uBits = 0;
+			uint32_t uReg = 0;
+			get(uBits);
+			get(uReg);
+			bOk = bOk && (uReg < uFrame);
+			sCode.auConstants[uBits] = uReg;
+		}
+
+		// instructions
+		sCode.asCode.resize(get_count(16));
+		for (ts_instruction& sI : sCode.asCode)
 		{
-			// clear evaluation level vectors
-			for (auto& as : aasEvaluationValues)
-				as.clear();
+			uint32_t uOp = 0;
+			get(uOp);
+			get(sI.uA);
+			get(sI.uB);
+			get(sI.uC);
+			bOk = bOk && (uOp <= (uint32_t)ts_opcode::op_native);
+			sI.eOp = (bOk) ? (ts_opcode)uOp : ts_opcode::op_end;
+		}
 
-			if (pasVars->size() && !nErr)
+		// TinyExpr++ expressions
+		sCode.apsFallbacks.resize(get_count(8));
+		for (std::shared_ptr<tinyexpr_fallback>& psF : sCode.apsFallbacks)
+		{
+			psF = std::make_shared<tinyexpr_fallback>();
+			psF->atExpression = std::string(get_string());
+			psF->auSlots.resize(get_count(4));
+			for (unsigned& uSlot : psF->auSlots)
 			{
-				// get destination bool
-				bool* pb = (pbDestBool == nullptr) ? std::next(pasBools->begin(), uDestIx)->pbValue : pbDestBool.get();
-				if (pb)
-				{
-					unsigned uLevel = 0;
+				get(uSlot);
+				var(uSlot);
+			}
+			std::sort(psF->auSlots.begin(), psF->auSlots.end());
+		}
 
-					// evaluate.. loop through terms
-					for (term_level& s : asTermsCompiled)
-					{
-						if (s.uLevel > uLevel)
-							uLevel = s.uLevel;
-						else if (s.uLevel < uLevel)
-							level_down(uLevel, s.uLevel);
+		// host functions resolved to the functions of this symbol table (arity and purity as compiled), the calls
+		std::vector<unsigned> auNatives(get_count(12));
+		for (unsigned& uF : auNatives)
+		{
+			std::string_view atName = get_string();
+			uint32_t uArity = 0, uPure = 0;
+			get(uArity);
+			get(uPure);
+			const name_index::entry* ps = sTable.sNames.find(atName, name_index::kind::native);
+			bOk = bOk && (ps) && (sTable.asNatives[ps->uIx].uArity == uArity) && (sTable.asNatives[ps->uIx].bPure == (uPure != 0));
+			uF = (bOk) ? ps->uIx : 0;
+		}
+		sCode.asNatives.resize(get_count(4));
+		for (native_call& sC : sCode.asNatives)
+		{
+			sC.psFunction = nullptr;
+			sC.auArgs.resize(get_count(4));
+			for (unsigned& uR : sC.auArgs) get(uR);
+		}
 
-						address_term(s, uLevel);
-					}
+		// dependency rows moved to the resolved slots, slots not resolved are not used
+		const size_t uVars = sTable.apfVars.size();
+		uint32_t uWords = 0;
+		get(uWords);
+		bOk = bOk && (sCode.asCode.size() > 0) && (uWords == (sCode.asCode.size() + 63) / 64) && ((size_t)uWords * 8 <= uLeft);
+		sDependencies.uWords = (bOk) ? uWords : 0;
+		sDependencies.auAlways.resize(sDependencies.uWords);
+		for (uint64_t& uBits : sDependencies.auAlways) get(uBits);
 
-					// go down to level zero and set the value
-					level_down(uLevel, 0);
-					if ((aasEvaluationValues.size()) && (aasEvaluationValues[0].size()))
-						*pb = get_bool(aasEvaluationValues[0][0]);
-				}
+		// no instructions past the end, the end always executed (the incremental evaluation stops there)
+		const size_t uLast = sCode.asCode.size() - 1;
+		const uint64_t uPast = ~(uint64_t)1 << (uLast & 63);
+		auto past_end = [&](unsigned uWord, uint64_t uBits) { return (uWord == (uLast >> 6)) && (uBits & uPast); };
+		bOk = bOk && (!past_end((unsigned)(uLast >> 6), sDependencies.auAlways[uLast >> 6])) && ((sDependencies.auAlways[uLast >> 6] >> (uLast & 63)) & 1);
+		std::vector<std::vector<std::pair<unsigned, uint64_t>>> aasRows(uVars + sTable.apbBools.size());
+		for (size_t uRow = 0; (bOk) && (uRow < auVars.size() + auBools.size()); uRow++)
+		{
+			unsigned uSlot = (uRow < auVars.size()) ? auVars[uRow] : auBools[uRow - auVars.size()];
+			uint32_t uCount = get_count(12);
+			bOk = bOk && ((uCount == 0) || (uSlot != uNone));
+			if ((!bOk) || (uSlot == uNone)) continue;
+			std::vector<std::pair<unsigned, uint64_t>>& asRow = aasRows[(uRow < auVars.size()) ? uSlot : uVars + uSlot];
+			asRow.resize(uCount);
+			for (std::pair<unsigned, uint64_t>& sW : asRow)
+			{
+				get(sW.first);
+				get(sW.second);
+				bOk = bOk && (sW.first < uWords) && (!past_end(sW.first, sW.second));
 			}
 		}
+		sDependencies.assign(aasRows);
 
-	private:
+		// tasks within the program (the function bodies follow), successors always follow (the predecessor counts are derived)
+		const size_t uProgramEnd = program_end(sCode.asCode);
+		uint32_t uParallel = 0;
+		get(uParallel);
+		sSchedule.bParallel = (uParallel != 0);
+		sSchedule.asTasks.resize(get_count(8));
+		for (size_t uT = 0; uT < sSchedule.asTasks.size(); uT++)
+		{
+			schedule::task& sTask = sSchedule.asTasks[uT];
+			sTask.asRanges.resize(get_count(8));
+			for (std::pair<unsigned, unsigned>& sR : sTask.asRanges)
+			{
+				get(sR.first);
+				get(sR.second);
+				bOk = bOk && (sR.first < sR.second) && (sR.second <= uProgramEnd);
+			}
+			sTask.auSuccessors.resize(get_count(4));
+			for (unsigned& uS : sTask.auSuccessors)
+			{
+				get(uS);
+				bOk = bOk && (uS > uT) && (uS < sSchedule.asTasks.size());
+				if (bOk) sSchedule.asTasks[uS].uPredecessors++;
+			}
+		}
+		if ((!bOk) || (uLeft != 0)) return TS_FAIL;
 
-		/// <summary>
-		/// possible term types, operator or constant
-		/// </summary>
-		enum struct term_type : unsigned
+		// operands in range, jumps forward within their part (the program or a function body, each up to its end),
+		// loops as compiled (the end jumps back to the entry, the entry to after the end), bodies invoked by the parts before, the end last
+		const size_t uSize = sCode.asCode.size();
+		if ((uSize == 0) || (sCode.asCode.back().eOp != ts_opcode::op_end) || (uProgramEnd >= uSize)) return TS_FAIL;
+		std::vector<size_t> auPartEnd(uSize, uSize - 1);
+		for (size_t uPc = uSize - 1; uPc-- > 0;)
+			auPartEnd[uPc] = ((uPc >= uProgramEnd) && (sCode.asCode[uPc].eOp == ts_opcode::op_end)) ? uPc : auPartEnd[uPc + 1];
+		std::fill_n(auPartEnd.begin(), uProgramEnd, uProgramEnd);
+		for (size_t uPc = 0; (bOk) && (uPc < uSize); uPc++)
 		{
-			floating_const,
-			boolean_const,
-			operative,
-		};
+			ts_instruction& sI = sCode.asCode[uPc];
+			if (sI.eOp == ts_opcode::op_native)
+			{
+				// each call used by one instruction, with as many arguments as the function has
+				bOk = bOk && (sI.uB < sCode.asNatives.size()) && (sI.uC < auNatives.size()) && (sCode.asNatives[sI.uB].psFunction == nullptr);
+				if (!bOk) break;
+				sI.uC = auNatives[sI.uC];
+				native_call& sC = sCode.asNatives[sI.uB];
+				sC.psFunction = &sTable.asNatives[sI.uC];
+				bOk = (sC.auArgs.size() == sC.psFunction->uArity);
+			}
+			operands apuRegs = {};
+			unsigned uOperands = operand_registers(sI, apuRegs);
+			for (unsigned uO = 0; uO < uOperands; uO++) bOk = bOk && (*apuRegs[uO] < uFrame);
+			if (defines_register(sI.eOp)) bOk = bOk && (sI.uA < uFrame);
+			switch (sI.eOp)
+			{
+			case ts_opcode::op_load_var: var(sI.uB); break;
+			case ts_opcode::op_load_bool: boolean(sI.uB); break;
+			case ts_opcode::op_store_var: var(sI.uA); break;
+			case ts_opcode::op_store_bool: boolean(sI.uA); break;
+			case ts_opcode::op_call: bOk = bOk && (sI.uC < ts_builtins().size()) && (ts_builtins()[sI.uC].pfFunc != nullptr); break;
+			case ts_opcode::op_tinyexpr: bOk = bOk && (sI.uB < sCode.apsFallbacks.size()); break;
+			case ts_opcode::op_jump:
+			case ts_opcode::op_jump_false: bOk = bOk && (sI.uB > uPc) && (sI.uB <= auPartEnd[uPc]); break;
+			case ts_opcode::op_loop:
+				bOk = bOk && (sI.uA < uFrame) && (sI.uB > uPc + 1) && (sI.uB <= auPartEnd[uPc]);
+				bOk = bOk && (sCode.asCode[sI.uB - 1].eOp == ts_opcode::op_next) && (sCode.asCode[sI.uB - 1].uA == sI.uA) && (sCode.asCode[sI.uB - 1].uB == uPc + 1);
+				break;
+			case ts_opcode::op_next:
+				bOk = bOk && (sI.uB > 0) && (sI.uB <= uPc) && (sCode.asCode[sI.uB - 1].eOp == ts_opcode::op_loop) && (sCode.asCode[sI.uB - 1].uB == uPc + 1);
+				break;
+			case ts_opcode::op_invoke:
+				var(sI.uA);
+				bOk = bOk && (sI.uB > auPartEnd[uPc]) && (sI.uB < uSize) && (sCode.asCode[sI.uB - 1].eOp == ts_opcode::op_end);
+				break;
+			default: break;
+			}
+		}
+		if (!bOk) return TS_FAIL;
 
-		/// <summary>
-		/// possible term types, operator or constant or variable
-		/// </summary>
-		enum struct term_level_type : unsigned
+		// the expressions bound to this symbol table
+		for (const std::shared_ptr<tinyexpr_fallback>& psF : sCode.apsFallbacks)
+			if (!psF->compile(sTable)) return TS_FAIL;
+		return TS_OK;
+	}
+
+	/// <summary>true if each host function has a function, at most ts_native::uMaxArity arguments and a name a script may refer to</summary>
+	static bool valid(const std::set<ts_native>& asNatives)
+	{
+		for (const ts_native& s : asNatives)
 		{
-			floating,
-			floating_const,
+			if ((!s.pfFunction) || (s.uArity > ts_native::uMaxArity) || (s.atName.empty()) || (isdigit((unsigned char)s.atName.front()))) return false;
+			for (char c : s.atName) if ((!isalpha((unsigned char)c)) && (!isdigit((unsigned char)c)) && (c != '_')) return false;
+		}
+		return true;
+	}
+
+	/// <summary>possible statement types</summary>
+	enum struct ts_types : unsigned
+	{
+		sm_undefined = 0,
+		sm_expr_float,
+		sm_expr_bool,
+		sm_if,
+		sm_loop,
+		sm_function
+	};
+
+	/// <summary>
+	/// open addressing index of all names a script may refer to (linear probing, built once per program) :
+	/// variables, booleans, keywords, inline compiled builtins and host functions, a name is found as the first of these kinds
+	/// (script locals and functions are added while compiled, locals hidden at the end of their scope)
+	/// </summary>
+	struct name_index
+	{
+		/// <summary>kind of a name</summary>
+		enum struct kind : unsigned
+		{
+			variable,
 			boolean,
-			boolean_const,
-			operative,
+			keyword,
+			builtin,
+			native,
+			function,
+			hidden
 		};
 
-		/// <summary>
-		/// intermediate evaluation term
-		/// </summary>
-		struct term
+		/// <summary>an entry, empty if the name is nullptr</summary>
+		struct entry
 		{
-			/// <summary>the type of this term, operator or constant</summary>
-			term_type eType;
-			/// <summary>term value depending on type</summary>
-			std::variant<state::token_compare_type, te_type, bool> sValue;
+			/// <summary>the name, refers to storage living as long as the index</summary>
+			std::string_view atName;
+			/// <summary>hash of the name</summary>
+			uint64_t uHash;
+			/// <summary>kind of the name</summary>
+			kind eKind;
+			/// <summary>slot, keyword, builtin, host function or function index</summary>
+			unsigned uIx;
 		};
 
-		/// <summary>
-		/// compiled term
-		/// </summary>
-		struct term_level
+		/// <summary>names visible while a function body compiles : slots from uVars and uBools on, functions before uFunctions</summary>
+		struct visibility
 		{
-			/// <summary>the type of this term, operator or constant or variable</summary>
-			term_level_type eType;
-			/// <summary>braces level of this term</summary>
-			unsigned uLevel;
-			/// <summary>term value depending on type</summary>
-			std::variant<unsigned, state::token_compare_type, te_type, bool> sValue;
+			unsigned uVars = 0, uBools = 0, uFunctions = ~0u;
 		};
 
-		/// <summary>add a level to a term</summary>
-		[[nodiscard]] term_level level_term(term& sT, unsigned uLevel)
+		/// <summary>FNV-1a hash of a name</summary>
+		static uint64_t hash(std::string_view atName)
 		{
-			switch (sT.eType)
-			{
-			case ts_parser::ts_statement_bool_expr::term_type::floating_const:
-				return { term_level_type::floating_const, uLevel, (te_type)std::get<te_type>(sT.sValue) };
-			case ts_parser::ts_statement_bool_expr::term_type::boolean_const:
-				return { term_level_type::boolean_const, uLevel, (bool)std::get<bool>(sT.sValue) };
-			case ts_parser::ts_statement_bool_expr::term_type::operative:
-				return { term_level_type::operative, uLevel, (state::token_compare_type)std::get<state::token_compare_type>(sT.sValue) };
-			default:
-				break;
-			}
+			uint64_t uHash = 0xcbf29ce484222325ull;
+			for (char c : atName) uHash = (uHash ^ (unsigned char)c) * 0x100000001b3ull;
+			return uHash;
+		}
+
+		/// <summary>reserve for this number of names (at most half of the entries used)</summary>
+		void reserve(size_t uNames)
+		{
+			size_t uSize = 16;
+			while (uSize < uNames * 2) uSize *= 2;
+			asEntries.assign(uSize, { std::string_view(), 0, kind::variable, 0 });
+			uMask = uSize - 1;
+			uUsed = 0;
+		}
 
-			return {};
+		/// <summary>true if one more name keeps at most half of the entries used</summary>
+		bool room() const { return (uUsed + 1) * 2 <= asEntries.size(); }
+
+		/// <summary>add a name, found after the same name added before (the index is reserved for all names)</summary>
+		void insert(std::string_view atName, kind eKind, unsigned uIx)
+		{
+			uint64_t uHash = hash(atName);
+			size_t uE = (size_t)uHash & uMask;
+			while (asEntries[uE].atName.data()) uE = (uE + 1) & uMask;
+			asEntries[uE] = { atName, uHash, eKind, uIx };
+			uUsed++;
 		}
 
-		/// <summary>level down the evaluation value level</summary>
-		void level_down(unsigned& uLevel, unsigned uTarget)
+		/// <summary>hide the entry of this name, kind and index (the entry stays, probing continues past it)</summary>
+		void hide(std::string_view atName, kind eKind, unsigned uIx)
 		{
-			if (uLevel < aasEvaluationValues.size())
+			uint64_t uHash = hash(atName);
+			for (size_t uE = (size_t)uHash & uMask; asEntries[uE].atName.data(); uE = (uE + 1) & uMask)
 			{
-				for (; uLevel > uTarget;)
+				entry& s = asEntries[uE];
+				if ((s.uHash == uHash) && (s.eKind == eKind) && (s.uIx == uIx) && (s.atName == atName))
 				{
-					if (aasEvaluationValues[uLevel].size())
-					{
-						term_level sT = level_term(aasEvaluationValues[uLevel].front(), uLevel - 1);
-						aasEvaluationValues[uLevel].clear();
-						address_term(sT, --uLevel);
-					}
-					else
-						uLevel--;
+					s.eKind = kind::hidden;
+					return;
 				}
 			}
 		}
 
-		/// <summary>handle this term</summary>
-		void address_term(term_level& s, unsigned uLevel)
+		/// <summary>the first visible entry of this name, nullptr if not found</summary>
+		const entry* find(std::string_view atName) const
 		{
-			if (uLevel < aasEvaluationValues.size())
+			uint64_t uHash = hash(atName);
+			for (size_t uE = (size_t)uHash & uMask; asEntries[uE].atName.data(); uE = (uE + 1) & uMask)
 			{
-				if (s.eType == term_level_type::operative)
-				{
-					term sTev = { term_type::operative, std::get<state::token_compare_type>(s.sValue) };
-					aasEvaluationValues[uLevel].push_back(sTev);
-				}
-				else
-				{
-					if (aasEvaluationValues[uLevel].size())
-					{
-						if (aasEvaluationValues[uLevel].back().eType == term_type::operative)
-						{
-							state::token_compare_type eCType = std::get<state::token_compare_type>(aasEvaluationValues[uLevel].back().sValue);
-							switch (eCType)
-							{
-							case ts_parser::state::token_compare_type::TOK_EQUAL:
-							case ts_parser::state::token_compare_type::TOK_UNEQUAL:
-							case ts_parser::state::token_compare_type::TOK_GREATER:
-							case ts_parser::state::token_compare_type::TOK_LESS:
-							case ts_parser::state::token_compare_type::TOK_GREATER_EQUAL:
-							case ts_parser::state::token_compare_type::TOK_LESS_EQUAL:
-							{
-								// do actual bool compare
-								std::array<std::variant<bool, te_type>, 2> as = { get_float(aasEvaluationValues[uLevel].front()), get_float(s) };
-								aasEvaluationValues[uLevel] = { { term_type::boolean_const, compare(eCType, as) } };
-							}
-							break;
-							case ts_parser::state::token_compare_type::TOK_AND:
-							case ts_parser::state::token_compare_type::TOK_OR:
-							{
-								// do actual bool compare
-								std::array<std::variant<bool, te_type>, 2> as = { get_bool(aasEvaluationValues[uLevel].front()), get_bool(s) };
-								aasEvaluationValues[uLevel] = { { term_type::boolean_const, compare(eCType, as) } };
-							}
-							break;
-							default:
-								break;
-							}
-						}
-					}
-					else
-					{
-						term sTev = {};
-						switch (s.eType)
-						{
-						case ts_parser::ts_statement_bool_expr::term_level_type::floating:
-						case ts_parser::ts_statement_bool_expr::term_level_type::floating_const:
-						{
-							te_type fV = get_float(s);
-							sTev = { term_type::floating_const, fV };
-						}
-						break;
-						case ts_parser::ts_statement_bool_expr::term_level_type::boolean:
-						case ts_parser::ts_statement_bool_expr::term_level_type::boolean_const:
-						{
-							bool bV = get_bool(s);
-							sTev = { term_type::boolean_const, bV };
-						}
-						break;
-						// shouldnt be possible to get here...
-						case ts_parser::ts_statement_bool_expr::term_level_type::operative:
-						default: break;
-						}
-						aasEvaluationValues[uLevel].push_back(sTev);
-					}
-				}
+				const entry& s = asEntries[uE];
+				if ((s.uHash == uHash) && (visible(s)) && (s.atName == atName)) return &s;
 			}
+			return nullptr;
 		}
 
-		/// <summary>get boolean value from term</summary>
-		[[nodiscard]] bool get_bool(term& sTerm)
+		/// <summary>true if the entry is not hidden and visible to the code compiled</summary>
+		bool visible(const entry& s) const
+		{
+			switch (s.eKind)
+			{
+			case kind::variable: return s.uIx >= sVisible.uVars;
+			case kind::boolean: return s.uIx >= sVisible.uBools;
+			case kind::function: return s.uIx < sVisible.uFunctions;
+			case kind::hidden: return false;
+			default: return true;
+			}
+		}
+
+		/// <summary>the entry of this name and kind, nullptr if not found</summary>
+		const entry* find(std::string_view atName, kind eKind) const
+		{
+			uint64_t uHash = hash(atName);
+			for (size_t uE = (size_t)uHash & uMask; asEntries[uE].atName.data(); uE = (uE + 1) & uMask)
+			{
+				const entry& s = asEntries[uE];
+				if ((s.uHash == uHash) && (s.eKind == eKind) && (s.atName == atName)) return &s;
+			}
+			return nullptr;
+		}
+
+		/// <summary>the entries, a power of two</summary>
+		std::vector<entry> asEntries;
+		/// <summary>entry count minus one</summary>
+		size_t uMask = 0;
+		/// <summary>entries used, hidden ones included</summary>
+		size_t uUsed = 0;
+		/// <summary>names visible, all but while a function body compiles</summary>
+		visibility sVisible;
+	};
+
+	/// <summary>keywords, index is the keyword index of the name index</summary>
+	static constexpr std::array<const char*, 12> aatKeywords = { "if", "else", "true", "false", "pi", "e", "while", "for", "float", "bool", "func", "return" };
+
+	/// <summary>
+	/// compiled symbol table, variable and boolean addresses in contiguous storage
+	/// (the slot index equals the index within the sorted source set)
+	/// built once per script, the statements only refer to the slot indices,
+	/// the addresses are the initial bindings of each context (may be nullptr),
+	/// script locals follow the host slots, never bound (the values live in the context),
+	/// script functions are kept as source for the call sites (or compiled once if invoked),
+	/// host functions are kept as registered (the calls refer to them)
+	/// </summary>
+	struct symbol_table
+	{
+		/// <summary>a script function</summary>
+		struct function
+		{
+			/// <summary>parameter names</summary>
+			std::vector<std::string> atParams;
+			/// <summary>the body statements before the return statement, the returned expression</summary>
+			std::vector<std::string> atBody;
+			std::string atReturn;
+			/// <summary>true if invoked, the body compiled once (not inlined at the call sites)</summary>
+			bool bInvoked = false;
+			/// <summary>invoked : the body ending with op_end (jump targets relative to its start), the parameter slots, the result slot</summary>
+			std::vector<ts_instruction> asBody;
+			std::vector<unsigned> auParams;
+			unsigned uResult = 0;
+		};
+
+		/// <param name="asVars">the script variables</param>
+		/// <param name="asBools">the script booleans</param>
+		/// <param name="asHostFunctions">the host functions</param>
+		explicit symbol_table(const std::set<ts_variable>& asVars, const std::set<ts_boolean>& asBools, const std::set<ts_native>& asHostFunctions)
+			: asNatives(asHostFunctions.begin(), asHostFunctions.end())
+		{
+			apfVars.reserve(asVars.size());
+			asBindings.reserve(asVars.size());
+			for (const ts_variable& s : asVars)
+			{
+				atVarNames.push_back(s.m_name);
+				apfVars.push_back(s.m_value);
+
+				// name, value, type, context
+				asBindings.push_back({ s.m_name, s.m_value, s.m_type, nullptr });
+			}
+			apbBools.reserve(asBools.size());
+			for (const ts_boolean& s : asBools)
+			{
+				atBoolNames.push_back(s.atName);
+				apbBools.push_back(s.pbValue);
+			}
+			uHostVars = (unsigned)apfVars.size();
+			uHostBools = (unsigned)apbBools.size();
+			index_names(0);
+		}
+		symbol_table(const symbol_table&) = delete;
+		symbol_table& operator=(const symbol_table&) = delete;
+
+		/// <summary>variable names, index is the slot index (a deque, the name index refers to the names)</summary>
+		std::deque<std::string> atVarNames;
+		/// <summary>variable addresses, index is the slot index</summary>
+		std::vector<te_type*> apfVars;
+		/// <summary>TinyExpr variable bindings, index is the slot index</summary>
+		std::vector<te_variable> asBindings;
+		/// <summary>boolean names, index is the slot index</summary>
+		std::deque<std::string> atBoolNames;
+		/// <summary>boolean addresses, index is the slot index</summary>
+		std::vector<bool*> apbBools;
+		/// <summary>number of host variable slots, the local slots follow</summary>
+		unsigned uHostVars = 0;
+		/// <summary>number of host boolean slots, the local slots follow</summary>
+		unsigned uHostBools = 0;
+		/// <summary>function names, index is the function index</summary>
+		std::deque<std::string> atFunctionNames;
+		/// <summary>the functions, index is the function index</summary>
+		std::vector<function> asFunctions;
+		/// <summary>the host functions, index is the host function index (never resized, the calls refer to them)</summary>
+		const std::vector<ts_native> asNatives;
+
+		/// <summary>all names by hash, refer to atVarNames, atBoolNames, aatKeywords, ts_builtins(), asNatives and atFunctionNames</summary>
+		name_index sNames;
+
+		/// <summary>slot of a host variable name, -1 if not found</summary>
+		int find_var(std::string_view atName) const
+		{
+			const name_index::entry* ps = sNames.find(atName, name_index::kind::variable);
+			return ((ps) && (ps->uIx < uHostVars)) ? (int)ps->uIx : -1;
+		}
+		/// <summary>slot of a host boolean name, -1 if not found</summary>
+		int find_bool(std::string_view atName) const
+		{
+			const name_index::entry* ps = sNames.find(atName, name_index::kind::boolean);
+			return ((ps) && (ps->uIx < uHostBools)) ? (int)ps->uIx : -1;
+		}
+
+		/// <summary>true if the variable slot exists (the address is bound by the context)</summary>
+		bool has_var(unsigned uIx) const { return uIx < apfVars.size(); }
+		/// <summary>true if the boolean slot exists (the address is bound by the context)</summary>
+		bool has_bool(unsigned uIx) const { return uIx < apbBools.size(); }
+
+		/// <summary>add a local slot, not bound and not named in the index</summary>
+		/// <returns>the slot index</returns>
+		unsigned add_local(std::string_view atName, bool bBoolean)
+		{
+			if (bBoolean)
+			{
+				atBoolNames.emplace_back(atName);
+				apbBools.push_back(nullptr);
+				return (unsigned)apbBools.size() - 1;
+			}
+			atVarNames.emplace_back(atName);
+			apfVars.push_back(nullptr);
+			asBindings.push_back({ atVarNames.back(), static_cast<const te_type*>(nullptr), TE_DEFAULT, nullptr });
+			return (unsigned)apfVars.size() - 1;
+		}
+
+		/// <summary>declare a script local, visible until its scope ends</summary>
+		/// <param name="atName">the local name, no name visible yet</param>
+		/// <param name="bBoolean">true for a boolean local</param>
+		/// <param name="uLevel">the block level of the declaration</param>
+		/// <returns>the slot index, -1 if the name is taken</returns>
+		int declare(std::string_view atName, bool bBoolean, unsigned uLevel)
+		{
+			if (sNames.find(atName)) return -1;
+			unsigned uSlot = add_local(atName, bBoolean);
+			asScope.push_back({ uLevel, bBoolean, uSlot });
+			if (sNames.room())
+				sNames.insert(bBoolean ? atBoolNames[uSlot] : atVarNames[uSlot], bBoolean ? name_index::kind::boolean : name_index::kind::variable, uSlot);
+			else
+				index_names(1);
+			return (int)uSlot;
+		}
+
+		/// <summary>number of locals in scope</summary>
+		size_t scope() const { return asScope.size(); }
+
+		/// <summary>hide the locals declared after the first uScope ones</summary>
+		void leave(size_t uScope)
+		{
+			while (asScope.size() > uScope)
+			{
+				const local& s = asScope.back();
+				if (s.bBoolean)
+					sNames.hide(atBoolNames[s.uSlot], name_index::kind::boolean, s.uSlot);
+				else
+					sNames.hide(atVarNames[s.uSlot], name_index::kind::variable, s.uSlot);
+				asScope.pop_back();
+			}
+		}
+
+		/// <summary>hide the locals of blocks above this level</summary>
+		void end_scope(unsigned uLevel)
+		{
+			size_t uScope = asScope.size();
+			while ((uScope > 0) && (asScope[uScope - 1].uLevel > uLevel)) uScope--;
+			leave(uScope);
+		}
+
+		/// <summary>define a script function, visible from here on (the name not visible yet)</summary>
+		void define(std::string_view atName, function&& sFunction)
+		{
+			atFunctionNames.emplace_back(atName);
+			asFunctions.push_back(std::move(sFunction));
+			if (sNames.room())
+				sNames.insert(atFunctionNames.back(), name_index::kind::function, (unsigned)asFunctions.size() - 1);
+			else
+				index_names(1);
+		}
+
+		/// <summary>a function body compiles : the slots so far and the functions from uFunctions on are hidden</summary>
+		/// <returns>the names visible before, see leave_function()</returns>
+		name_index::visibility enter_function(unsigned uFunctions)
+		{
+			name_index::visibility sBefore = sNames.sVisible;
+			sNames.sVisible = { (unsigned)apfVars.size(), (unsigned)apbBools.size(), uFunctions };
+			return sBefore;
+		}
+		/// <summary>the function body compiled, the names visible before are visible again</summary>
+		void leave_function(const name_index::visibility& sBefore) { sNames.sVisible = sBefore; }
+
+	private:
+		/// <summary>a local in scope</summary>
+		struct local
+		{
+			/// <summary>block level of the declaration</summary>
+			unsigned uLevel;
+			/// <summary>true for a boolean local</summary>
+			bool bBoolean;
+			/// <summary>the slot index</summary>
+			unsigned uSlot;
+		};
+
+		/// <summary>(re)build the index in lookup order, the host names, keywords, builtins, host functions, the locals in scope and the functions</summary>
+		void index_names(size_t uMore)
+		{
+			const auto& asBuiltins = ts_builtins();
+			sNames.reserve(uHostVars + uHostBools + aatKeywords.size() + asBuiltins.size() + asNatives.size() + (asScope.size() + atFunctionNames.size() + uMore) * 2);
+			for (unsigned uIx = 0; uIx < uHostVars; uIx++)
+				sNames.insert(atVarNames[uIx], name_index::kind::variable, uIx);
+			for (unsigned uIx = 0; uIx < uHostBools; uIx++)
+				sNames.insert(atBoolNames[uIx], name_index::kind::boolean, uIx);
+			for (size_t uIx = 0; uIx < aatKeywords.size(); uIx++)
+				sNames.insert(aatKeywords[uIx], name_index::kind::keyword, (unsigned)uIx);
+			for (size_t uIx = 0; uIx < asBuiltins.size(); uIx++)
+				sNames.insert(asBuiltins[uIx].atName, name_index::kind::builtin, (unsigned)uIx);
+			for (size_t uIx = 0; uIx < asNatives.size(); uIx++)
+				sNames.insert(asNatives[uIx].atName, name_index::kind::native, (unsigned)uIx);
+			for (const local& s : asScope)
+				sNames.insert(s.bBoolean ? atBoolNames[s.uSlot] : atVarNames[s.uSlot], s.bBoolean ? name_index::kind::boolean : name_index::kind::variable, s.uSlot);
+			for (size_t uIx = 0; uIx < atFunctionNames.size(); uIx++)
+				sNames.insert(atFunctionNames[uIx], name_index::kind::function, (unsigned)uIx);
+		}
+
+		/// <summary>locals in scope, in declaration order</summary>
+		std::vector<local> asScope;
+	};
+
+	/// <summary>
+	/// TinyExpr++ evaluated expression, used for expressions not compiled inline
+	/// (the parser is bound to shadow values copied from the variable slots)
+	/// </summary>
+	struct tinyexpr_fallback
+	{
+		/// <summary>bind the slots to new shadow values and compile the expression</summary>
+		bool compile(const symbol_table& sSymbols)
+		{
+			afShadow = std::make_unique<te_type[]>(auSlots.size());
+			std::set<te_variable> asTE;
+			for (size_t uIx = 0; uIx < auSlots.size(); uIx++)
+			{
+				te_variable sTE = sSymbols.asBindings[auSlots[uIx]];
+				sTE.m_value = (const te_type*)&afShadow[uIx];
+				asTE.insert(sTE);
+			}
+			cTEP.set_variables_and_functions(asTE);
+			return cTEP.compile(atExpression);
+		}
+
+		/// <summary>the expression</summary>
+		std::string atExpression;
+		/// <summary>TinyExpr parser</summary>
+		te_parser cTEP;
+		/// <summary>variable slots read by the expression</summary>
+		std::vector<unsigned> auSlots;
+		/// <summary>shadow values bound to the parser, index equals auSlots index</summary>
+		std::unique_ptr<te_type[]> afShadow;
+	};
+
+	/// <summary>call of a host function : the function (owned by the symbol table) and the argument registers</summary>
+	struct native_call
+	{
+		/// <summary>the function</summary>
+		const ts_native* psFunction;
+		/// <summary>the argument registers, one per parameter</summary>
+		std::vector<unsigned> auArgs;
+	};
+
+	/// <summary>instruction stream and register frame of the compiled script</summary>
+	struct bytecode
+	{
+		/// <summary>add an instruction, returns its index</summary>
+		unsigned emit(ts_opcode eOp, unsigned uA, unsigned uB, unsigned uC)
+		{
+			asCode.push_back({ eOp, uA, uB, uC });
+			return (unsigned)asCode.size() - 1;
+		}
+		/// <summary>add a register to the frame</summary>
+		unsigned new_register()
+		{
+			afFrame.push_back((te_type)0);
+			return (unsigned)afFrame.size() - 1;
+		}
+		/// <summary>add a call of host function uFunction, returns the result register</summary>
+		unsigned call_native(const ts_native* psFunction, unsigned uFunction, std::vector<unsigned> auArgs)
+		{
+			asNatives.push_back({ psFunction, std::move(auArgs) });
+			unsigned uReg = new_register();
+			emit(ts_opcode::op_native, uReg, (unsigned)asNatives.size() - 1, uFunction);
+			return uReg;
+		}
+		/// <summary>get the (constant) register for this value</summary>
+		unsigned constant(te_type fValue)
+		{
+			uint64_t uBits = 0;
+			std::memcpy(&uBits, &fValue, sizeof(te_type));
+			auto ps = auConstants.find(uBits);
+			if (ps != auConstants.end())
+				return ps->second;
+
+			unsigned uReg = new_register();
+			afFrame[uReg] = fValue;
+			auConstants[uBits] = uReg;
+			return uReg;
+		}
+
+		/// <summary>sizes of the instructions, the register frame, the expressions and the host function calls (see roll_back())</summary>
+		struct mark
+		{
+			size_t uCode, uFrame, uFallbacks, uNatives;
+		};
+		/// <summary>the current sizes</summary>
+		mark position() const { return { asCode.size(), afFrame.size(), apsFallbacks.size(), asNatives.size() }; }
+		/// <summary>remove everything added after the mark, the constant registers included</summary>
+		void roll_back(const mark& sMark)
+		{
+			asCode.resize(sMark.uCode);
+			afFrame.resize(sMark.uFrame);
+			apsFallbacks.resize(sMark.uFallbacks);
+			asNatives.resize(sMark.uNatives);
+			for (auto ps = auConstants.begin(); ps != auConstants.end();)
+				ps = (ps->second >= sMark.uFrame) ? auConstants.erase(ps) : std::next(ps);
+		}
+
+		/// <summary>the instructions</summary>
+		std::vector<ts_instruction> asCode;
+		/// <summary>initial register frame (constants preset)</summary>
+		std::vector<te_type> afFrame;
+		/// <summary>constant registers by value bits</summary>
+		std::unordered_map<uint64_t, unsigned> auConstants;
+		/// <summary>TinyExpr++ evaluated expressions</summary>
+		std::vector<std::shared_ptr<tinyexpr_fallback>> apsFallbacks;
+		/// <summary>host function calls, one per op_native</summary>
+		std::vector<native_call> asNatives;
+	};
+
+	/// <summary>
+	/// dependency graph of the compiled script, resolved to the instructions each slot reaches
+	/// (one bit per instruction, one sparse row per variable slot and per boolean slot, a row always executed)
+	/// </summary>
+	struct dependencies
+	{
+		/// <summary>or the row of a slot to an instruction mask (variable slots first, then boolean slots)</summary>
+		void combine(size_t uSlot, uint64_t* puMask) const
+		{
+			// locals, the mask words could alias the vector members
+			const unsigned* puWords = auWords.data();
+			const uint64_t* puBits = auBits.data();
+			for (size_t uE = auRowBegin[uSlot], uEnd = auRowBegin[uSlot + 1]; uE < uEnd; uE++)
+				puMask[puWords[uE]] |= puBits[uE];
+		}
+
+		/// <summary>store the slot rows contiguous, the non zero words of each row ordered by word index</summary>
+		void assign(const std::vector<std::vector<std::pair<unsigned, uint64_t>>>& aasRows)
+		{
+			auRowBegin.assign(1, 0);
+			auWords.clear();
+			auBits.clear();
+			for (const std::vector<std::pair<unsigned, uint64_t>>& asRow : aasRows)
+			{
+				for (const std::pair<unsigned, uint64_t>& sW : asRow)
+				{
+					auWords.push_back(sW.first);
+					auBits.push_back(sW.second);
+				}
+				auRowBegin.push_back(auWords.size());
+			}
+		}
+
+		/// <summary>64 bit words per instruction mask</summary>
+		size_t uWords = 0;
+		/// <summary>the row always executed</summary>
+		std::vector<uint64_t> auAlways;
+		/// <summary>first entry of each slot row, one more for the end</summary>
+		std::vector<size_t> auRowBegin;
+		/// <summary>entries of the slot rows, the non zero words, word index and bits</summary>
+		std::vector<unsigned> auWords;
+		std::vector<uint64_t> auBits;
+	};
+
+	/// <summary>
+	/// tasks of the parallel evaluation, parts of the program ordered by their dependencies
+	/// (a task waits for its predecessors, then executes its instruction ranges in program order)
+	/// </summary>
+	struct schedule
+	{
+		/// <summary>a part of the program</summary>
+		struct task
+		{
+			/// <summary>instruction ranges, begin and end</summary>
+			std::vector<std::pair<unsigned, unsigned>> asRanges;
+			/// <summary>tasks waiting for this task</summary>
+			std::vector<unsigned> auSuccessors;
+			/// <summary>number of tasks this task waits for</summary>
+			unsigned uPredecessors = 0;
+		};
+
+		/// <summary>the tasks, predecessors first</summary>
+		std::vector<task> asTasks;
+		/// <summary>true if the work besides the critical path exceeds uParallelWork</summary>
+		bool bParallel = false;
+	};
+
+	/// <summary>
+	/// splits the script in one pass into statements and curly braces, while reading the chunks :
+	/// comments removed, whitespace as single spaces, statements end at ";" and at curly braces,
+	/// one line "if" statements and "else" branches get a block up to their statement end
+	/// </summary>
+	class script_lexer
+	{
+	public:
+		/// <summary>kinds of pieces</summary>
+		enum struct piece_type : unsigned
+		{
+			statement,
+			block_begin,
+			block_end,
+			line_begin,
+			line_end,
+			else_branch
+		};
+
+		/// <param name="_cSource">the script code</param>
+		explicit script_lexer(ts_source& _cSource) : cSource(_cSource) {}
+
+		/// <summary>
+		/// the next statement, curly brace, block of a one line statement or "else" keyword
+		/// (the statement valid until the next call)
+		/// </summary>
+		/// <returns>false at the end of the script</returns>
+		bool next(piece_type& eType, std::string_view& atPiece)
+		{
+			while (uFront == asPieces.size())
+			{
+				asPieces.clear();
+				atPieces.clear();
+				uFront = 0;
+				if (bEnd) return false;
+				if (uChunk == atChunk.size())
+				{
+					atChunk = cSource.next();
+					uChunk = 0;
+					if (atChunk.empty())
+					{
+						// pending slash, open statement and one line blocks
+						if (bSlash) split('/');
+						end_statement();
+						bEnd = true;
+						continue;
+					}
+				}
+				read(atChunk[uChunk++]);
+			}
+			eType = asPieces[uFront].eType;
+			atPiece = std::string_view(atPieces).substr(asPieces[uFront].uOffset, asPieces[uFront].uSize);
+			uFront++;
+			return true;
+		}
+
+	private:
+		/// <summary>position within the "if", "while" or "for" statement</summary>
+		enum struct if_part
+		{
+			none,
+			condition,
+			after_condition,
+			after_else
+		};
+
+		/// <summary>remove comments, whitespace and comments separate as a single space</summary>
+		void read(char c)
+		{
+			if (bSingleLine)
+			{
+				if (c == '\n')
+				{
+					bSingleLine = false;
+					read(' ');
+				}
+			}
+			else if (bMultiLine)
+			{
+				if ((bStar) && (c == '/'))
+				{
+					bMultiLine = false;
+					read(' ');
+				}
+				bStar = (c == '*') && (bMultiLine);
+			}
+			else if (bSlash)
+			{
+				bSlash = false;
+				if (c == '/') bSingleLine = true;
+				else if (c == '*')
+				{
+					bMultiLine = true;
+					bStar = false;
+				}
+				else
+				{
+					bSpace = false;
+					split('/');
+					read(c);
+				}
+			}
+			else if (c == '/')
+				bSlash = true;
+			else if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\v') || (c == '\f'))
+			{
+				if (!bSpace) split(' ');
+				bSpace = true;
+			}
+			else if (c != '\0')
+			{
+				bSpace = false;
+				split(c);
+			}
+		}
+
+		/// <summary>split into statements and curly braces</summary>
+		void split(char c)
+		{
+			switch (c)
+			{
+			case ';':
+				// the parts of a loop header stay within the statement
+				if ((eIf == if_part::condition) && (uParentheses > 0))
+					break;
+				end_statement();
+				return;
+			case '{':
+				add_statement();
+				add_piece(piece_type::block_begin);
+				auOneLine.push_back(0);
+				return;
+			case '}':
+				// the block ends the statement it belongs to
+				end_statement();
+				add_piece(piece_type::block_end);
+				if (auOneLine.size() > 1) auOneLine.pop_back();
+				end_statement();
+				return;
+			default:
+				break;
+			}
+
+			switch (eIf)
+			{
+			case if_part::none:
+				// "if", "while" or "for" keyword at statement start ?
+				if ((atStatement.empty()) && (c == ' ')) return;
+				if (((atStatement == "if") || (atStatement == "while") || (atStatement == "for")) && (!isalnum((unsigned char)c)) && (c != '_'))
+				{
+					eIf = if_part::condition;
+					uParentheses = 0;
+					split(c);
+					return;
+				}
+				// "else" keyword, the branch follows
+				if ((atStatement == "else") && (!isalnum((unsigned char)c)) && (c != '_'))
+				{
+					add_statement();
+					eIf = if_part::after_else;
+					split(c);
+					return;
+				}
+				atStatement += c;
+				return;
+			case if_part::condition:
+				atStatement += c;
+				if (c == '(') uParentheses++;
+				else if ((c == ')') && (uParentheses > 0) && (--uParentheses == 0)) eIf = if_part::after_condition;
+				return;
+			case if_part::after_condition:
+				// a statement without braces follows, or the condition continues
+				if ((isalpha((unsigned char)c)) || (c == '_'))
+				{
+					add_statement();
+					add_piece(piece_type::line_begin);
+					auOneLine.back()++;
+					split(c);
+				}
+				else if (c == ' ')
+					atStatement += c;
+				else
+				{
+					eIf = if_part::condition;
+					split(c);
+				}
+				return;
+			case if_part::after_else:
+				// a statement without braces follows ("else if" as well)
+				if (c == ' ') return;
+				add_piece(piece_type::line_begin);
+				auOneLine.back()++;
+				eIf = if_part::none;
+				split(c);
+				return;
+			}
+		}
+
+		/// <summary>add the current statement without surrounding spaces (if not empty), the "else" keyword as its piece</summary>
+		void add_statement()
+		{
+			while ((atStatement.size()) && (atStatement.back() == ' ')) atStatement.pop_back();
+			if (atStatement == "else") add_piece(piece_type::else_branch);
+			else if (atStatement.size()) add_piece(piece_type::statement, atStatement);
+			atStatement.clear();
+			eIf = if_part::none;
+		}
+
+		/// <summary>append a piece to the pieces buffer</summary>
+		void add_piece(piece_type eType, std::string_view at = {})
+		{
+			asPieces.push_back({ eType, atPieces.size(), at.size() });
+			atPieces.append(at);
+		}
+
+		/// <summary>add the current statement, close the blocks of one line statements of this level</summary>
+		void end_statement()
+		{
+			add_statement();
+			for (; auOneLine.back() > 0; auOneLine.back()--) add_piece(piece_type::line_end);
+		}
+
+		/// <summary>the script code</summary>
+		ts_source& cSource;
+		/// <summary>the current chunk and the position within</summary>
+		std::string_view atChunk;
+		size_t uChunk = 0;
+		/// <summary>pieces split, not yet returned (statements by offset and size within atPieces, buffers reused for all pieces)</summary>
+		struct piece
+		{
+			piece_type eType;
+			size_t uOffset, uSize;
+		};
+		std::vector<piece> asPieces;
+		std::string atPieces;
+		size_t uFront = 0;
+		/// <summary>the statement read so far</summary>
+		std::string atStatement;
+		/// <summary>comment state, a slash waiting for the next character</summary>
+		bool bSingleLine = false, bMultiLine = false, bStar = false, bSlash = false;
+		/// <summary>the last character split was a space (a run of whitespace splits one)</summary>
+		bool bSpace = false;
+		/// <summary>position within an "if", "while" or "for" statement, open parentheses of the condition (the loop header)</summary>
+		if_part eIf = if_part::none;
+		unsigned uParentheses = 0;
+		/// <summary>blocks of one line statements per curly brace level, closed at the statement end</summary>
+		std::vector<unsigned> auOneLine = { 0 };
+		/// <summary>end of the script reached</summary>
+		bool bEnd = false;
+	};
+
+	/// <summary>if statement, else branch or loop waiting for its block end</summary>
+	struct open_if
+	{
+		/// <summary>loop index of if statements</summary>
+		static constexpr unsigned uNoLoop = ~0u;
+
+		/// <summary>block level of the if statement (of the "else" keyword for an else branch)</summary>
+		unsigned uLevel;
+		/// <summary>index of the conditional jump instruction (the jump over the else branch)</summary>
+		unsigned uJump;
+		/// <summary>loops : index of the loop entry instruction, the step statement of a "for" loop, the locals in scope before the loop</summary>
+		unsigned uLoop = uNoLoop;
+		std::string atStep = {};
+		size_t uScope = 0;
+	};
+
+	/// <summary>state in the current statement compilation process</summary>
+	struct state
+	{
+		/// <param name="_atStatement">the statement string, a span of the script (not copied)</param>
+		/// <param name="_sSymbols">the script symbol table</param>
+		explicit state(std::string_view _atStatement, const symbol_table& _sSymbols)
+			: atStatement(_atStatement)
+			, sSymbols(_sSymbols)
+		{
+		}
+
+		/// <summary>possible comparisation tokens</summary>
+		enum struct token_compare_type : unsigned
+		{
+			TOK_EQUAL = 1,
+			TOK_UNEQUAL,
+			TOK_GREATER,
+			TOK_LESS,
+			TOK_GREATER_EQUAL,
+			TOK_LESS_EQUAL,
+			TOK_AND,
+			TOK_OR
+		};
+
+		/// <summary>possible token type enumeration</summary>
+		enum struct token_type : unsigned
+		{
+			TOK_NULL = 0,
+			TOK_EQUAL = (unsigned)token_compare_type::TOK_EQUAL,
+			TOK_UNEQUAL = (unsigned)token_compare_type::TOK_UNEQUAL,
+			TOK_GREATER = (unsigned)token_compare_type::TOK_GREATER,
+			TOK_LESS = (unsigned)token_compare_type::TOK_LESS,
+			TOK_GREATER_EQUAL = (unsigned)token_compare_type::TOK_GREATER_EQUAL,
+			TOK_LESS_EQUAL = (unsigned)token_compare_type::TOK_LESS_EQUAL,
+			TOK_AND = (unsigned)token_compare_type::TOK_AND,
+			TOK_OR = (unsigned)token_compare_type::TOK_OR,
+			TOK_ERROR,
+			TOK_END,
+			TOK_OPEN,
+			TOK_CLOSE,
+			TOK_OPEN_CURLY,
+			TOK_CLOSE_CURLY,
+			TOK_NUMBER,
+			TOK_IF,
+			TOK_ELSE,
+			TOK_WHILE,
+			TOK_FOR,
+			TOK_DECLARE_FLOAT,
+			TOK_DECLARE_BOOL,
+			TOK_FUNC,
+			TOK_RETURN,
+			TOK_VAR_FLOAT,
+			TOK_VAR_BOOL,
+			TOK_ASSIGN,
+			TOK_TRUE,
+			TOK_FALSE,
+			TOK_PLUS,
+			TOK_MINUS,
+			TOK_MUL,
+			TOK_DIV,
+			TOK_MOD,
+			TOK_POW,
+			TOK_COMMA,
+			TOK_FUNCTION,
+			TOK_SCRIPT_FUNCTION,
+			TOK_NATIVE
+		};
+
+		/// <summary>get the next token in current statement stream</summary>
+		void next_token()
+		{
+			eType = token_type::TOK_NULL;
+
+			do
+			{
+				// end of expression
+				if (uNext >= atStatement.size())
+				{
+					eType = token_type::TOK_END;
+					return;
+				}
+
+				// Try reading a number
+				if ((peek() >= '0' && peek() <= '9') || peek() == '.')
+				{
+					pop_number();
+				}
+				else
+				{
+					// Look for a variable or builtin function call.
+					if (isalpha(peek()))
+					{
+						pop_vocable();
+					}
+					else
+					{
+						// Look for operator or special.. otherwise move forward or throw error
+						pop_operator();
+					}
+				}
+			} while (eType == token_type::TOK_NULL);
+		}
+		/// <summary>get current token type</summary>
+		token_type get_type() { return eType; }
+		/// <summary>get remaining statement string</summary>
+		std::string_view remaining() { return atStatement.substr(uNext); }
+		/// <summary>get the value unsigned (usually an index)</summary>
+		unsigned value_unsigned() { return std::get<unsigned>(sValue); }
+		/// <summary>get the value floating</summary>
+		te_type value_floating() { return std::get<te_type>(sValue); }
+
+	private:
+		/// <summary>peek next character in expression</summary>
+		char peek() { if (uNext < atStatement.size()) return atStatement[uNext]; else return 0; }
+		/// <summary>pop next character in expression</summary>
+		char pop() { if (uNext++ < atStatement.size()) return atStatement[uNext - 1]; else return 0; }
+		/// <summary>pop next number in expression (as std::stof() / std::stod() would read it, hexadecimal after "0x")</summary>
+		void pop_number()
+		{
+			const char* pcBegin = atStatement.data() + uNext, * pcEnd = atStatement.data() + atStatement.size();
+			std::chars_format eFormat = std::chars_format::general;
+			if ((pcEnd - pcBegin > 2) && (pcBegin[0] == '0') && ((pcBegin[1] == 'x') || (pcBegin[1] == 'X')) && (isxdigit((unsigned char)pcBegin[2]) || (pcBegin[2] == '.')))
+			{
+				pcBegin += 2;
+				eFormat = std::chars_format::hex;
+			}
+
+			te_type fRet = 0;
+			std::from_chars_result sR = std::from_chars(pcBegin, pcEnd, fRet, eFormat);
+			if (sR.ec != std::errc())
+			{
+				// no valid number or out of range, skip the character
+				uNext++;
+				eType = token_type::TOK_ERROR;
+				return;
+			}
+			uNext = (size_t)(sR.ptr - atStatement.data());
+			sValue = fRet;
+			eType = token_type::TOK_NUMBER;
+		}
+		/// <summary>pop next vocable</summary>
+		void pop_vocable()
+		{
+			size_t uStart = uNext;
+			while (isalpha(peek()) || isdigit(peek()) || (peek() == '_')) uNext++;
+			std::string_view at = atStatement.substr(uStart, uNext - uStart);
+
+			// one lookup, variables first, then booleans, keywords, builtins, host functions and script functions
+			const name_index::entry* ps = sSymbols.sNames.find(at);
+			if (!ps)
+			{
+				eType = token_type::TOK_ERROR;
+				return;
+			}
+			switch (ps->eKind)
+			{
+			case name_index::kind::variable:
+				sValue = ps->uIx;
+				eType = token_type::TOK_VAR_FLOAT;
+				break;
+			case name_index::kind::boolean:
+				sValue = ps->uIx;
+				eType = token_type::TOK_VAR_BOOL;
+				break;
+			case name_index::kind::builtin:
+				sValue = ps->uIx;
+				eType = token_type::TOK_FUNCTION;
+				break;
+			case name_index::kind::function:
+				sValue = ps->uIx;
+				eType = token_type::TOK_SCRIPT_FUNCTION;
+				break;
+			case name_index::kind::native:
+				sValue = ps->uIx;
+				eType = token_type::TOK_NATIVE;
+				break;
+			case name_index::kind::keyword:
+				switch (ps->uIx)
+				{
+				case 0: eType = token_type::TOK_IF; break;
+				case 1: eType = token_type::TOK_ELSE; break;
+				case 2: eType = token_type::TOK_TRUE; break;
+				case 3: eType = token_type::TOK_FALSE; break;
+				case 4:
+					sValue = (te_type)3.14159265358979323846;
+					eType = token_type::TOK_NUMBER;
+					break;
+				case 5:
+					sValue = (te_type)2.71828182845904523536;
+					eType = token_type::TOK_NUMBER;
+					break;
+				case 6: eType = token_type::TOK_WHILE; break;
+				case 7: eType = token_type::TOK_FOR; break;
+				case 8: eType = token_type::TOK_DECLARE_FLOAT; break;
+				case 9: eType = token_type::TOK_DECLARE_BOOL; break;
+				case 10: eType = token_type::TOK_FUNC; break;
+				default: eType = token_type::TOK_RETURN; break;
+				}
+				break;
+			case name_index::kind::hidden:
+				eType = token_type::TOK_ERROR;
+				break;
+			}
+		}
+		/// <summary>
+		/// Look for an operator or special character. 
+		/// (or move forward or throw error for unknown character)
+		/// </summary>
+		void pop_operator()
+		{
+			std::array<char, 2> at = { pop(),  peek() };
+			switch (at[0])
+			{
+			case '(': eType = token_type::TOK_OPEN; break;
+			case ')': eType = token_type::TOK_CLOSE; break;
+			case '{': eType = token_type::TOK_OPEN_CURLY; break;
+			case '}': eType = token_type::TOK_CLOSE_CURLY; break;
+			case '+': eType = token_type::TOK_PLUS; break;
+			case '-': eType = token_type::TOK_MINUS; break;
+			case '*': eType = token_type::TOK_MUL; break;
+			case '/': eType = token_type::TOK_DIV; break;
+			case '%': eType = token_type::TOK_MOD; break;
+			case '^': eType = token_type::TOK_POW; break;
+			case ',': eType = token_type::TOK_COMMA; break;
+			case '&':
+				if (at[1] == '&')
+				{
+					eType = token_type::TOK_AND;
+					pop();
+				}
+				else
+				{
+					// integer operations not supported currently
+					eType = token_type::TOK_ERROR;
+				}
+				break;
+			case '|':
+				if (at[1] == '|')
+				{
+					eType = token_type::TOK_OR;
+					pop();
+				}
+				else
+				{
+					// integer operations not supported currently
+					eType = token_type::TOK_ERROR;
+				}
+				break;
+			case '=':
+			{
+				if (at[1] == '=')
+				{
+					eType = token_type::TOK_EQUAL;
+					pop();
+				}
+				else
+					eType = token_type::TOK_ASSIGN;
+				break;
+			}
+			case '!':
+			{
+				if (at[1] == '=')
+				{
+					eType = token_type::TOK_UNEQUAL;
+					pop();
+				}
+				else
+					eType = token_type::TOK_ERROR;
+				break;
+			}
+			case '>':
+			{
+				if (at[1] == '=')
+				{
+					eType = token_type::TOK_GREATER_EQUAL;
+					pop();
+				}
+				else
+					eType = token_type::TOK_GREATER;
+				break;
+			}
+			case '<':
+			{
+				if (at[1] == '=')
+				{
+					eType = token_type::TOK_LESS_EQUAL;
+					pop();
+				}
+				else
+					eType = token_type::TOK_LESS;
+				break;
+			}
+
+
+			case ' ': case '\t': case '\n': case '\r': break;
+			default: eType = token_type::TOK_ERROR; break;
+			}
+		}
+		/// <summary>the actual statement</summary>
+		std::string_view atStatement;
+		/// <summary>the script symbol table</summary>
+		const symbol_table& sSymbols;
+		/// <summary>the current value</summary>
+		std::variant<unsigned, te_type, te_type*> sValue;
+		/// <summary>current token type</summary>
+		token_type eType;
+		/// <summary>current character index in the string</summary>
+		size_t uNext = 0;
+	};
+
+	/// <summary>TinyExpr statement class</summary>
+	class ts_statement_float_expr
+	{
+	public:
+		/// <summary>destination index for expressions without destination slot</summary>
+		static constexpr unsigned uNoSlot = ~0u;
+
+		/// <param name="_atStatement">the statement string</param>
+		/// <param name="_psSymbols">shared pointer to the script symbol table</param>
+		/// <param name="sCode">the instruction stream to compile to</param>
+		/// <param name="_uDestIx">destination variable slot or uNoSlot</param>
+		ts_statement_float_expr(std::string_view _atStatement,
+			const std::shared_ptr<symbol_table>& _psSymbols,
+			bytecode& sCode,
+			unsigned _uDestIx
+		)
+			: psSymbols(_psSymbols)
+		{
+			if ((_uDestIx != uNoSlot) && (!_psSymbols->has_var(_uDestIx)))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			// compile inline, use TinyExpr++ for anything not supported
+			unsigned uReg = 0;
+			bytecode::mark sMark = sCode.position();
+			state sState(_atStatement, *_psSymbols);
+			sState.next_token();
+			if (!compile_list(sState, sCode, uReg) || (sState.get_type() != state::token_type::TOK_END))
+			{
+				sCode.roll_back(sMark);
+				if (!compile_tinyexpr(_atStatement, _psSymbols, sCode, uReg))
+					return;
+			}
+
+			uResult = uReg;
+			if (_uDestIx != uNoSlot)
+				sCode.emit(ts_opcode::op_store_var, _uDestIx, uReg, 0);
+		}
+		/// <summary></summary>
+		int64_t error() { return nErr; }
+		/// <summary>register holding the expression result</summary>
+		unsigned result() { return uResult; }
+
+	private:
+		/// <summary>list : sum {"," sum}</summary>
+		bool compile_list(state& sState, bytecode& sCode, unsigned& uReg)
+		{
+			if (!compile_sum(sState, sCode, uReg)) return false;
+			while (sState.get_type() == state::token_type::TOK_COMMA)
+			{
+				sState.next_token();
+				if (!compile_sum(sState, sCode, uReg)) return false;
+			}
+			return true;
+		}
+		/// <summary>sum : term {("+" | "-") term}</summary>
+		bool compile_sum(state& sState, bytecode& sCode, unsigned& uReg)
+		{
+			if (!compile_term(sState, sCode, uReg)) return false;
+			for (;;)
+			{
+				ts_opcode eOp;
+				switch (sState.get_type())
+				{
+				case state::token_type::TOK_PLUS: eOp = ts_opcode::op_add; break;
+				case state::token_type::TOK_MINUS: eOp = ts_opcode::op_sub; break;
+				default: return true;
+				}
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!compile_term(sState, sCode, uRight)) return false;
+				unsigned uDest = sCode.new_register();
+				sCode.emit(eOp, uDest, uReg, uRight);
+				uReg = uDest;
+			}
+		}
+		/// <summary>term : factor {("*" | "/" | "%") factor}</summary>
+		bool compile_term(state& sState, bytecode& sCode, unsigned& uReg)
+		{
+			if (!compile_factor(sState, sCode, uReg)) return false;
+			for (;;)
+			{
+				ts_opcode eOp;
+				switch (sState.get_type())
+				{
+				case state::token_type::TOK_MUL: eOp = ts_opcode::op_mul; break;
+				case state::token_type::TOK_DIV: eOp = ts_opcode::op_div; break;
+				case state::token_type::TOK_MOD: eOp = ts_opcode::op_mod; break;
+				default: return true;
+				}
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!compile_factor(sState, sCode, uRight)) return false;
+				unsigned uDest = sCode.new_register();
+				sCode.emit(eOp, uDest, uReg, uRight);
+				uReg = uDest;
+			}
+		}
+		/// <summary>factor : power {"^" power} (left to right, as TinyExpr++ by default)</summary>
+		bool compile_factor(state& sState, bytecode& sCode, unsigned& uReg)
+		{
+			if (!compile_power(sState, sCode, uReg)) return false;
+			while (sState.get_type() == state::token_type::TOK_POW)
+			{
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!compile_power(sState, sCode, uRight)) return false;
+				unsigned uDest = sCode.new_register();
+				sCode.emit(ts_opcode::op_pow, uDest, uReg, uRight);
+				uReg = uDest;
+			}
+			return true;
+		}
+		/// <summary>power : {("-" | "+")} base</summary>
+		bool compile_power(state& sState, bytecode& sCode, unsigned& uReg)
+		{
+			bool bNegate = false;
+			while ((sState.get_type() == state::token_type::TOK_PLUS) || (sState.get_type() == state::token_type::TOK_MINUS))
+			{
+				if (sState.get_type() == state::token_type::TOK_MINUS) bNegate = !bNegate;
+				sState.next_token();
+			}
+			if (!compile_base(sState, sCode, uReg)) return false;
+			if (bNegate)
+			{
+				unsigned uDest = sCode.new_register();
+				sCode.emit(ts_opcode::op_neg, uDest, uReg, 0);
+				uReg = uDest;
+			}
+			return true;
+		}
+		/// <summary>
+		/// base : number | variable | function-1 power | function-2 "(" sum "," sum ")" |
+		/// script-function "(" [sum {"," sum}] ")" | host-function "(" [sum {"," sum}] ")" | "(" list ")"
+		/// </summary>
+		bool compile_base(state& sState, bytecode& sCode, unsigned& uReg)
+		{
+			switch (sState.get_type())
+			{
+			case state::token_type::TOK_NUMBER:
+				uReg = sCode.constant(sState.value_floating());
+				sState.next_token();
+				return true;
+			case state::token_type::TOK_VAR_FLOAT:
+			{
+				unsigned uIx = sState.value_unsigned();
+				if (!psSymbols->has_var(uIx)) return false;
+				uReg = sCode.new_register();
+				sCode.emit(ts_opcode::op_load_var, uReg, uIx, 0);
+				sState.next_token();
+				return true;
+			}
+			case state::token_type::TOK_FUNCTION:
+			{
+				unsigned uFunc = sState.value_unsigned();
+				const ts_builtin& sF = ts_builtins()[uFunc];
+				sState.next_token();
+				std::array<unsigned, 2> auArgs = {};
+				if (sF.uArity == 1)
+				{
+					if (!compile_power(sState, sCode, auArgs[0])) return false;
+				}
+				else
+				{
+					if (sState.get_type() != state::token_type::TOK_OPEN) return false;
+					for (unsigned uA = 0; uA < sF.uArity; uA++)
+					{
+						sState.next_token();
+						if (!compile_sum(sState, sCode, auArgs[uA])) return false;
+						if (sState.get_type() != (((uA + 1) < sF.uArity) ? state::token_type::TOK_COMMA : state::token_type::TOK_CLOSE))
+							return false;
+					}
+					sState.next_token();
+				}
+				uReg = sCode.new_register();
+				sCode.emit(sF.eOp, uReg, auArgs[0], (sF.eOp == ts_opcode::op_call) ? uFunc : auArgs[1]);
+				return true;
+			}
+			case state::token_type::TOK_SCRIPT_FUNCTION:
+			case state::token_type::TOK_NATIVE:
+			{
+				bool bNative = (sState.get_type() == state::token_type::TOK_NATIVE);
+				unsigned uFunc = sState.value_unsigned();
+				std::vector<unsigned> auArgs;
+				sState.next_token();
+				if (sState.get_type() != state::token_type::TOK_OPEN) return false;
+				sState.next_token();
+				while (sState.get_type() != state::token_type::TOK_CLOSE)
+				{
+					if ((auArgs.size()) && (sState.get_type() == state::token_type::TOK_COMMA)) sState.next_token();
+					auArgs.push_back(0);
+					if (!compile_sum(sState, sCode, auArgs.back())) return false;
+					if ((sState.get_type() != state::token_type::TOK_COMMA) && (sState.get_type() != state::token_type::TOK_CLOSE)) return false;
+				}
+				sState.next_token();
+				if (bNative)
+				{
+					const ts_native& sF = psSymbols->asNatives[uFunc];
+					if (auArgs.size() != sF.uArity) return false;
+					uReg = sCode.call_native(&sF, uFunc, std::move(auArgs));
+					return true;
+				}
+				ts_function_call cCall(uFunc, auArgs, psSymbols, sCode);
+				uReg = cCall.result();
+				return (cCall.error() == TS_OK);
+			}
+			case state::token_type::TOK_OPEN:
+				sState.next_token();
+				if (!compile_list(sState, sCode, uReg)) return false;
+				if (sState.get_type() != state::token_type::TOK_CLOSE) return false;
+				sState.next_token();
+				return true;
+			default:
+				return false;
+			}
+		}
+		/// <summary>compile the statement as TinyExpr++ expression evaluated by the parser itself</summary>
+		bool compile_tinyexpr(std::string_view _atStatement, const std::shared_ptr<const symbol_table>& _psSymbols, bytecode& sCode, unsigned& uReg)
+		{
+			std::shared_ptr<tinyexpr_fallback> psF = std::make_shared<tinyexpr_fallback>();
+
+			// collect the variable slots referenced by this statement, host functions are not known to TinyExpr++
+			state sState(_atStatement, *_psSymbols);
+			do
+			{
+				sState.next_token();
+				if (sState.get_type() == state::token_type::TOK_VAR_FLOAT)
+					psF->auSlots.push_back(sState.value_unsigned());
+				else if (sState.get_type() == state::token_type::TOK_NATIVE)
+				{
+					nErr = TS_FAIL;
+					return false;
+				}
+			} while (sState.get_type() != state::token_type::TOK_END);
+			std::sort(psF->auSlots.begin(), psF->auSlots.end());
+			psF->auSlots.erase(std::unique(psF->auSlots.begin(), psF->auSlots.end()), psF->auSlots.end());
+			for (unsigned uIx : psF->auSlots)
+			{
+				if (!_psSymbols->has_var(uIx))
+				{
+					nErr = TS_FAIL;
+					return false;
+				}
+			}
+
+			// bind these to the shadow values and compile
+			psF->atExpression = std::string(_atStatement);
+			if (!psF->compile(*_psSymbols))
+			{
+				// error compiling (position zero is an error as well)
+				nErr = psF->cTEP.get_last_error_position();
+				if (nErr == TS_OK) nErr = TS_FAIL;
+				return false;
+			}
+
+			sCode.apsFallbacks.push_back(psF);
+			uReg = sCode.new_register();
+			sCode.emit(ts_opcode::op_tinyexpr, uReg, (unsigned)sCode.apsFallbacks.size() - 1, 0);
+			return true;
+		}
+
+		/// <summary>the script symbol table</summary>
+		std::shared_ptr<symbol_table> psSymbols;
+		/// <summary>register holding the expression result</summary>
+		unsigned uResult = 0;
+		/// <summary>0 if statement compiled</summary>
+		int64_t nErr = TS_OK;
+	};
+
+	/// <summary>
+	/// TinyScript boolean expression statement class,
+	/// parsed to an expression graph (equal sub-expressions shared) and lowered to instructions
+	/// precedence (lowest first) : "||", "&&", "==" "!=", "<" ">" "<=" ">=", then arithmetic as floating point statements
+	/// "&&" and "||" short-circuit, the right operand is skipped if the left one decides
+	/// </summary>
+	class ts_statement_bool_expr
+	{
+	public:
+		/// <summary>destination index for expressions without destination slot</summary>
+		static constexpr unsigned uNoSlot = ~0u;
+
+		/// <param name="_atStatement">the statement string</param>
+		/// <param name="_psSymbols">shared pointer to the script symbol table</param>
+		/// <param name="_sCode">the instruction stream to compile to</param>
+		/// <param name="_uDestIx">destination boolean slot or uNoSlot</param>
+		ts_statement_bool_expr(std::string_view _atStatement,
+			const std::shared_ptr<symbol_table>& _psSymbols,
+			bytecode& _sCode,
+			unsigned _uDestIx
+		)
+			: psSymbols(_psSymbols)
+			, sCode(_sCode)
+		{
+			if ((_uDestIx != uNoSlot) && (!_psSymbols->has_bool(_uDestIx)))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			state sState(_atStatement, *_psSymbols);
+			sState.next_token();
+			if (sState.get_type() == state::token_type::TOK_END)
+			{
+				// empty expression, destination is not changed (conditions are false)
+				uResult = sCode.constant((te_type)0);
+				return;
+			}
+
+			// parse to the expression graph
+			unsigned uRoot = 0;
+			if (!parse_or(sState, uRoot) || (sState.get_type() != state::token_type::TOK_END))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			// lower to instructions, each node once
+			auRegisters.resize(asNodes.size(), uNoRegister);
+			uResult = lower(uRoot);
+			if (nErr != TS_OK) return;
+			if (_uDestIx != uNoSlot)
+				sCode.emit(ts_opcode::op_store_bool, _uDestIx, uResult, 0);
+		}
+
+		/// <summary></summary>
+		[[nodiscard]] int64_t error() { return nErr; }
+		/// <summary>register holding the expression result</summary>
+		[[nodiscard]] unsigned result() { return uResult; }
+
+	private:
+		/// <summary>register index of nodes not lowered yet</summary>
+		static constexpr unsigned uNoRegister = ~0u;
+
+		/// <summary>value type of an expression node</summary>
+		enum struct node_type : unsigned
+		{
+			floating,
+			boolean,
+		};
+
+		/// <summary>
+		/// expression node, op_mov : constant, op_load_var / op_load_bool : slot uA, op_call : builtin uA of node uB,
+		/// op_invoke / op_native : script or host function uA of the argument nodes uB (aauCallArgs),
+		/// op_neg / op_sqrt / op_abs : operand node uB,
+		/// other operations : operand nodes uB and uC
+		/// </summary>
+		struct node
+		{
+			/// <summary>the operation</summary>
+			ts_opcode eOp;
+			/// <summary>the value type</summary>
+			node_type eType;
+			/// <summary>variable or boolean slot, builtin index, result register</summary>
+			unsigned uA;
+			/// <summary>first operand node</summary>
+			unsigned uB;
+			/// <summary>second operand node</summary>
+			unsigned uC;
+			/// <summary>constant value</summary>
+			te_type fValue;
+		};
+
+		/// <summary>or : and {"||" and}</summary>
+		bool parse_or(state& sState, unsigned& uNode)
+		{
+			if (!parse_and(sState, uNode)) return false;
+			while (sState.get_type() == state::token_type::TOK_OR)
+			{
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_and(sState, uRight)) return false;
+				uNode = add_node({ ts_opcode::op_or, node_type::boolean, 0, uNode, uRight, (te_type)0 });
+			}
+			return true;
+		}
+		/// <summary>and : equality {"&&" equality}</summary>
+		bool parse_and(state& sState, unsigned& uNode)
+		{
+			if (!parse_equality(sState, uNode)) return false;
+			while (sState.get_type() == state::token_type::TOK_AND)
+			{
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_equality(sState, uRight)) return false;
+				uNode = add_node({ ts_opcode::op_and, node_type::boolean, 0, uNode, uRight, (te_type)0 });
+			}
+			return true;
+		}
+		/// <summary>equality : relation {("==" | "!=") relation}</summary>
+		bool parse_equality(state& sState, unsigned& uNode)
+		{
+			if (!parse_relation(sState, uNode)) return false;
+			for (;;)
+			{
+				ts_opcode eOp;
+				switch (sState.get_type())
+				{
+				case state::token_type::TOK_EQUAL: eOp = ts_opcode::op_equal; break;
+				case state::token_type::TOK_UNEQUAL: eOp = ts_opcode::op_unequal; break;
+				default: return true;
+				}
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_relation(sState, uRight)) return false;
+				uNode = add_node({ eOp, node_type::boolean, 0, uNode, uRight, (te_type)0 });
+			}
+		}
+		/// <summary>relation : sum {("<" | ">" | "<=" | ">=") sum}</summary>
+		bool parse_relation(state& sState, unsigned& uNode)
+		{
+			if (!parse_sum(sState, uNode)) return false;
+			for (;;)
+			{
+				ts_opcode eOp;
+				switch (sState.get_type())
+				{
+				case state::token_type::TOK_GREATER: eOp = ts_opcode::op_greater; break;
+				case state::token_type::TOK_LESS: eOp = ts_opcode::op_less; break;
+				case state::token_type::TOK_GREATER_EQUAL: eOp = ts_opcode::op_greater_equal; break;
+				case state::token_type::TOK_LESS_EQUAL: eOp = ts_opcode::op_less_equal; break;
+				default: return true;
+				}
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_sum(sState, uRight)) return false;
+				uNode = add_node({ eOp, node_type::boolean, 0, uNode, uRight, (te_type)0 });
+			}
+		}
+		/// <summary>sum : term {("+" | "-") term}</summary>
+		bool parse_sum(state& sState, unsigned& uNode)
+		{
+			if (!parse_term(sState, uNode)) return false;
+			for (;;)
+			{
+				ts_opcode eOp;
+				switch (sState.get_type())
+				{
+				case state::token_type::TOK_PLUS: eOp = ts_opcode::op_add; break;
+				case state::token_type::TOK_MINUS: eOp = ts_opcode::op_sub; break;
+				default: return true;
+				}
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_term(sState, uRight)) return false;
+				if (!arithmetic(eOp, 0, uNode, uRight)) return false;
+			}
+		}
+		/// <summary>term : factor {("*" | "/" | "%") factor}</summary>
+		bool parse_term(state& sState, unsigned& uNode)
+		{
+			if (!parse_factor(sState, uNode)) return false;
+			for (;;)
+			{
+				ts_opcode eOp;
+				switch (sState.get_type())
+				{
+				case state::token_type::TOK_MUL: eOp = ts_opcode::op_mul; break;
+				case state::token_type::TOK_DIV: eOp = ts_opcode::op_div; break;
+				case state::token_type::TOK_MOD: eOp = ts_opcode::op_mod; break;
+				default: return true;
+				}
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_factor(sState, uRight)) return false;
+				if (!arithmetic(eOp, 0, uNode, uRight)) return false;
+			}
+		}
+		/// <summary>factor : power {"^" power} (left to right, as floating point statements)</summary>
+		bool parse_factor(state& sState, unsigned& uNode)
+		{
+			if (!parse_power(sState, uNode)) return false;
+			while (sState.get_type() == state::token_type::TOK_POW)
+			{
+				sState.next_token();
+				unsigned uRight = 0;
+				if (!parse_power(sState, uRight)) return false;
+				if (!arithmetic(ts_opcode::op_pow, 0, uNode, uRight)) return false;
+			}
+			return true;
+		}
+		/// <summary>power : {("-" | "+")} base</summary>
+		bool parse_power(state& sState, unsigned& uNode)
+		{
+			bool bNegate = false, bSign = false;
+			while ((sState.get_type() == state::token_type::TOK_PLUS) || (sState.get_type() == state::token_type::TOK_MINUS))
+			{
+				if (sState.get_type() == state::token_type::TOK_MINUS) bNegate = !bNegate;
+				bSign = true;
+				sState.next_token();
+			}
+			if (!parse_base(sState, uNode)) return false;
+			if ((bSign) && (asNodes[uNode].eType != node_type::floating)) return false;
+			if (bNegate) return arithmetic(ts_opcode::op_neg, 0, uNode, 0);
+			return true;
+		}
+		/// <summary>
+		/// base : number | variable | boolean | "true" | "false" |
+		/// function-1 power | function-2 "(" sum "," sum ")" | script-function "(" [sum {"," sum}] ")" |
+		/// host-function "(" [sum {"," sum}] ")" | "(" or ")"
+		/// </summary>
+		bool parse_base(state& sState, unsigned& uNode)
+		{
+			switch (sState.get_type())
+			{
+			case state::token_type::TOK_NUMBER:
+				uNode = add_node({ ts_opcode::op_mov, node_type::floating, 0, 0, 0, sState.value_floating() });
+				break;
+			case state::token_type::TOK_TRUE:
+				uNode = add_node({ ts_opcode::op_mov, node_type::boolean, 0, 0, 0, (te_type)1 });
+				break;
+			case state::token_type::TOK_FALSE:
+				uNode = add_node({ ts_opcode::op_mov, node_type::boolean, 0, 0, 0, (te_type)0 });
+				break;
+			case state::token_type::TOK_VAR_FLOAT:
+				if (!psSymbols->has_var(sState.value_unsigned())) return false;
+				uNode = add_node({ ts_opcode::op_load_var, node_type::floating, sState.value_unsigned(), 0, 0, (te_type)0 });
+				break;
+			case state::token_type::TOK_VAR_BOOL:
+				if (!psSymbols->has_bool(sState.value_unsigned())) return false;
+				uNode = add_node({ ts_opcode::op_load_bool, node_type::boolean, sState.value_unsigned(), 0, 0, (te_type)0 });
+				break;
+			case state::token_type::TOK_FUNCTION:
+			{
+				unsigned uFunc = sState.value_unsigned();
+				const ts_builtin& sF = ts_builtins()[uFunc];
+				sState.next_token();
+				std::array<unsigned, 2> auArgs = {};
+				if (sF.uArity == 1)
+				{
+					if (!parse_power(sState, auArgs[0])) return false;
+				}
+				else
+				{
+					if (sState.get_type() != state::token_type::TOK_OPEN) return false;
+					for (unsigned uA = 0; uA < sF.uArity; uA++)
+					{
+						sState.next_token();
+						if (!parse_sum(sState, auArgs[uA])) return false;
+						if (sState.get_type() != (((uA + 1) < sF.uArity) ? state::token_type::TOK_COMMA : state::token_type::TOK_CLOSE))
+							return false;
+					}
+					sState.next_token();
+				}
+				uNode = auArgs[0];
+				return arithmetic(sF.eOp, (sF.eOp == ts_opcode::op_call) ? uFunc : 0, uNode, auArgs[1]);
+			}
+			case state::token_type::TOK_SCRIPT_FUNCTION:
+			case state::token_type::TOK_NATIVE:
+			{
+				// each call a node of its own, compiled where lowered (a body or host function may have side effects)
+				bool bNative = (sState.get_type() == state::token_type::TOK_NATIVE);
+				unsigned uFunc = sState.value_unsigned();
+				std::vector<unsigned> auArgs;
+				sState.next_token();
+				if (sState.get_type() != state::token_type::TOK_OPEN) return false;
+				sState.next_token();
+				while (sState.get_type() != state::token_type::TOK_CLOSE)
+				{
+					if ((auArgs.size()) && (sState.get_type() == state::token_type::TOK_COMMA)) sState.next_token();
+					unsigned uArg = 0;
+					if ((!parse_sum(sState, uArg)) || (asNodes[uArg].eType != node_type::floating)) return false;
+					if ((sState.get_type() != state::token_type::TOK_COMMA) && (sState.get_type() != state::token_type::TOK_CLOSE)) return false;
+					auArgs.push_back(uArg);
+				}
+				if ((bNative) && (auArgs.size() != psSymbols->asNatives[uFunc].uArity)) return false;
+				aauCallArgs.push_back(std::move(auArgs));
+				uNode = add_node({ (bNative) ? ts_opcode::op_native : ts_opcode::op_invoke, node_type::floating, uFunc, (unsigned)aauCallArgs.size() - 1, 0, (te_type)0 });
+			}
+			break;
+			case state::token_type::TOK_OPEN:
+				sState.next_token();
+				if (!parse_or(sState, uNode)) return false;
+				if (sState.get_type() != state::token_type::TOK_CLOSE) return false;
+				break;
+			default:
+				return false;
+			}
+			sState.next_token();
+			return true;
+		}
+
+		/// <summary>add an arithmetic node, operands must be floating point values (uRight unused by unary operations)</summary>
+		bool arithmetic(ts_opcode eOp, unsigned uFunc, unsigned& uNode, unsigned uRight)
+		{
+			bool bUnary = unary(eOp);
+			if (asNodes[uNode].eType != node_type::floating) return false;
+			if ((!bUnary) && (asNodes[uRight].eType != node_type::floating)) return false;
+			uNode = add_node({ eOp, node_type::floating, uFunc, uNode, bUnary ? 0 : uRight, (te_type)0 });
+			return true;
+		}
+
+		/// <summary>operations of one operand (uB)</summary>
+		static bool unary(ts_opcode eOp)
+		{
+			return (eOp == ts_opcode::op_neg) || (eOp == ts_opcode::op_sqrt) || (eOp == ts_opcode::op_abs) || (eOp == ts_opcode::op_call);
+		}
+
+		/// <summary>add a node or get the equal node already added</summary>
+		unsigned add_node(const node& sNode)
+		{
+			for (size_t uIx = 0; uIx < asNodes.size(); uIx++)
+			{
+				const node& s = asNodes[uIx];
+				if ((s.eOp == sNode.eOp) && (s.eType == sNode.eType) && (s.uA == sNode.uA) && (s.uB == sNode.uB) && (s.uC == sNode.uC) &&
+					(std::memcmp(&s.fValue, &sNode.fValue, sizeof(te_type)) == 0))
+					return (unsigned)uIx;
+			}
+			asNodes.push_back(sNode);
+			return (unsigned)asNodes.size() - 1;
+		}
+
+		/// <summary>emit the instructions of a node (operands first), returns the register holding its value</summary>
+		unsigned lower(unsigned uNode)
+		{
+			if (auRegisters[uNode] != uNoRegister) return auRegisters[uNode];
+
+			const node sNode = asNodes[uNode];
+			unsigned uReg = 0;
+			switch (sNode.eOp)
+			{
+			case ts_opcode::op_mov:
+				uReg = sCode.constant(sNode.fValue);
+				break;
+			case ts_opcode::op_invoke:
+			case ts_opcode::op_native:
+			{
+				std::vector<unsigned> auArgs;
+				for (unsigned uArg : aauCallArgs[sNode.uB]) auArgs.push_back(lower(uArg));
+				if (sNode.eOp == ts_opcode::op_native)
+					uReg = sCode.call_native(&psSymbols->asNatives[sNode.uA], sNode.uA, std::move(auArgs));
+				else
+				{
+					ts_function_call cCall(sNode.uA, auArgs, psSymbols, sCode);
+					if (cCall.error()) nErr = TS_FAIL;
+					uReg = cCall.result();
+				}
+			}
+			break;
+			case ts_opcode::op_load_var:
+			case ts_opcode::op_load_bool:
+				uReg = sCode.new_register();
+				sCode.emit(sNode.eOp, uReg, sNode.uA, 0);
+				break;
+			case ts_opcode::op_and:
+			case ts_opcode::op_or:
+				uReg = lower_logic(sNode);
+				break;
+			case ts_opcode::op_neg:
+			case ts_opcode::op_sqrt:
+			case ts_opcode::op_abs:
+			case ts_opcode::op_call:
+			{
+				unsigned uOperand = lower(sNode.uB);
+				uReg = sCode.new_register();
+				sCode.emit(sNode.eOp, uReg, uOperand, sNode.uA);
+			}
+			break;
+			default:
+			{
+				unsigned uLeft = lower(sNode.uB);
+				unsigned uRight = lower(sNode.uC);
+				uReg = sCode.new_register();
+				sCode.emit(sNode.eOp, uReg, uLeft, uRight);
+			}
+			break;
+			}
+			auRegisters[uNode] = uReg;
+			return uReg;
+		}
+
+		/// <summary>
+		/// emit "&&" or "||", jumping over the right operand if the left one decides
+		/// (the result is combined after the jump target, a skipped right operand
+		/// never changes it and lanes of a batch never see a partly written result)
+		/// </summary>
+		unsigned lower_logic(const node& sNode)
+		{
+			unsigned uLeft = lower(sNode.uB);
+
+			// a single load or constant costs less than the jump
+			ts_opcode eRight = asNodes[sNode.uC].eOp;
+			if ((eRight == ts_opcode::op_mov) || (eRight == ts_opcode::op_load_var) || (eRight == ts_opcode::op_load_bool) ||
+				(auRegisters[sNode.uC] != uNoRegister))
+			{
+				unsigned uRight = lower(sNode.uC);
+				unsigned uReg = sCode.new_register();
+				sCode.emit(sNode.eOp, uReg, uLeft, uRight);
+				return uReg;
+			}
+
+			// "&&" jumps if the left operand is false, "||" if it is true
+			unsigned uDecides = uLeft;
+			if (sNode.eOp == ts_opcode::op_or)
+			{
+				uDecides = sCode.new_register();
+				sCode.emit(ts_opcode::op_equal, uDecides, uLeft, sCode.constant((te_type)0));
+			}
+			unsigned uJump = sCode.emit(ts_opcode::op_jump_false, uDecides, 0, 0);
+
+			// nodes first lowered in the right operand are not evaluated on every path
+			std::vector<unsigned> auLowered = auRegisters;
+			unsigned uRight = lower(sNode.uC);
+			auRegisters = auLowered;
+
+			sCode.asCode[uJump].uB = (unsigned)sCode.asCode.size();
+			unsigned uReg = sCode.new_register();
+			sCode.emit(sNode.eOp, uReg, uLeft, uRight);
+			return uReg;
+		}
+
+		/// <summary>the script symbol table</summary>
+		std::shared_ptr<symbol_table> psSymbols;
+		/// <summary>the expression graph (compile time only)</summary>
+		std::vector<node> asNodes;
+		/// <summary>register of each lowered node (compile time only)</summary>
+		std::vector<unsigned> auRegisters;
+		/// <summary>argument nodes of each script and host function call (compile time only)</summary>
+		std::vector<std::vector<unsigned>> aauCallArgs;
+		/// <summary>the instruction stream to compile to</summary>
+		bytecode& sCode;
+		/// <summary>register holding the expression result</summary>
+		unsigned uResult = 0;
+		/// <summary>0 if statement compiled</summary>
+		int64_t nErr = TS_OK;
+	};
+
+	/// <summary>TinyScript if statement class</summary>
+	class ts_statement_if
+	{
+	public:
+		/// <param name="_atStatement">the statement string</param>
+		/// <param name="_psSymbols">shared pointer to the script symbol table</param>
+		/// <param name="_sCode">the instruction stream to compile to</param>
+		ts_statement_if(std::string_view _atBoolStatement,
+			const std::shared_ptr<symbol_table>& _psSymbols,
+			bytecode& _sCode
+		)
+		{
+			ts_statement_bool_expr cBoolExpr = ts_statement_bool_expr(_atBoolStatement, _psSymbols, _sCode, ts_statement_bool_expr::uNoSlot);
+			nErr = cBoolExpr.error();
+			uCondition = cBoolExpr.result();
+		}
+		/// <summary></summary>
+		int64_t error() { return nErr; }
+		/// <summary>register holding the condition value</summary>
+		unsigned condition() { return uCondition; }
+
+	private:
+		/// <summary>0 if statement compiled</summary>
+		int64_t nErr = TS_OK;
+		/// <summary>register holding the condition value</summary>
+		unsigned uCondition = 0;
+	};
+
+	/// <summary>a single code line within the script</summary>
+	class ts_statement
+	{
+	public:
+		/// <param name="_atStatement">the statement string</param>
+		/// <param name="_psSymbols">shared pointer to the script symbol table</param>
+		/// <param name="_sCode">the instruction stream to compile to</param>
+		/// <param name="_uBlockLevel">the block level of this statement</param>
+		explicit ts_statement(std::string_view _atStatement,
+			const std::shared_ptr<symbol_table>& _psSymbols,
+			bytecode& _sCode,
+			unsigned _uBlockLevel
+		) : uBlockLevel(_uBlockLevel)
+		{
+			// create state class
+			state sState(_atStatement, *_psSymbols);
+
+			// get first token, compile statement
+			sState.next_token();
+			switch (sState.get_type())
+			{
+			case ts_program::state::token_type::TOK_IF:
+			{
+				// compile if (in case boolean) statement
+				std::string_view atS = sState.remaining();
+				ts_statement_if cIf = ts_statement_if(atS, _psSymbols, _sCode);
+				auto nE = cIf.error();
+				if (nE == TS_OK)
+				{
+					eType = ts_types::sm_if;
+					uCondition = cIf.condition();
+				}
+				else
+					nErr = nE;
+			}
+			break;
+			case ts_program::state::token_type::TOK_ELSE:
+				// "else" branches are split by the lexer, none here
+				nErr = TS_FAIL;
+				break;
+			case ts_program::state::token_type::TOK_WHILE:
+			case ts_program::state::token_type::TOK_FOR:
+				compile_loop(sState.remaining(), sState.get_type() == ts_program::state::token_type::TOK_FOR, _psSymbols, _sCode);
+				break;
+			case ts_program::state::token_type::TOK_DECLARE_FLOAT:
+			case ts_program::state::token_type::TOK_DECLARE_BOOL:
+				compile_declaration(sState.remaining(), sState.get_type() == ts_program::state::token_type::TOK_DECLARE_BOOL, _psSymbols, _sCode);
+				break;
+			case ts_program::state::token_type::TOK_FUNC:
+				compile_header(sState.remaining(), *_psSymbols);
+				break;
+			case ts_program::state::token_type::TOK_NATIVE:
+			{
+				// a host function called for its side effects, the result is not used
+				auto nE = ts_statement_float_expr(_atStatement, _psSymbols, _sCode, ts_statement_float_expr::uNoSlot).error();
+				if (nE == TS_OK)
+					eType = ts_types::sm_expr_float;
+				else
+					nErr = nE;
+			}
+			break;
+			case ts_program::state::token_type::TOK_VAR_FLOAT:
+			{
+				// get the variable index
+				unsigned uIx = sState.value_unsigned();
+
+				// return error if wrong index
+				if (uIx >= _psSymbols->apfVars.size())
+				{
+					nErr = TS_FAIL;
+					return;
+				}
+
+				// next token must be TOK_ASSIGN
+				sState.next_token();
+				if (sState.get_type() != ts_program::state::token_type::TOK_ASSIGN)
+				{
+					nErr = TS_FAIL;
+					return;
+				}
+
+				// compile float expression statement
+				std::string_view atS = sState.remaining();
+				auto nE = ts_statement_float_expr(atS, _psSymbols, _sCode, uIx).error();
+				if (nE == TS_OK)
+					eType = ts_types::sm_expr_float;
+				else
+					nErr = nE;
+			}
+			break;
+			case ts_program::state::token_type::TOK_VAR_BOOL:
+			{
+				// get the variable index
+				unsigned uIx = sState.value_unsigned();
+
+				// return error if wrong index
+				if (uIx >= _psSymbols->apbBools.size())
+				{
+					nErr = TS_FAIL;
+					return;
+				}
+
+				// next token must be TOK_ASSIGN
+				sState.next_token();
+				if (sState.get_type() != ts_program::state::token_type::TOK_ASSIGN)
+				{
+					nErr = TS_FAIL;
+					return;
+				}
+
+				// compile boolean statement
+				std::string_view atS = sState.remaining();
+				auto nE = ts_statement_bool_expr(atS, _psSymbols, _sCode, uIx).error();
+				if (nE == TS_OK)
+					eType = ts_types::sm_expr_bool;
+				else
+					nErr = nE;
+			}
+			break;
+			default:
+				nErr = TS_FAIL;
+				return;
+			}
+		}
+		/// <summary></summary>
+		ts_types type() { return eType; }
+		/// <summary></summary>
+		int64_t error() { return nErr; }
+		/// <summary></summary>
+		unsigned level() { return uBlockLevel; }
+		/// <summary>condition register for if statements and loops</summary>
+		unsigned condition() { return uCondition; }
+		/// <summary>loops : index of the loop entry instruction</summary>
+		unsigned loop() { return uLoop; }
+		/// <summary>loops : the step statement of a "for" loop (a span of the statement)</summary>
+		std::string_view step() { return atStep; }
+		/// <summary>loops : number of locals in scope before the loop, the locals of the initial statement follow</summary>
+		size_t scope() { return uScope; }
+		/// <summary>function header : the function name</summary>
+		const std::string& function_name() { return atFunction; }
+		/// <summary>function header : the parameter names</summary>
+		const std::vector<std::string>& parameters() { return atParams; }
+
+	private:
+		/// <summary>read a name at this position, spaces around skipped (empty if none)</summary>
+		static std::string_view read_name(std::string_view at, size_t& uIx)
+		{
+			while ((uIx < at.size()) && (at[uIx] == ' ')) uIx++;
+			size_t uStart = uIx;
+			while ((uIx < at.size()) && (isalpha(at[uIx]) || isdigit(at[uIx]) || (at[uIx] == '_'))) uIx++;
+			std::string_view atName = at.substr(uStart, uIx - uStart);
+			while ((uIx < at.size()) && (at[uIx] == ' ')) uIx++;
+			return ((atName.size()) && (isdigit(atName.front()))) ? std::string_view() : atName;
+		}
+
+		/// <summary>
+		/// read the function header "name(parameters)" of "func", the name not used yet, the parameters distinct
+		/// (the body follows as block, see ts_program::define_function())
+		/// </summary>
+		void compile_header(std::string_view atHeader, const symbol_table& sSymbols)
+		{
+			size_t uIx = 0;
+			std::string_view atName = read_name(atHeader, uIx);
+			if ((atName.empty()) || (sSymbols.sNames.find(atName)) || (uIx == atHeader.size()) || (atHeader[uIx] != '('))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+			uIx++;
+			while ((uIx < atHeader.size()) && (atHeader[uIx] == ' ')) uIx++;
+			while ((uIx < atHeader.size()) && (atHeader[uIx] != ')'))
+			{
+				if ((atParams.size()) && (atHeader[uIx] == ',')) uIx++;
+				std::string_view atParam = read_name(atHeader, uIx);
+				if ((atParam.empty()) || (std::find(atParams.begin(), atParams.end(), atParam) != atParams.end()) ||
+					(uIx == atHeader.size()) || ((atHeader[uIx] != ',') && (atHeader[uIx] != ')')))
+				{
+					nErr = TS_FAIL;
+					return;
+				}
+				atParams.emplace_back(atParam);
+			}
+
+			// nothing after the parameters
+			size_t uEnd = uIx + 1;
+			while ((uEnd < atHeader.size()) && (atHeader[uEnd] == ' ')) uEnd++;
+			if ((uIx == atHeader.size()) || (uEnd < atHeader.size()))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+			atFunction = std::string(atName);
+			eType = ts_types::sm_function;
+		}
+
+		/// <summary>
+		/// compile the local declaration "name[ = expression]" of "float" or "bool" (zero or false without expression) :
+		/// the name is visible after the expression, until the end of the block
+		/// </summary>
+		void compile_declaration(std::string_view atDeclaration, bool bBoolean, const std::shared_ptr<symbol_table>& psSymbols, bytecode& sCode)
+		{
+			// the name, none used yet
+			size_t uIx = 0;
+			std::string_view atName = read_name(atDeclaration, uIx);
+			if ((atName.empty()) || (psSymbols->sNames.find(atName)))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			// the initial value
+			unsigned uValue = sCode.constant((te_type)0);
+			if (uIx < atDeclaration.size())
+			{
+				std::string_view atExpr = atDeclaration.substr(uIx + 1);
+				if ((atDeclaration[uIx] != '=') || ((atExpr.size()) && (atExpr.front() == '=')))
+				{
+					nErr = TS_FAIL;
+					return;
+				}
+				if (bBoolean)
+				{
+					ts_statement_bool_expr cExpr(atExpr, psSymbols, sCode, ts_statement_bool_expr::uNoSlot);
+					nErr = cExpr.error();
+					uValue = cExpr.result();
+				}
+				else
+				{
+					ts_statement_float_expr cExpr(atExpr, psSymbols, sCode, ts_statement_float_expr::uNoSlot);
+					nErr = cExpr.error();
+					uValue = cExpr.result();
+				}
+				if (nErr) return;
+			}
+
+			// a slot of its own, stored like any variable
+			unsigned uSlot = (unsigned)psSymbols->declare(atName, bBoolean, uBlockLevel);
+			sCode.emit(bBoolean ? ts_opcode::op_store_bool : ts_opcode::op_store_var, uSlot, uValue, 0);
+			eType = bBoolean ? ts_types::sm_expr_bool : ts_types::sm_expr_float;
+		}
+
+		/// <summary>
+		/// compile the loop header "(condition[; cap])" of "while" or "(init; condition; step[; cap])" of "for" :
+		/// the initial statement, the iteration cap evaluated once (none : unlimited), the loop entry and the condition,
+		/// the step is compiled at the loop end
+		/// </summary>
+		void compile_loop(std::string_view atHeader, bool bFor, const std::shared_ptr<symbol_table>& psSymbols, bytecode& sCode)
+		{
+			uScope = psSymbols->scope();
+			auto trim = [](std::string_view at)
+				{
+					while ((at.size()) && (at.front() == ' ')) at.remove_prefix(1);
+					while ((at.size()) && (at.back() == ' ')) at.remove_suffix(1);
+					return at;
+				};
+			atHeader = trim(atHeader);
+			if ((atHeader.size() < 2) || (atHeader.front() != '(') || (atHeader.back() != ')'))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			// the parts, split at the semicolons outside of nested parentheses
+			std::vector<std::string_view> aatParts;
+			unsigned uDepth = 0;
+			size_t uPart = 1;
+			for (size_t uIx = 1; uIx + 1 < atHeader.size(); uIx++)
+			{
+				if (atHeader[uIx] == '(') uDepth++;
+				else if ((atHeader[uIx] == ')') && (uDepth-- == 0)) break;
+				else if ((atHeader[uIx] == ';') && (uDepth == 0))
+				{
+					aatParts.push_back(trim(atHeader.substr(uPart, uIx - uPart)));
+					uPart = uIx + 1;
+				}
+			}
+			aatParts.push_back(trim(atHeader.substr(uPart, atHeader.size() - 1 - uPart)));
+			const size_t uParts = bFor ? 3 : 1;
+			if ((uDepth != 0) || (aatParts.size() < uParts) || (aatParts.size() > uParts + 1))
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			// the initial statement, its locals stay until the loop ends (block level zero, never ended by a block)
+			if ((bFor) && (aatParts[0].size()))
+			{
+				ts_statement cInit(aatParts[0], psSymbols, sCode, 0);
+				if ((cInit.error()) || ((cInit.type() != ts_types::sm_expr_float) && (cInit.type() != ts_types::sm_expr_bool)))
+				{
+					nErr = (cInit.error()) ? cInit.error() : TS_FAIL;
+					return;
+				}
+			}
+
+			// the iteration cap, a constant or evaluated at the loop entry
+			unsigned uCap = sCode.constant(std::numeric_limits<te_type>::infinity());
+			if ((aatParts.size() > uParts) && (aatParts.back().size()))
+			{
+				ts_statement_float_expr cCap(aatParts.back(), psSymbols, sCode, ts_statement_float_expr::uNoSlot);
+				if (cCap.error())
+				{
+					nErr = cCap.error();
+					return;
+				}
+				uCap = cCap.result();
+			}
+			uLoop = sCode.emit(ts_opcode::op_loop, sCode.new_register(), 0, uCap);
+
+			// the condition, checked before each iteration ("for" without condition : true)
+			std::string_view atCondition = aatParts[bFor ? 1 : 0];
+			if (atCondition.size())
+			{
+				ts_statement_bool_expr cCondition(atCondition, psSymbols, sCode, ts_statement_bool_expr::uNoSlot);
+				if (cCondition.error())
+				{
+					nErr = cCondition.error();
+					return;
+				}
+				uCondition = cCondition.result();
+			}
+			else if (bFor)
+				uCondition = sCode.constant((te_type)1);
+			else
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+
+			if (bFor) atStep = aatParts[2];
+			eType = ts_types::sm_loop;
+		}
+
+		/// <summary>type of the statement</summary>
+		ts_types eType = ts_types::sm_undefined;
+		/// <summary>the block level of this statement</summary>
+		unsigned uBlockLevel;
+		/// <summary>condition register for if statements and loops</summary>
+		unsigned uCondition = 0;
+		/// <summary>loops : index of the loop entry instruction, the step statement, the locals in scope before the loop</summary>
+		unsigned uLoop = 0;
+		std::string_view atStep;
+		size_t uScope = 0;
+		/// <summary>function header : the function name and the parameter names</summary>
+		std::string atFunction;
+		std::vector<std::string> atParams;
+		/// <summary>0 if statement compiled</summary>
+		int64_t nErr = TS_OK;
+	};
+
+	/// <summary>
+	/// TinyScript function call : the body compiled at the call site for the argument registers (inlined, the optimizer
+	/// specializes it for the caller), the body of an invoked function compiled once (the arguments stored to its parameter slots)
+	/// </summary>
+	class ts_function_call
+	{
+	public:
+		/// <param name="uFunction">index of the function</param>
+		/// <param name="auArgs">the argument registers</param>
+		/// <param name="psSymbols">shared pointer to the script symbol table</param>
+		/// <param name="sCode">the instruction stream to compile to</param>
+		ts_function_call(unsigned uFunction, const std::vector<unsigned>& auArgs, const std::shared_ptr<symbol_table>& psSymbols, bytecode& sCode)
+		{
+			const symbol_table::function& sF = psSymbols->asFunctions[uFunction];
+			if (auArgs.size() != sF.atParams.size())
+			{
+				nErr = TS_FAIL;
+				return;
+			}
+			if (sF.bInvoked)
+			{
+				// the body follows the program, the invocation is resolved to it at the end (see append_bodies())
+				for (size_t uP = 0; uP < auArgs.size(); uP++)
+					sCode.emit(ts_opcode::op_store_var, sF.auParams[uP], auArgs[uP], 0);
+				sCode.emit(ts_opcode::op_invoke, sF.uResult, uFunction, 0);
+				uResult = sCode.new_register();
+				sCode.emit(ts_opcode::op_load_var, uResult, sF.uResult, 0);
+				return;
+			}
+			std::vector<unsigned> auParams;
+			nErr = compile_body(uFunction, sF, &auArgs, psSymbols, sCode, auParams, uResult);
+		}
+
+		/// <summary>
+		/// compile a function body, the parameters are new locals (stored from the argument registers if any),
+		/// the body sees them, its own locals and the functions defined before (uFunction)
+		/// </summary>
+		/// <param name="auParams">the parameter slots</param>
+		/// <param name="uResult">register holding the returned value</param>
+		/// <returns>0 if compiled</returns>
+		static int64_t compile_body(unsigned uFunction, const symbol_table::function& sF, const std::vector<unsigned>* pauArgs,
+			const std::shared_ptr<symbol_table>& psSymbols, bytecode& sCode, std::vector<unsigned>& auParams, unsigned& uResult)
+		{
+			size_t uScope = psSymbols->scope();
+			name_index::visibility sVisible = psSymbols->enter_function(uFunction);
+			int64_t nE = TS_OK;
+			for (size_t uP = 0; (nE == TS_OK) && (uP < sF.atParams.size()); uP++)
+			{
+				int nSlot = psSymbols->declare(sF.atParams[uP], false, 0);
+				if (nSlot < 0)
+				{
+					nE = TS_FAIL;
+					break;
+				}
+				auParams.push_back((unsigned)nSlot);
+				if (pauArgs) sCode.emit(ts_opcode::op_store_var, (unsigned)nSlot, (*pauArgs)[uP], 0);
+			}
+			for (size_t uS = 0; (nE == TS_OK) && (uS < sF.atBody.size()); uS++)
+			{
+				// declarations and assignments only
+				ts_statement cStatement(sF.atBody[uS], psSymbols, sCode, 0);
+				nE = cStatement.error();
+				if ((nE == TS_OK) && (cStatement.type() != ts_types::sm_expr_float) && (cStatement.type() != ts_types::sm_expr_bool)) nE = TS_FAIL;
+			}
+			if (nE == TS_OK)
+			{
+				ts_statement_float_expr cReturn(sF.atReturn, psSymbols, sCode, ts_statement_float_expr::uNoSlot);
+				nE = cReturn.error();
+				uResult = cReturn.result();
+			}
+			psSymbols->leave(uScope);
+			psSymbols->leave_function(sVisible);
+			return nE;
+		}
+
+		/// <summary></summary>
+		int64_t error() { return nErr; }
+		/// <summary>register holding the returned value</summary>
+		unsigned result() { return uResult; }
+
+	private:
+		/// <summary>register holding the returned value</summary>
+		unsigned uResult = 0;
+		/// <summary>0 if the call compiled</summary>
+		int64_t nErr = TS_OK;
+	};
+
+	/// <summary>
+	/// define a script function "func name(parameters) { statements; return expression; }" : the body compiled once to check it,
+	/// then inlined at each call or, if larger than uInlineLimit instructions, kept compiled and invoked
+	/// </summary>
+	/// <returns>0 if defined</returns>
+	int64_t define_function(std::string_view atName, symbol_table::function sF, const std::shared_ptr<symbol_table>& psTable)
+	{
+		// the last statement returns
+		if (sF.atBody.empty()) return TS_FAIL;
+		state sState(sF.atBody.back(), *psTable);
+		sState.next_token();
+		if (sState.get_type() != state::token_type::TOK_RETURN) return TS_FAIL;
+		sF.atReturn = std::string(sState.remaining());
+		sF.atBody.pop_back();
+
+		bytecode::mark sMark = sCode.position();
+		unsigned uResult = 0;
+		int64_t nE = ts_function_call::compile_body((unsigned)psTable->asFunctions.size(), sF, nullptr, psTable, sCode, sF.auParams, uResult);
+		if (nE) return nE;
+		if (sCode.asCode.size() - sMark.uCode > uInlineLimit)
+		{
+			// the result stored to a slot of its own, the body moved out of the program
+			sF.bInvoked = true;
+			sF.uResult = psTable->add_local(atName, false);
+			sCode.emit(ts_opcode::op_store_var, sF.uResult, uResult, 0);
+			sCode.emit(ts_opcode::op_end, 0, 0, 0);
+			sF.asBody.assign(sCode.asCode.begin() + sMark.uCode, sCode.asCode.end());
+			for (ts_instruction& s : sF.asBody)
+				if ((s.eOp == ts_opcode::op_jump) || (s.eOp == ts_opcode::op_jump_false)) s.uB -= (unsigned)sMark.uCode;
+			sCode.asCode.resize(sMark.uCode);
+		}
+		else
+		{
+			// compiled again at each call
+			sCode.roll_back(sMark);
+			sF.auParams.clear();
+		}
+		psTable->define(atName, std::move(sF));
+		return TS_OK;
+	}
+
+	/// <summary>
+	/// append the bodies of the invoked functions after the program end, the functions defined last first
+	/// (a body only invokes functions defined before, these follow it) and resolve the invocations to the bodies
+	/// </summary>
+	void append_bodies(const symbol_table& sTable)
+	{
+		std::vector<unsigned> auBegin(sTable.asFunctions.size(), 0);
+		std::vector<bool> abInvoked(sTable.asFunctions.size(), false);
+		auto invoked = [&](size_t uFrom)
+			{
+				for (size_t uPc = uFrom; uPc < sCode.asCode.size(); uPc++)
+					if (sCode.asCode[uPc].eOp == ts_opcode::op_invoke) abInvoked[sCode.asCode[uPc].uB] = true;
+			};
+		invoked(0);
+		for (size_t uF = sTable.asFunctions.size(); uF-- > 0;)
+		{
+			if (!abInvoked[uF]) continue;
+			unsigned uBegin = (unsigned)sCode.asCode.size();
+			auBegin[uF] = uBegin;
+			for (ts_instruction s : sTable.asFunctions[uF].asBody)
+			{
+				if ((s.eOp == ts_opcode::op_jump) || (s.eOp == ts_opcode::op_jump_false)) s.uB += uBegin;
+				sCode.asCode.push_back(s);
+			}
+			invoked(uBegin);
+		}
+		for (ts_instruction& s : sCode.asCode)
+			if (s.eOp == ts_opcode::op_invoke) s.uB = auBegin[s.uB];
+	}
+
+	/// <summary>block level helper</summary>
+	unsigned block_level_up() { return ++uBlockLevel; }
+	/// <summary>block level helper</summary>
+	unsigned block_level_down() { return --uBlockLevel; }
+
+	/// <summary>patch the jumps of all if statements on this level or above to the current code end, end the loops</summary>
+	void close_ifs(std::vector<open_if>& asOpenIfs, unsigned uLevel, const std::shared_ptr<symbol_table>& psTable)
+	{
+		while ((asOpenIfs.size()) && (asOpenIfs.back().uLevel >= uLevel))
+			close_last(asOpenIfs, psTable);
+	}
+
+	/// <summary>
+	/// close the innermost open if statement, a loop ends by its step statement and
+	/// the jump back to its start (the condition and the loop entry jump after that),
+	/// the locals of its initial statement end with it
+	/// </summary>
+	void close_last(std::vector<open_if>& asOpenIfs, const std::shared_ptr<symbol_table>& psTable)
+	{
+		const open_if& sIf = asOpenIfs.back();
+		if (sIf.uLoop != open_if::uNoLoop)
+		{
+			if (sIf.atStep.size())
+			{
+				ts_statement cStep(sIf.atStep, psTable, sCode, sIf.uLevel);
+				if ((cStep.error()) || ((cStep.type() != ts_types::sm_expr_float) && (cStep.type() != ts_types::sm_expr_bool)))
+					nErr = (cStep.error()) ? cStep.error() : TS_FAIL;
+			}
+			sCode.emit(ts_opcode::op_next, sCode.asCode[sIf.uLoop].uA, sIf.uLoop + 1, sCode.constant((te_type)1));
+			sCode.asCode[sIf.uLoop].uB = (unsigned)sCode.asCode.size();
+			psTable->leave(sIf.uScope);
+		}
+		sCode.asCode[sIf.uJump].uB = (unsigned)sCode.asCode.size();
+		asOpenIfs.pop_back();
+	}
+
+	/// <summary>
+	/// start the "else" branch of the innermost open if statement without one (blocks ended by a closing
+	/// curly brace closed their if statements) : the block jumps over the branch, the condition to the branch
+	/// (a chain of "else if" evaluates each condition once, each block jumps to the chain end)
+	/// </summary>
+	/// <returns>false if no if statement takes the branch</returns>
+	bool open_else(std::vector<open_if>& asOpenIfs, const std::shared_ptr<symbol_table>& psTable)
+	{
+		bool bLoop = false;
+		for (size_t uIx = asOpenIfs.size(); uIx-- > 0;)
+		{
+			if (asOpenIfs[uIx].uLoop != open_if::uNoLoop) bLoop = true;
+			if ((asOpenIfs[uIx].uLoop != open_if::uNoLoop) || (sCode.asCode[asOpenIfs[uIx].uJump].eOp != ts_opcode::op_jump_false)) continue;
+
+			// loops within the if block end before the branch
+			if (bLoop)
+				while (asOpenIfs.size() > uIx + 1) close_last(asOpenIfs, psTable);
+			unsigned uJump = sCode.emit(ts_opcode::op_jump, 0, 0, 0);
+			sCode.asCode[asOpenIfs[uIx].uJump].uB = (unsigned)sCode.asCode.size();
+			asOpenIfs[uIx] = { uBlockLevel, uJump };
+			return true;
+		}
+		return false;
+	}
+
+	/// <summary>operations of one or two operand registers defining a register, without side effects</summary>
+	static bool pure(ts_opcode eOp)
+	{
+		return ((eOp >= ts_opcode::op_mov) && (eOp <= ts_opcode::op_or));
+	}
+
+	/// <summary>operations defining register uA</summary>
+	static bool defines_register(ts_opcode eOp)
+	{
+		return pure(eOp) || (eOp == ts_opcode::op_load_var) || (eOp == ts_opcode::op_load_bool) || (eOp == ts_opcode::op_tinyexpr) || (eOp == ts_opcode::op_native);
+	}
+
+	/// <summary>true for a call of an impure host function (called as often as written, in script order)</summary>
+	bool impure(const ts_instruction& s) const
+	{
+		return (s.eOp == ts_opcode::op_native) && (!psSymbols->asNatives[s.uC].bPure);
+	}
+
+	/// <summary>end of the program, the invoked function bodies follow it (see append_bodies())</summary>
+	/// <returns>index of the first op_end no jump passes (unsupported statements end evaluation early)</returns>
+	static size_t program_end(const std::vector<ts_instruction>& asCode)
+	{
+		size_t uReach = 0;
+		for (size_t uPc = 0; uPc < asCode.size(); uPc++)
+		{
+			const ts_instruction& s = asCode[uPc];
+			if ((s.eOp == ts_opcode::op_jump) || (s.eOp == ts_opcode::op_jump_false)) uReach = std::max(uReach, (size_t)s.uB);
+			else if ((s.eOp == ts_opcode::op_end) && (uPc >= uReach)) return uPc;
+		}
+		return asCode.size();
+	}
+
+	/// <summary>operations resulting 1 or 0</summary>
+	static bool boolean_result(ts_opcode eOp)
+	{
+		return ((eOp >= ts_opcode::op_equal) && (eOp <= ts_opcode::op_or)) || (eOp == ts_opcode::op_load_bool);
+	}
+
+	/// <summary>operand registers of an instruction, two or the arguments of a host function call</summary>
+	using operands = std::array<unsigned*, std::max(2u, ts_native::uMaxArity)>;
+
+	/// <summary>the operand registers of an instruction (the destination register excluded)</summary>
+	/// <returns>number of operand registers</returns>
+	unsigned operand_registers(ts_instruction& s, operands& apuRegs)
+	{
+		switch (s.eOp)
+		{
+		case ts_opcode::op_native:
+		{
+			std::vector<unsigned>& auArgs = sCode.asNatives[s.uB].auArgs;
+			for (size_t uA = 0; uA < auArgs.size(); uA++) apuRegs[uA] = &auArgs[uA];
+			return (unsigned)auArgs.size();
+		}
+		case ts_opcode::op_store_var:
+		case ts_opcode::op_store_bool:
+		case ts_opcode::op_mov:
+		case ts_opcode::op_neg:
+		case ts_opcode::op_sqrt:
+		case ts_opcode::op_abs:
+		case ts_opcode::op_call:
+			apuRegs[0] = &s.uB;
+			return 1;
+		case ts_opcode::op_jump_false:
+			apuRegs[0] = &s.uA;
+			return 1;
+		case ts_opcode::op_loop:
+			apuRegs[0] = &s.uC;
+			return 1;
+		case ts_opcode::op_next:
+			apuRegs[0] = &s.uA;
+			apuRegs[1] = &s.uC;
+			return 2;
+		default:
+			if (pure(s.eOp))
+			{
+				apuRegs[0] = &s.uB;
+				apuRegs[1] = &s.uC;
+				return 2;
+			}
+			return 0;
+		}
+	}
+
+	/// <summary>result of a pure operation, computed as the interpreter does</summary>
+	static te_type fold(const ts_instruction& s, te_type fB, te_type fC)
+	{
+		switch (s.eOp)
+		{
+		case ts_opcode::op_mov: return fB;
+		case ts_opcode::op_neg: return -fB;
+		case ts_opcode::op_add: return fB + fC;
+		case ts_opcode::op_sub: return fB - fC;
+		case ts_opcode::op_mul: return fB * fC;
+		case ts_opcode::op_div: return fB / fC;
+		case ts_opcode::op_mod: return std::fmod(fB, fC);
+		case ts_opcode::op_pow: return std::pow(fB, fC);
+		case ts_opcode::op_sqrt: return std::sqrt(fB);
+		case ts_opcode::op_abs: return std::fabs(fB);
+		case ts_opcode::op_atan2: return std::atan2(fB, fC);
+		case ts_opcode::op_call: return ts_builtins()[s.uC].pfFunc(fB);
+		case ts_opcode::op_equal: return (fB == fC) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_unequal: return (fB != fC) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_greater: return (fB > fC) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_less: return (fB < fC) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_greater_equal: return (fB >= fC) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_less_equal: return (fB <= fC) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_and: return ((fB != (te_type)0) && (fC != (te_type)0)) ? (te_type)1 : (te_type)0;
+		case ts_opcode::op_or: return ((fB != (te_type)0) || (fC != (te_type)0)) ? (te_type)1 : (te_type)0;
+		default: return (te_type)0;
+		}
+	}
+
+	/// <summary>
+	/// optimize the whole instruction stream (results stay bit identical) :
+	/// constant folding, common subexpressions and loads of stored values across statements,
+	/// dead stores (overwritten before read) and unused or unreachable instructions removed
+	/// (distinct slots are assumed to be bound to distinct addresses)
+	/// </summary>
+	void optimize()
+	{
+		// bodies no longer invoked are unreachable after the dead code is removed
+		std::vector<bool> abKeep(sCode.asCode.size(), true);
+		share_values(abKeep);
+		remove_unreachable(abKeep);
+		remove_dead(abKeep);
+		remove_unreachable(abKeep);
+		compact(abKeep);
+	}
+
+	/// <summary>slots a function body loads and stores (booleans follow the variables), the bodies it invokes included</summary>
+	struct body_effects
+	{
+		std::vector<bool> abLoads, abStores;
+		/// <summary>estimated work, see work()</summary>
+		unsigned uWork = 0;
+		/// <summary>true if an impure host function is called</summary>
+		bool bImpure = false;
+	};
+
+	/// <summary>the effects of the invoked function bodies</summary>
+	/// <returns>effects by the first instruction of each body</returns>
+	std::map<unsigned, body_effects> function_bodies() const
+	{
+		const std::vector<ts_instruction>& asCode = sCode.asCode;
+		const size_t uVars = psSymbols->apfVars.size(), uSlots = uVars + psSymbols->apbBools.size();
+		std::map<unsigned, body_effects> asBodies;
+
+		// from the last body backwards, a body only invokes the bodies following it
+		const size_t uMain = program_end(asCode);
+		size_t uEnd = asCode.size();
+		for (size_t uPc = asCode.size(); uPc-- > uMain + 1;)
+		{
+			if (asCode[uPc - 1].eOp != ts_opcode::op_end) continue;
+			body_effects& sB = asBodies[(unsigned)uPc];
+			sB.abLoads.assign(uSlots, false);
+			sB.abStores.assign(uSlots, false);
+			for (size_t uIx = uPc; uIx < uEnd; uIx++)
+			{
+				const ts_instruction& s = asCode[uIx];
+				sB.uWork += work(s);
+				switch (s.eOp)
+				{
+				case ts_opcode::op_load_var: sB.abLoads[s.uB] = true; break;
+				case ts_opcode::op_load_bool: sB.abLoads[uVars + s.uB] = true; break;
+				case ts_opcode::op_store_var: sB.abStores[s.uA] = true; break;
+				case ts_opcode::op_store_bool: sB.abStores[uVars + s.uA] = true; break;
+				case ts_opcode::op_tinyexpr:
+					for (unsigned uSlot : sCode.apsFallbacks[s.uB]->auSlots) sB.abLoads[uSlot] = true;
+					break;
+				case ts_opcode::op_native:
+					sB.bImpure = sB.bImpure || impure(s);
+					break;
+				case ts_opcode::op_invoke:
+				{
+					auto ps = asBodies.find(s.uB);
+					if (ps == asBodies.end()) break;
+					for (size_t uS = 0; uS < uSlots; uS++)
+					{
+						if (ps->second.abLoads[uS]) sB.abLoads[uS] = true;
+						if (ps->second.abStores[uS]) sB.abStores[uS] = true;
+					}
+					sB.uWork += ps->second.uWork;
+					sB.bImpure = sB.bImpure || ps->second.bImpure;
+				}
+				break;
+				default: break;
+				}
+			}
+			uEnd = uPc;
+		}
+		return asBodies;
+	}
+
+	/// <summary>value available in a register, defined by instruction uDef</summary>
+	struct available
+	{
+		/// <summary>the register</summary>
+		unsigned uReg;
+		/// <summary>index of the defining instruction</summary>
+		unsigned uDef;
+	};
+
+	/// <summary>
+	/// fold constant operations (pure host functions of constant arguments included), reuse equal operations and known variable values,
+	/// a value is reused only where its definition is executed on every path (nothing is known at a loop start)
+	/// </summary>
+	void share_values(std::vector<bool>& abKeep)
+	{
+		std::vector<ts_instruction>& asCode = sCode.asCode;
+		const unsigned uNone = ~0u;
+
+		// registers : renamed to, constant, 1 or 0 only
+		std::vector<unsigned> auRename(sCode.afFrame.size());
+		for (unsigned uR = 0; uR < (unsigned)auRename.size(); uR++) auRename[uR] = uR;
+		std::vector<bool> abConstant(sCode.afFrame.size(), false), abBoolean(sCode.afFrame.size(), false);
+		for (const auto& s : sCode.auConstants)
+		{
+			abConstant[s.second] = true;
+			abBoolean[s.second] = (sCode.afFrame[s.second] == (te_type)0) || (sCode.afFrame[s.second] == (te_type)1);
+		}
+		auto constant = [&](te_type f)
+			{
+				unsigned uReg = sCode.constant(f);
+				if (uReg >= auRename.size())
+				{
+					auRename.push_back(uReg);
+					abConstant.push_back(true);
+					abBoolean.push_back((f == (te_type)0) || (f == (te_type)1));
+				}
+				return uReg;
+			};
+
+		// forward jumps by target, loop starts
+		std::vector<std::vector<unsigned>> aauJumpsTo(asCode.size() + 1);
+		std::vector<bool> abLoopStart(asCode.size() + 1, false);
+		for (unsigned uPc = 0; uPc < (unsigned)asCode.size(); uPc++)
+		{
+			if ((asCode[uPc].eOp == ts_opcode::op_jump) || (asCode[uPc].eOp == ts_opcode::op_jump_false) || (asCode[uPc].eOp == ts_opcode::op_loop))
+				aauJumpsTo[std::min((size_t)asCode[uPc].uB, asCode.size())].push_back(uPc);
+			if (asCode[uPc].eOp == ts_opcode::op_loop) abLoopStart[uPc + 1] = true;
+		}
+
+		// available values : operations by operation and operands, variables and booleans by slot
+		std::map<std::array<unsigned, 3>, available> asValues;
+		std::vector<available> asVars(psSymbols->apfVars.size(), { uNone, 0 }), asBools(psSymbols->apbBools.size(), { uNone, 0 });
+		auto forget = [&]()
+			{
+				asValues.clear();
+				for (available& s : asVars) s.uReg = uNone;
+				for (available& s : asBools) s.uReg = uNone;
+			};
+
+		// the function bodies follow the program, each invoked from several places
+		const size_t uMain = program_end(asCode);
+		const std::map<unsigned, body_effects> asBodies = function_bodies();
+
+		for (unsigned uPc = 0; uPc < (unsigned)asCode.size(); uPc++)
+		{
+			// values of the previous iteration reach the loop start, nothing is known at a body start
+			if ((abLoopStart[uPc]) || ((uPc > uMain) && (asCode[uPc - 1].eOp == ts_opcode::op_end)))
+				forget();
+
+			// values defined between a jump and its target are not known here
+			for (unsigned uFrom : aauJumpsTo[uPc])
+			{
+				auto skipped = [uFrom, uPc](unsigned uDef) { return (uDef > uFrom) && (uDef < uPc); };
+				for (auto ps = asValues.begin(); ps != asValues.end();)
+					ps = (skipped(ps->second.uDef)) ? asValues.erase(ps) : std::next(ps);
+				for (available& s : asVars) if (skipped(s.uDef)) s.uReg = uNone;
+				for (available& s : asBools) if (skipped(s.uDef)) s.uReg = uNone;
+			}
+
+			ts_instruction& s = asCode[uPc];
+			operands apuRegs = {};
+			unsigned uOperands = operand_registers(s, apuRegs);
+			for (unsigned uO = 0; uO < uOperands; uO++)
+				*apuRegs[uO] = auRename[*apuRegs[uO]];
+
+			switch (s.eOp)
+			{
+			case ts_opcode::op_load_var:
+			case ts_opcode::op_load_bool:
+			{
+				available& sV = (s.eOp == ts_opcode::op_load_var) ? asVars[s.uB] : asBools[s.uB];
+				if (sV.uReg != uNone)
+				{
+					auRename[s.uA] = sV.uReg;
+					abKeep[uPc] = false;
+				}
+				else
+					sV = { s.uA, uPc };
+				abBoolean[s.uA] = (s.eOp == ts_opcode::op_load_bool);
+			}
+			break;
+			case ts_opcode::op_store_var:
+				asVars[s.uA] = { s.uB, uPc };
+				break;
+			case ts_opcode::op_store_bool:
+				// a later load is the stored register only if that is 1 or 0
+				asBools[s.uA] = { abBoolean[s.uB] ? s.uB : uNone, uPc };
+				break;
+			case ts_opcode::op_invoke:
+			{
+				// the slots the body stores are not known after, nothing is if it calls an impure host function
+				const body_effects& sB = asBodies.at(s.uB);
+				for (size_t uS = 0; uS < asVars.size(); uS++) if (sB.abStores[uS]) asVars[uS].uReg = uNone;
+				for (size_t uS = 0; uS < asBools.size(); uS++) if (sB.abStores[asVars.size() + uS]) asBools[uS].uReg = uNone;
+				if (sB.bImpure) forget();
+			}
+			break;
+			case ts_opcode::op_jump_false:
+				if (abConstant[s.uA])
+				{
+					if (sCode.afFrame[s.uA] == (te_type)0)
+						s = { ts_opcode::op_jump, 0, s.uB, 0 };
+					else
+						abKeep[uPc] = false;
+				}
+				break;
+			case ts_opcode::op_native:
+			{
+				// a pure host function of constant arguments is called once, here
+				const ts_native& sF = psSymbols->asNatives[s.uC];
+				bool bConstant = sF.bPure;
+				std::array<te_type, ts_native::uMaxArity> afArgs = {};
+				for (unsigned uO = 0; (bConstant) && (uO < uOperands); uO++)
+				{
+					bConstant = abConstant[*apuRegs[uO]];
+					afArgs[uO] = sCode.afFrame[*apuRegs[uO]];
+				}
+				if (bConstant)
+				{
+					auRename[s.uA] = constant(sF.pfFunction(afArgs.data(), sF.pvContext));
+					abKeep[uPc] = false;
+				}
+				// an impure one may read and write any slot through its context
+				else if (!sF.bPure)
+					forget();
+			}
+			break;
+			default:
+				if (pure(s.eOp))
+				{
+					bool bConstant = true;
+					for (unsigned uO = 0; uO < uOperands; uO++) bConstant = bConstant && abConstant[*apuRegs[uO]];
+					if (bConstant)
+					{
+						te_type fC = (uOperands > 1) ? sCode.afFrame[s.uC] : (te_type)0;
+						auRename[s.uA] = constant(fold(s, sCode.afFrame[s.uB], fC));
+						abKeep[uPc] = false;
+						break;
+					}
+
+					std::array<unsigned, 3> auKey = { (unsigned)s.eOp, s.uB, (uOperands > 1) || (s.eOp == ts_opcode::op_call) ? s.uC : 0 };
+					auto ps = asValues.find(auKey);
+					if (ps != asValues.end())
+					{
+						auRename[s.uA] = ps->second.uReg;
+						abKeep[uPc] = false;
+					}
+					else
+					{
+						asValues[auKey] = { s.uA, uPc };
+						abBoolean[s.uA] = boolean_result(s.eOp);
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	/// <summary>remove instructions no path reaches</summary>
+	void remove_unreachable(std::vector<bool>& abKeep)
+	{
+		const std::vector<ts_instruction>& asCode = sCode.asCode;
+		std::vector<bool> abReached(asCode.size() + 1, false);
+		abReached[0] = true;
+		for (size_t uPc = 0; uPc < asCode.size(); uPc++)
+		{
+			const ts_instruction& s = asCode[uPc];
+			if (!abReached[uPc])
+			{
+				// the final end stays, jump targets never pass the code end, loops keep their pair of instructions
+				if ((uPc + 1 < asCode.size()) && (s.eOp != ts_opcode::op_loop) && (s.eOp != ts_opcode::op_next)) abKeep[uPc] = false;
+				continue;
+			}
+			if (!abKeep[uPc])
+				abReached[uPc + 1] = true;
+			else if (s.eOp == ts_opcode::op_jump)
+				abReached[std::min((size_t)s.uB, asCode.size())] = true;
+			else if ((s.eOp == ts_opcode::op_jump_false) || (s.eOp == ts_opcode::op_loop) || (s.eOp == ts_opcode::op_next) || (s.eOp == ts_opcode::op_invoke))
+				abReached[uPc + 1] = abReached[std::min((size_t)s.uB, asCode.size())] = true;
+			else if (s.eOp != ts_opcode::op_end)
+				abReached[uPc + 1] = true;
+		}
+	}
+
+	/// <summary>
+	/// remove stores overwritten on every path before the value is read
+	/// (all slots are read at the script end, at each loop end and by impure host function calls) and operations of unused registers (impure host function calls stay)
+	/// </summary>
+	void remove_dead(std::vector<bool>& abKeep)
+	{
+		std::vector<ts_instruction>& asCode = sCode.asCode;
+		const size_t uVars = psSymbols->apfVars.size(), uSlots = uVars + psSymbols->apbBools.size();
+
+		// slots read before written, per instruction (booleans follow the variables), the host slots at the end
+		std::vector<bool> abExit(uSlots, true);
+		for (size_t uS = psSymbols->uHostVars; uS < uVars; uS++) abExit[uS] = false;
+		for (size_t uS = uVars + psSymbols->uHostBools; uS < uSlots; uS++) abExit[uS] = false;
+		std::vector<std::vector<bool>> aabLive(asCode.size() + 1, abExit);
+		std::vector<bool> abUsed(sCode.afFrame.size(), false);
+		const size_t uMain = program_end(asCode);
+		const std::map<unsigned, body_effects> asBodies = function_bodies();
+		for (size_t uPc = asCode.size(); uPc-- > 0;)
+		{
+			ts_instruction& s = asCode[uPc];
+			std::vector<bool>& abLive = aabLive[uPc];
+			if (!abKeep[uPc])
+			{
+				abLive = aabLive[uPc + 1];
+				continue;
+			}
+
+			// live after this instruction
+			size_t uTarget = std::min((size_t)s.uB, asCode.size());
+			if ((s.eOp == ts_opcode::op_end) && (uPc <= uMain)) abLive = abExit;
+			else if ((s.eOp == ts_opcode::op_next) || (s.eOp == ts_opcode::op_end)) std::fill(abLive.begin(), abLive.end(), true);
+			else if (s.eOp == ts_opcode::op_jump) abLive = aabLive[uTarget];
+			else
+			{
+				abLive = aabLive[uPc + 1];
+				if ((s.eOp == ts_opcode::op_jump_false) || (s.eOp == ts_opcode::op_loop))
+					for (size_t uS = 0; uS < uSlots; uS++) if (aabLive[uTarget][uS]) abLive[uS] = true;
+			}
+
+			// live before
+			switch (s.eOp)
+			{
+			case ts_opcode::op_store_var:
+			case ts_opcode::op_store_bool:
+			{
+				size_t uSlot = (s.eOp == ts_opcode::op_store_var) ? s.uA : uVars + s.uA;
+				if (!abLive[uSlot])
+				{
+					abKeep[uPc] = false;
+					break;
+				}
+				abLive[uSlot] = false;
+				abUsed[s.uB] = true;
+			}
+			break;
+			case ts_opcode::op_jump_false:
+				abUsed[s.uA] = true;
+				break;
+			case ts_opcode::op_loop:
+			case ts_opcode::op_next:
+				abUsed[s.uA] = abUsed[s.uC] = true;
+				break;
+			case ts_opcode::op_invoke:
+			{
+				// removed if no slot it stores is read (and no impure host function is called), else the slots the body loads are read
+				const body_effects& sB = asBodies.at(s.uB);
+				bool bLive = sB.bImpure;
+				for (size_t uS = 0; uS < uSlots; uS++) bLive = bLive || ((sB.abStores[uS]) && (abLive[uS]));
+				if (!bLive)
+				{
+					abKeep[uPc] = false;
+					break;
+				}
+				for (size_t uS = 0; uS < uSlots; uS++) if (sB.abLoads[uS]) abLive[uS] = true;
+				if (sB.bImpure) std::fill(abLive.begin(), abLive.end(), true);
+			}
+			break;
+			default:
+				if (defines_register(s.eOp))
+				{
+					if ((!abUsed[s.uA]) && (!impure(s)))
+					{
+						abKeep[uPc] = false;
+						break;
+					}
+					operands apuRegs = {};
+					unsigned uOperands = operand_registers(s, apuRegs);
+					for (unsigned uO = 0; uO < uOperands; uO++) abUsed[*apuRegs[uO]] = true;
+					if (s.eOp == ts_opcode::op_load_var) abLive[s.uB] = true;
+					else if (s.eOp == ts_opcode::op_load_bool) abLive[uVars + s.uB] = true;
+					else if (s.eOp == ts_opcode::op_tinyexpr)
+						for (unsigned uSlot : sCode.apsFallbacks[s.uB]->auSlots) abLive[uSlot] = true;
+					else if (impure(s))
+						std::fill(abLive.begin(), abLive.end(), true);
+				}
+				break;
+			}
+		}
+	}
+
+	/// <summary>remove the instructions not kept, renumber jump targets, registers and host function calls</summary>
+	void compact(const std::vector<bool>& abKeep)
+	{
+		std::vector<ts_instruction>& asCode = sCode.asCode;
+
+		// new instruction index of each old index (removed ones continue at the next kept one)
+		std::vector<unsigned> auIndex(asCode.size() + 1, 0);
+		for (size_t uPc = 0; uPc < asCode.size(); uPc++)
+			auIndex[uPc + 1] = auIndex[uPc] + (abKeep[uPc] ? 1 : 0);
+
+		// registers still used
+		const unsigned uNone = ~0u;
+		std::vector<unsigned> auReg(sCode.afFrame.size(), uNone);
+		std::vector<te_type> afFrame;
+		auto reg = [&](unsigned& uR)
+			{
+				if (auReg[uR] == uNone)
+				{
+					auReg[uR] = (unsigned)afFrame.size();
+					afFrame.push_back(sCode.afFrame[uR]);
+				}
+				uR = auReg[uR];
+			};
+
+		std::vector<ts_instruction> asKept;
+		std::vector<native_call> asNatives;
+		for (size_t uPc = 0; uPc < asCode.size(); uPc++)
+		{
+			if (!abKeep[uPc]) continue;
+			ts_instruction s = asCode[uPc];
+			operands apuRegs = {};
+			unsigned uOperands = operand_registers(s, apuRegs);
+			for (unsigned uO = 0; uO < uOperands; uO++) reg(*apuRegs[uO]);
+			if (s.eOp == ts_opcode::op_native)
+			{
+				// the calls of the kept instructions only
+				asNatives.push_back(std::move(sCode.asNatives[s.uB]));
+				s.uB = (unsigned)asNatives.size() - 1;
+			}
+			if ((defines_register(s.eOp)) || (s.eOp == ts_opcode::op_loop)) reg(s.uA);
+			if ((s.eOp == ts_opcode::op_jump) || (s.eOp == ts_opcode::op_jump_false) || (s.eOp == ts_opcode::op_loop) || (s.eOp == ts_opcode::op_next) || (s.eOp == ts_opcode::op_invoke))
+				s.uB = auIndex[std::min((size_t)s.uB, asCode.size())];
+			asKept.push_back(s);
+		}
+
+		std::unordered_map<uint64_t, unsigned> auConstants;
+		for (const auto& s : sCode.auConstants)
+			if (auReg[s.second] != uNone) auConstants[s.first] = auReg[s.second];
+
+		asCode = std::move(asKept);
+		sCode.asNatives = std::move(asNatives);
+		sCode.afFrame = std::move(afFrame);
+		sCode.auConstants = std::move(auConstants);
+	}
+
+	/// <summary>
+	/// build the dependency graph : for each slot the instructions to execute again if its value changed,
+	/// following the registers read and the blocks of changed conditions
+	/// (stores, jumps, loops and the end are always executed, so a slot holds its value of the current evaluation at
+	/// each point, slots both stored and read by the script change with each evaluation, their loads always execute)
+	/// </summary>
+	void build_dependencies()
+	{
+		const std::vector<ts_instruction>& asCode = sCode.asCode;
+		const size_t uVars = psSymbols->apfVars.size(), uSlots = uVars + psSymbols->apbBools.size();
+		sDependencies.uWords = (asCode.size() + 63) / 64;
+		sDependencies.auAlways.assign(sDependencies.uWords, 0);
+
+		// slots stored by the script (all of them by an impure host function)
+		std::vector<bool> abStored(uSlots, false);
+		for (const ts_instruction& s : asCode)
+		{
+			if (s.eOp == ts_opcode::op_store_var) abStored[s.uA] = true;
+			else if (s.eOp == ts_opcode::op_store_bool) abStored[uVars + s.uA] = true;
+			else if (impure(s)) std::fill(abStored.begin(), abStored.end(), true);
+		}
+
+		// one pass through the program, the slots each instruction depends on (sorted, usually few) :
+		// the slots of the registers read, the slots loaded, the slots of the conditions of the enclosing blocks,
+		// the rules only combine by "or", so the rows of several changed slots are combined by "or" at evaluation
+		std::vector<std::vector<unsigned>> aauRegister(sCode.afFrame.size());
+		struct block
+		{
+			size_t uEnd;
+			std::vector<unsigned> auSlots;
+		};
+		std::vector<block> asBlocks;
+		std::vector<unsigned> auBlocks, auSlots;
+		std::vector<std::vector<std::pair<unsigned, uint64_t>>> aasRows(uSlots);
+		uint64_t* puAlways = sDependencies.auAlways.data();
+		size_t uLoopEnd = 0;
+		for (size_t uPc = 0; uPc < asCode.size(); uPc++)
+		{
+			ts_instruction s = asCode[uPc];
+			const uint64_t uBit = (uint64_t)1 << (uPc & 63);
+
+			// blocks ended, slots of the conditions of the blocks enclosing this instruction
+			size_t uBlocks = asBlocks.size();
+			while ((uBlocks) && (asBlocks[uBlocks - 1].uEnd <= uPc)) uBlocks--;
+			if (uBlocks < asBlocks.size())
+			{
+				asBlocks.resize(uBlocks);
+				auBlocks.clear();
+				for (const block& sB : asBlocks) auBlocks.insert(auBlocks.end(), sB.auSlots.begin(), sB.auSlots.end());
+				std::sort(auBlocks.begin(), auBlocks.end());
+				auBlocks.erase(std::unique(auBlocks.begin(), auBlocks.end()), auBlocks.end());
+			}
+
+			auSlots = auBlocks;
+			operands apuRegs = {};
+			unsigned uOperands = operand_registers(s, apuRegs);
+			for (unsigned uO = 0; uO < uOperands; uO++)
+				auSlots.insert(auSlots.end(), aauRegister[*apuRegs[uO]].begin(), aauRegister[*apuRegs[uO]].end());
+
+			bool bAlways = false;
+			switch (s.eOp)
+			{
+			case ts_opcode::op_load_var: auSlots.push_back(s.uB); break;
+			case ts_opcode::op_load_bool: auSlots.push_back((unsigned)uVars + s.uB); break;
+			case ts_opcode::op_tinyexpr:
+				auSlots.insert(auSlots.end(), sCode.apsFallbacks[s.uB]->auSlots.begin(), sCode.apsFallbacks[s.uB]->auSlots.end());
+				break;
+			case ts_opcode::op_jump_false:
+			case ts_opcode::op_store_var:
+			case ts_opcode::op_store_bool:
+			case ts_opcode::op_jump:
+			case ts_opcode::op_end:
+			case ts_opcode::op_invoke:
+				bAlways = true;
+				break;
+			case ts_opcode::op_native:
+				// impure host functions are called on each evaluation
+				bAlways = impure(s);
+				break;
+			case ts_opcode::op_loop:
+				// registers change with each iteration, the whole loop executes
+				uLoopEnd = std::max(uLoopEnd, (size_t)s.uB);
+				break;
+			default: break;
+			}
+			bAlways = bAlways || (uPc < uLoopEnd);
+			std::sort(auSlots.begin(), auSlots.end());
+			auSlots.erase(std::unique(auSlots.begin(), auSlots.end()), auSlots.end());
+
+			// the rows of these slots, the always row for slots both stored and read (executed each evaluation)
+			for (unsigned uSlot : auSlots)
+			{
+				std::vector<std::pair<unsigned, uint64_t>>& asRow = aasRows[uSlot];
+				if ((asRow.size()) && (asRow.back().first == (unsigned)(uPc >> 6)))
+					asRow.back().second |= uBit;
+				else
+					asRow.push_back({ (unsigned)(uPc >> 6), uBit });
+				bAlways = bAlways || abStored[uSlot];
+			}
+			if (bAlways) puAlways[uPc >> 6] |= uBit;
+
+			if (((s.eOp == ts_opcode::op_jump_false) || (s.eOp == ts_opcode::op_loop)) && (auSlots.size()))
+			{
+				// the taken block may differ, include an else block (up to the target of the block's last jump)
+				size_t uEnd = s.uB;
+				for (size_t uIx = uPc + 1; uIx < uEnd; uIx++)
+					if ((asCode[uIx].eOp == ts_opcode::op_jump) || (asCode[uIx].eOp == ts_opcode::op_jump_false) || (asCode[uIx].eOp == ts_opcode::op_loop))
+						uEnd = std::max(uEnd, (size_t)asCode[uIx].uB);
+				if (uEnd > uPc + 1)
+				{
+					// blocks stay ordered by their end, the enclosing block ends last
+					size_t uIx = asBlocks.size();
+					while ((uIx) && (asBlocks[uIx - 1].uEnd < uEnd)) uIx--;
+					asBlocks.insert(asBlocks.begin() + uIx, { uEnd, auSlots });
+					auBlocks.insert(auBlocks.end(), auSlots.begin(), auSlots.end());
+					std::sort(auBlocks.begin(), auBlocks.end());
+					auBlocks.erase(std::unique(auBlocks.begin(), auBlocks.end()), auBlocks.end());
+				}
+			}
+			if (defines_register(s.eOp)) aauRegister[s.uA] = auSlots;
+		}
+
+		sDependencies.assign(aasRows);
+	}
+
+
+	/// <summary>
+	/// estimated work of parallel tasks (about nanoseconds) besides the critical path to wake the workers,
+	/// less work is evaluated on the calling thread
+	/// </summary>
+	static constexpr unsigned uParallelWork = 20000;
+
+	/// <summary>estimated cost of an instruction (about nanoseconds)</summary>
+	static unsigned work(const ts_instruction& s)
+	{
+		switch (s.eOp)
+		{
+		case ts_opcode::op_div:
+		case ts_opcode::op_sqrt: return 4;
+		case ts_opcode::op_mod: return 10;
+		case ts_opcode::op_call:
+		case ts_opcode::op_native: return 20;
+		case ts_opcode::op_pow:
+		case ts_opcode::op_atan2: return 25;
+		case ts_opcode::op_tinyexpr: return 200;
+		default: return 1;
+		}
+	}
+
+	/// <summary>
+	/// build the schedule : the program is split in units (an instruction, a block with its jumps or a loop),
+	/// linked by the registers, by the slots (store before load or store, load before store) and by the impure host function calls
+	/// (each one loads and stores every slot),
+	/// then the units are gathered to tasks from the end, each unit joining a task of its successors
+	/// as long as that task waits for no other task (so the tasks stay free of cycles)
+	/// </summary>
+	void build_schedule()
+	{
+		const std::vector<ts_instruction>& asCode = sCode.asCode;
+		const unsigned uNone = ~0u;
+		const size_t uVars = psSymbols->apfVars.size(), uSlots = uVars + psSymbols->apbBools.size();
+
+		// the units, blocks up to the target of their last jump, the program end and the function bodies excluded
+		struct unit
+		{
+			unsigned uBegin, uEnd, uWork;
+			std::vector<unsigned> auPredecessors, auSuccessors;
+		};
+		std::vector<unit> asUnits;
+		const unsigned uMain = (unsigned)program_end(asCode);
+		const std::map<unsigned, body_effects> asBodies = function_bodies();
+		for (unsigned uPc = 0; uPc < uMain;)
+		{
+			unsigned uEnd = uPc + 1;
+			if ((asCode[uPc].eOp == ts_opcode::op_jump) || (asCode[uPc].eOp == ts_opcode::op_jump_false) || (asCode[uPc].eOp == ts_opcode::op_loop))
+			{
+				uEnd = std::max(uEnd, asCode[uPc].uB);
+				for (unsigned uIx = uPc + 1; uIx < uEnd; uIx++)
+					if ((asCode[uIx].eOp == ts_opcode::op_jump) || (asCode[uIx].eOp == ts_opcode::op_jump_false) || (asCode[uIx].eOp == ts_opcode::op_loop))
+						uEnd = std::max(uEnd, asCode[uIx].uB);
+			}
+			asUnits.push_back({ uPc, uEnd, 0, {}, {} });
+			uPc = uEnd;
+		}
+
+		// the links : register definitions, last store and loads since of each slot, the last impure host function call
+		std::vector<unsigned> auDefinition(sCode.afFrame.size(), uNone), auStore(uSlots, uNone);
+		unsigned uImpure = uNone;
+		std::vector<std::vector<unsigned>> aauLoads(uSlots);
+		for (unsigned uU = 0; uU < (unsigned)asUnits.size(); uU++)
+		{
+			unit& sU = asUnits[uU];
+			auto link = [&](unsigned uFrom) { if ((uFrom != uNone) && (uFrom != uU)) sU.auPredecessors.push_back(uFrom); };
+			auto load = [&](size_t uSlot)
+				{
+					link(auStore[uSlot]);
+					aauLoads[uSlot].push_back(uU);
+				};
+			auto store = [&](size_t uSlot)
+				{
+					link(auStore[uSlot]);
+					for (unsigned uL : aauLoads[uSlot]) link(uL);
+					aauLoads[uSlot].clear();
+					auStore[uSlot] = uU;
+				};
+			for (unsigned uPc = sU.uBegin; uPc < sU.uEnd; uPc++)
+			{
+				ts_instruction s = asCode[uPc];
+				sU.uWork += work(s);
+				operands apuRegs = {};
+				unsigned uOperands = operand_registers(s, apuRegs);
+				for (unsigned uO = 0; uO < uOperands; uO++) link(auDefinition[*apuRegs[uO]]);
+				switch (s.eOp)
+				{
+				case ts_opcode::op_load_var: load(s.uB); break;
+				case ts_opcode::op_load_bool: load(uVars + s.uB); break;
+				case ts_opcode::op_store_var: store(s.uA); break;
+				case ts_opcode::op_store_bool: store(uVars + s.uA); break;
+				case ts_opcode::op_tinyexpr:
+					for (unsigned uSlot : sCode.apsFallbacks[s.uB]->auSlots) load(uSlot);
+					break;
+				case ts_opcode::op_invoke:
+				{
+					const body_effects& sB = asBodies.at(s.uB);
+					for (size_t uSlot = 0; uSlot < uSlots; uSlot++) if (sB.abLoads[uSlot]) load(uSlot);
+					for (size_t uSlot = 0; uSlot < uSlots; uSlot++) if (sB.abStores[uSlot]) store(uSlot);
+					sU.uWork += sB.uWork;
+					if (sB.bImpure)
+					{
+						for (size_t uSlot = 0; uSlot < uSlots; uSlot++) store(uSlot);
+						link(uImpure);
+						uImpure = uU;
+					}
+				}
+				break;
+				case ts_opcode::op_native:
+					// impure calls in script order, as loads and stores of every slot
+					if (impure(s))
+					{
+						for (size_t uSlot = 0; uSlot < uSlots; uSlot++) store(uSlot);
+						link(uImpure);
+						uImpure = uU;
+					}
+					break;
+				default: break;
+				}
+				if (defines_register(s.eOp)) auDefinition[s.uA] = uU;
+			}
+			std::sort(sU.auPredecessors.begin(), sU.auPredecessors.end());
+			sU.auPredecessors.erase(std::unique(sU.auPredecessors.begin(), sU.auPredecessors.end()), sU.auPredecessors.end());
+			for (unsigned uP : sU.auPredecessors) asUnits[uP].auSuccessors.push_back(uU);
+		}
+
+		// gather the units to tasks from the end
+		struct gathered
+		{
+			std::vector<unsigned> auUnits;
+			std::set<unsigned> auSuccessors;
+			unsigned uWork = 0;
+			bool bWaits = false;
+		};
+		std::vector<gathered> asGathered;
+		std::vector<unsigned> auTask(asUnits.size(), uNone);
+		for (unsigned uU = (unsigned)asUnits.size(); uU-- > 0;)
+		{
+			std::set<unsigned> auNext;
+			for (unsigned uS : asUnits[uU].auSuccessors) auNext.insert(auTask[uS]);
+			unsigned uT = uNone;
+			for (unsigned uN : auNext)
+				if (!asGathered[uN].bWaits) { uT = uN; break; }
+			if (uT == uNone)
+			{
+				uT = (unsigned)asGathered.size();
+				asGathered.emplace_back();
+			}
+			auTask[uU] = uT;
+			asGathered[uT].auUnits.push_back(uU);
+			asGathered[uT].uWork += asUnits[uU].uWork;
+			for (unsigned uN : auNext)
+			{
+				if (uN == uT) continue;
+				asGathered[uT].auSuccessors.insert(uN);
+				asGathered[uN].bWaits = true;
+			}
+		}
+
+		// longest path to the end of each task (successors were created before, the index is smaller)
+		std::vector<unsigned> auPath(asGathered.size(), 0);
+		unsigned uTotal = 0, uCritical = 0;
+		for (unsigned uT = 0; uT < (unsigned)asGathered.size(); uT++)
+		{
+			unsigned uLongest = 0;
+			for (unsigned uS : asGathered[uT].auSuccessors) uLongest = std::max(uLongest, auPath[uS]);
+			auPath[uT] = asGathered[uT].uWork + uLongest;
+			uTotal += asGathered[uT].uWork;
+			uCritical = std::max(uCritical, auPath[uT]);
+		}
+
+		// order the tasks, each ready task by its longest path
+		std::vector<unsigned> auWaiting(asGathered.size(), 0), auOrder, auIndex(asGathered.size(), uNone);
+		for (const gathered& sG : asGathered)
+			for (unsigned uS : sG.auSuccessors) auWaiting[uS]++;
+		std::vector<unsigned> auReady;
+		for (unsigned uT = 0; uT < (unsigned)asGathered.size(); uT++)
+			if (!auWaiting[uT]) auReady.push_back(uT);
+		while (!auReady.empty())
+		{
+			auto ps = std::max_element(auReady.begin(), auReady.end(), [&](unsigned uA, unsigned uB) { return auPath[uA] < auPath[uB]; });
+			unsigned uT = *ps;
+			auReady.erase(ps);
+			auIndex[uT] = (unsigned)auOrder.size();
+			auOrder.push_back(uT);
+			for (unsigned uS : asGathered[uT].auSuccessors)
+				if (--auWaiting[uS] == 0) auReady.push_back(uS);
+		}
+
+		// the tasks, units in program order, adjacent units in one range
+		sSchedule.asTasks.clear();
+		for (unsigned uT : auOrder)
+		{
+			schedule::task sTask;
+			std::vector<unsigned>& auUnits = asGathered[uT].auUnits;
+			std::sort(auUnits.begin(), auUnits.end());
+			for (unsigned uU : auUnits)
+			{
+				if ((!sTask.asRanges.empty()) && (sTask.asRanges.back().second == asUnits[uU].uBegin))
+					sTask.asRanges.back().second = asUnits[uU].uEnd;
+				else
+					sTask.asRanges.push_back({ asUnits[uU].uBegin, asUnits[uU].uEnd });
+			}
+			for (unsigned uS : asGathered[uT].auSuccessors) sTask.auSuccessors.push_back(auIndex[uS]);
+			sTask.uPredecessors = 0;
+			sSchedule.asTasks.push_back(sTask);
+		}
+		for (const schedule::task& sTask : sSchedule.asTasks)
+			for (unsigned uS : sTask.auSuccessors) sSchedule.asTasks[uS].uPredecessors++;
+		sSchedule.bParallel = (auOrder.size() == asGathered.size()) && (sSchedule.asTasks.size() > 1) && (uTotal - uCritical >= uParallelWork);
+	}
+
+
+	/// <summary>the compiled script instructions and initial register frame</summary>
+	bytecode sCode;
+	/// <summary>instructions reached by each slot, for the incremental evaluation</summary>
+	dependencies sDependencies;
+	/// <summary>independent parts of the program, for the parallel evaluation</summary>
+	schedule sSchedule;
+	/// <summary>compiled symbol table of all variables and booleans used within this script</summary>
+	std::shared_ptr<const symbol_table> psSymbols;
+	/// <summary>the code block level in opened braces (compile time)</summary>
+	unsigned uBlockLevel = 0;
+	/// <summary>0 if script compiled</summary>
+	int64_t nErr = TS_OK;
+	/// <summary>y position of the error</summary>
+	uint32_t uErrLine = 0;
+	/// <summary>X position of the error</summary>
+	uint32_t uErrMark = 0;
+};
+
+/// <summary>
+/// execution context of a compiled script, the bindings and the scratch space of one evaluating thread
+/// (any number of contexts evaluate the same program concurrently, one context per thread)
+/// </summary>
+class ts_context
+{
+public:
+	/// <summary>
+	/// bound to the addresses the program was compiled with,
+	/// slots compiled without address are bound to a zero value of the context
+	/// </summary>
+	/// <param name="_psProgram">the compiled script</param>
+	explicit ts_context(std::shared_ptr<const ts_program> _psProgram)
+		: psProgram(_psProgram)
+		, apfVars(_psProgram->psSymbols->apfVars)
+		, apbBools(_psProgram->psSymbols->apbBools)
+		, afUnbound(std::make_unique<te_type[]>(_psProgram->psSymbols->apfVars.size()))
+		, abUnbound(std::make_unique<bool[]>(_psProgram->psSymbols->apbBools.size()))
+		, afRegisters(_psProgram->sCode.afFrame)
+	{
+		for (size_t uIx = 0; uIx < apfVars.size(); uIx++)
+			if (!apfVars[uIx]) apfVars[uIx] = &afUnbound[uIx];
+		for (size_t uIx = 0; uIx < apbBools.size(); uIx++)
+			if (!apbBools[uIx]) apbBools[uIx] = &abUnbound[uIx];
+		apsFallbacks = clone_fallbacks();
+	}
+	/// <summary>copy the bindings and the layout, the scratch space is never shared</summary>
+	ts_context(const ts_context& cC) : ts_context(cC.psProgram)
+	{
+		for (size_t uIx = 0; uIx < apfVars.size(); uIx++)
+		{
+			if (cC.apfVars[uIx] == &cC.afUnbound[uIx]) afUnbound[uIx] = cC.afUnbound[uIx];
+			else apfVars[uIx] = cC.apfVars[uIx];
+		}
+		for (size_t uIx = 0; uIx < apbBools.size(); uIx++)
+		{
+			if (cC.apbBools[uIx] == &cC.abUnbound[uIx]) abUnbound[uIx] = cC.abUnbound[uIx];
+			else apbBools[uIx] = cC.apbBools[uIx];
+		}
+		asVarLayout = cC.asVarLayout;
+		asBoolLayout = cC.asBoolLayout;
+		psJit = cC.psJit;
+	}
+	ts_context(ts_context&&) = default;
+	ts_context& operator=(ts_context&&) = default;
+	ts_context& operator=(const ts_context& cC)
+	{
+		if (this != &cC) *this = ts_context(cC);
+		return *this;
+	}
+
+	/// <summary>evaluate script based on current variable values</summary>
+	void evaluate()
+	{
+		if (psProgram->nErr) return;
+		if (psJit)
+			psJit->function()(afRegisters.data(), apfVars.data(), apbBools.data(), apsFallbacks.data());
+		else
+			execute(psProgram->sCode.asCode.data(), afRegisters.data(), apfVars.data(), apbBools.data(), apsFallbacks.data(), psProgram->sCode.asNatives.data());
+		bEvaluated = true;
+	}
+
+	/// <summary>
+	/// evaluate script, independent parts of the program concurrently on the workers of the thread pool
+	/// (if the estimated work justifies waking the workers, see ts_program::parallel(), else on the calling thread,
+	/// always interpreted, distinct slots must be bound to distinct addresses)
+	/// </summary>
+	/// <param name="cPool">the worker threads</param>
+	void evaluate(ts_thread_pool& cPool)
+	{
+		if (psProgram->nErr) return;
+		const ts_program::schedule& sS = psProgram->sSchedule;
+		if ((!sS.bParallel) || (cPool.size() < 2))
+		{
+			evaluate();
+			return;
+		}
+
+		// predecessors pending per task, the workers take the tasks in order
+		const size_t uTasks = sS.asTasks.size();
+		if (!psTasks) psTasks = std::make_unique<task_state>(uTasks);
+		task_state& sState = *psTasks;
+		for (size_t uT = 0; uT < uTasks; uT++) sState.auWaiting[uT].store(sS.asTasks[uT].uPredecessors, std::memory_order_relaxed);
+		sState.uNext.store(0, std::memory_order_relaxed);
+
+		const ts_instruction* psCode = psProgram->sCode.asCode.data();
+		const ts_program::native_call* asNatives = psProgram->sCode.asNatives.data();
+		cPool.run([&](unsigned)
+			{
+				for (;;)
+				{
+					size_t uT = sState.uNext.fetch_add(1, std::memory_order_relaxed);
+					if (uT >= uTasks) return;
+
+					// predecessors are taken before, so they are executed by running workers
+					const ts_program::schedule::task& sT = sS.asTasks[uT];
+					while (sState.auWaiting[uT].load(std::memory_order_acquire) != 0) std::this_thread::yield();
+					for (const std::pair<unsigned, unsigned>& sR : sT.asRanges)
+						execute<false, true>(psCode, afRegisters.data(), apfVars.data(), apbBools.data(), apsFallbacks.data(), asNatives, nullptr, sR.first, sR.second);
+					for (unsigned uS : sT.auSuccessors) sState.auWaiting[uS].fetch_sub(1, std::memory_order_release);
+				}
+			});
+		bEvaluated = true;
+	}
+
+	/// <summary>
+	/// incremental evaluation, only the instructions depending on the changed slots are executed again
+	/// (the other results are kept from the last evaluation of this context), the results equal evaluate()
+	/// if all values changed outside the script since the last evaluation are given here
+	/// (a full evaluation if not yet evaluated since construction or rebinding, always interpreted)
+	/// </summary>
+	/// <param name="auVars">changed variables, slots as returned by ts_program::var_slot()</param>
+	/// <param name="auBools">changed booleans, slots as returned by ts_program::bool_slot()</param>
+	void evaluate_changed(const std::vector<unsigned>& auVars, const std::vector<unsigned>& auBools = {})
+	{
+		if (psProgram->nErr) return;
+		if (!bEvaluated)
+		{
+			evaluate();
+			return;
+		}
+
+		// instructions to execute, the rows of the changed slots combined
+		const ts_program::dependencies& sD = psProgram->sDependencies;
+		const size_t uVars = apfVars.size(), uBools = apbBools.size(), uWords = sD.uWords;
+		auExecute.assign(sD.auAlways.begin(), sD.auAlways.end());
+		uint64_t* puExecute = auExecute.data();
+		for (unsigned uSlot : auVars)
+			if (uSlot < uVars) sD.combine(uSlot, puExecute);
+		for (unsigned uSlot : auBools)
+			if (uSlot < uBools) sD.combine(uVars + uSlot, puExecute);
+
+		// most instructions affected, the plain loop is faster
+		size_t uExecuted = 0;
+		for (size_t uW = 0; uW < uWords; uW++) uExecuted += std::bitset<64>(puExecute[uW]).count();
+		if (uExecuted * 4 > psProgram->sCode.asCode.size() * 3)
+		{
+			execute(psProgram->sCode.asCode.data(), afRegisters.data(), apfVars.data(), apbBools.data(), apsFallbacks.data(), psProgram->sCode.asNatives.data());
+			return;
+		}
+		execute<true>(psProgram->sCode.asCode.data(), afRegisters.data(), apfVars.data(), apbBools.data(), apsFallbacks.data(), psProgram->sCode.asNatives.data(), puExecute);
+	}
+
+	/// <summary>
+	/// select the backend of evaluate(), the JIT compiles the program on selection
+	/// (copies of this context share the compiled code, batches always use the lane kernels)
+	/// </summary>
+	/// <param name="eBackend">interpreter or JIT</param>
+	/// <returns>TS_OK, TS_FAIL if script not compiled or no JIT on this platform (interpreter stays selected)</returns>
+	int64_t set_backend(ts_backend eBackend)
+	{
+		psJit.reset();
+		if (eBackend == ts_backend::interpreter) return TS_OK;
+		if (psProgram->nErr) return TS_FAIL;
+		psJit = jit_compile(*psProgram);
+		return (psJit) ? TS_OK : TS_FAIL;
+	}
+
+	/// <summary>the backend of evaluate()</summary>
+	ts_backend backend() const { return (psJit) ? ts_backend::jit : ts_backend::interpreter; }
+
+	/// <summary>
+	/// evaluate script for a number of rows (structure of arrays)
+	/// each variable or boolean given here points to a column of uRows values
+	/// instead of a single value, the column is matched to the script variable by name
+	/// script variables without a column have the same value for all rows
+	/// (if assigned by the script such a value is row local, the last row is written back)
+	/// </summary>
+	/// <param name="asColumns">variable columns</param>
+	/// <param name="asBoolColumns">boolean columns</param>
+	/// <param name="uRows">number of rows, size of each column</param>
+	/// <param name="eMath">strict (results equal evaluate()) or fast math</param>
+	/// <param name="eSimd">instruction set, limited to the instruction sets supported by the CPU</param>
+	/// <returns>TS_OK, TS_FAIL if script not compiled or a column is not a script variable</returns>
+	int64_t evaluate_batch(const std::set<ts_variable>& asColumns, const std::set<ts_boolean>& asBoolColumns, size_t uRows,
+		ts_math eMath = ts_math::strict, ts_simd eSimd = ts_simd::automatic)
+	{
+		return run_batch(asColumns, asBoolColumns, uRows, nullptr, eMath, eSimd);
+	}
+
+	/// <summary>
+	/// evaluate script for a number of rows on all workers of the thread pool
+	/// (same as evaluate_batch() above, chunks of rows are balanced by work stealing)
+	/// </summary>
+	/// <param name="asColumns">variable columns</param>
+	/// <param name="asBoolColumns">boolean columns</param>
+	/// <param name="uRows">number of rows, size of each column</param>
+	/// <param name="cPool">the worker threads</param>
+	/// <param name="eMath">strict (results equal evaluate()) or fast math</param>
+	/// <param name="eSimd">instruction set, limited to the instruction sets supported by the CPU</param>
+	/// <returns>TS_OK, TS_FAIL if script not compiled or a column is not a script variable</returns>
+	int64_t evaluate_batch(const std::set<ts_variable>& asColumns, const std::set<ts_boolean>& asBoolColumns, size_t uRows,
+		ts_thread_pool& cPool, ts_math eMath = ts_math::strict, ts_simd eSimd = ts_simd::automatic)
+	{
+		return run_batch(asColumns, asBoolColumns, uRows, &cPool, eMath, eSimd);
+	}
+
+
+	/// <summary>
+	/// bind variables and booleans by name, slots not named here keep their address
+	/// (the names are resolved here, evaluation only uses the slot addresses)
+	/// </summary>
+	/// <param name="asVars">the variables to rebind</param>
+	/// <param name="asBools">the booleans to rebind</param>
+	/// <returns>TS_OK, TS_FAIL if a name is not a script variable or an address is nullptr (nothing rebound)</returns>
+	int64_t bind(const std::set<ts_variable>& asVars, const std::set<ts_boolean>& asBools)
+	{
+		const ts_program::symbol_table& sSymbols = *psProgram->psSymbols;
+		std::vector<std::pair<unsigned, te_type*>> asVarSlots;
+		std::vector<std::pair<unsigned, bool*>> asBoolSlots;
+		for (const ts_variable& s : asVars)
+		{
+			int nIx = sSymbols.find_var(s.m_name);
+			if ((nIx < 0) || (s.m_value == nullptr)) return TS_FAIL;
+			asVarSlots.push_back({ (unsigned)nIx, s.m_value });
+		}
+		for (const ts_boolean& s : asBools)
+		{
+			int nIx = sSymbols.find_bool(s.atName);
+			if ((nIx < 0) || (s.pbValue == nullptr)) return TS_FAIL;
+			asBoolSlots.push_back({ (unsigned)nIx, s.pbValue });
+		}
+		for (auto& sSlot : asVarSlots) apfVars[sSlot.first] = sSlot.second;
+		for (auto& sSlot : asBoolSlots) apbBools[sSlot.first] = sSlot.second;
+		bEvaluated = false;
+		return TS_OK;
+	}
+
+	/// <summary>
+	/// record the layout of a struct or an array, all slots currently bound
+	/// to an address within the prototype are rebound by bind_instance()
+	/// </summary>
+	/// <param name="pPrototype">the instance the slots are bound to</param>
+	/// <param name="uSize">size of the instance in bytes</param>
+	/// <returns>number of slots within the layout</returns>
+	size_t layout(const void* pPrototype, size_t uSize)
+	{
+		const char* pcBegin = (const char*)pPrototype;
+		asVarLayout.clear();
+		asBoolLayout.clear();
+		for (unsigned uIx = 0; uIx < (unsigned)apfVars.size(); uIx++)
+		{
+			const char* pc = (const char*)apfVars[uIx];
+			if ((pc >= pcBegin) && (pc + sizeof(te_type) <= pcBegin + uSize)) asVarLayout.push_back({ uIx, (size_t)(pc - pcBegin) });
+		}
+		for (unsigned uIx = 0; uIx < (unsigned)apbBools.size(); uIx++)
+		{
+			const char* pc = (const char*)apbBools[uIx];
+			if ((pc >= pcBegin) && (pc + sizeof(bool) <= pcBegin + uSize)) asBoolLayout.push_back({ uIx, (size_t)(pc - pcBegin) });
+		}
+		return asVarLayout.size() + asBoolLayout.size();
+	}
+	/// <summary>record the layout of a struct, see layout() above</summary>
+	template<class T> size_t layout(const T& sPrototype) { return layout(&sPrototype, sizeof(T)); }
+
+	/// <summary>bind the slots of the recorded layout to another instance (no name lookup, no allocation)</summary>
+	/// <param name="pInstance">instance of the same type as the prototype</param>
+	void bind_instance(void* pInstance)
+	{
+		char* pc = (char*)pInstance;
+		for (const slot_offset& s : asVarLayout) apfVars[s.uSlot] = (te_type*)(pc + s.uOffset);
+		for (const slot_offset& s : asBoolLayout) apbBools[s.uSlot] = (bool*)(pc + s.uOffset);
+		bEvaluated = false;
+	}
+	/// <summary>bind the slots of the recorded layout to another instance, see bind_instance() above</summary>
+	template<class T> void bind_instance(T& sInstance) { bind_instance((void*)&sInstance); }
+
+	/// <summary>returns error message and position of the program</summary>
+	std::pair<int64_t, uint32_t> error() const
+	{
+		return psProgram->error();
+	}
+
+	/// <summary>the compiled script</summary>
+	const std::shared_ptr<const ts_program>& program() const { return psProgram; }
+
+private:
+
+	/// <summary>number of rows executed together by evaluate_batch()</summary>
+	static constexpr unsigned uBatchLanes = 64;
+
+	/// <summary>
+	/// slot binding of a batch evaluation, each slot points to the lanes of the current rows
+	/// (the current chunk of its column or the broadcast value of a variable without column)
+	/// </summary>
+	struct lane_binding
+	{
+		/// <param name="sSymbols">the script symbol table</param>
+		/// <param name="sCode">the compiled script</param>
+		explicit lane_binding(const ts_program::symbol_table& sSymbols, const ts_program::bytecode& sCode)
+			: apfColumns(sSymbols.apfVars.size(), nullptr)
+			, apbColumns(sSymbols.apbBools.size(), nullptr)
+			, apfLanes(sSymbols.apfVars.size(), nullptr)
+			, apbLanes(sSymbols.apbBools.size(), nullptr)
+			, aeVarUse(sSymbols.apfVars.size(), slot_use::none)
+			, aeBoolUse(sSymbols.apbBools.size(), slot_use::none)
+		{
+			// get the slots referenced by the script
+			for (const ts_instruction& s : sCode.asCode)
+			{
+				switch (s.eOp)
+				{
+				case ts_opcode::op_load_var: use(aeVarUse, s.uB, slot_use::read); break;
+				case ts_opcode::op_store_var: use(aeVarUse, s.uA, slot_use::assigned); break;
+				case ts_opcode::op_load_bool: use(aeBoolUse, s.uB, slot_use::read); break;
+				case ts_opcode::op_store_bool: use(aeBoolUse, s.uA, slot_use::assigned); break;
+				default: break;
+				}
+			}
+			for (const std::shared_ptr<ts_program::tinyexpr_fallback>& ps : sCode.apsFallbacks)
+				for (unsigned uIx : ps->auSlots)
+					use(aeVarUse, uIx, slot_use::read);
+		}
+
+		/// <summary>set up the lanes after the columns are set</summary>
+		void prepare(const ts_context& cC)
+		{
+			for (unsigned uIx = 0; uIx < (unsigned)aeVarUse.size(); uIx++)
+			{
+				if (aeVarUse[uIx] == slot_use::none) continue;
+				if (apfColumns[uIx]) auVarColumns.push_back(uIx); else auVarBroadcast.push_back(uIx);
+			}
+			for (unsigned uIx = 0; uIx < (unsigned)aeBoolUse.size(); uIx++)
+			{
+				if (aeBoolUse[uIx] == slot_use::none) continue;
+				if (apbColumns[uIx]) auBoolColumns.push_back(uIx); else auBoolBroadcast.push_back(uIx);
+			}
+
+			// broadcast values get lanes of their own
+			afScratch = std::make_unique<te_type[]>(auVarBroadcast.size() * uBatchLanes);
+			abScratch = std::make_unique<bool[]>(auBoolBroadcast.size() * uBatchLanes);
+			for (size_t uS = 0; uS < auVarBroadcast.size(); uS++)
+			{
+				apfLanes[auVarBroadcast[uS]] = &afScratch[uS * uBatchLanes];
+				std::fill_n(apfLanes[auVarBroadcast[uS]], uBatchLanes, *cC.apfVars[auVarBroadcast[uS]]);
+			}
+			for (size_t uS = 0; uS < auBoolBroadcast.size(); uS++)
+			{
+				apbLanes[auBoolBroadcast[uS]] = &abScratch[uS * uBatchLanes];
+				std::fill_n(apbLanes[auBoolBroadcast[uS]], uBatchLanes, *cC.apbBools[auBoolBroadcast[uS]]);
+			}
+		}
+
+		/// <summary>point the lanes to the chunk starting at this row</summary>
+		void seek(const ts_context& cC, size_t uRow)
+		{
+			for (unsigned uIx : auVarColumns) apfLanes[uIx] = apfColumns[uIx] + uRow;
+			for (unsigned uIx : auBoolColumns) apbLanes[uIx] = apbColumns[uIx] + uRow;
+
+			// assigned broadcast values are row local, reset them
+			for (unsigned uIx : auVarBroadcast)
+				if (aeVarUse[uIx] == slot_use::assigned) std::fill_n(apfLanes[uIx], uBatchLanes, *cC.apfVars[uIx]);
+			for (unsigned uIx : auBoolBroadcast)
+				if (aeBoolUse[uIx] == slot_use::assigned) std::fill_n(apbLanes[uIx], uBatchLanes, *cC.apbBools[uIx]);
+		}
+
+		/// <summary>keep the assigned broadcast values of this lane (the last row)</summary>
+		void keep(unsigned uLane)
+		{
+			afKept.clear();
+			abKept.clear();
+			for (unsigned uIx : auVarBroadcast) afKept.push_back(apfLanes[uIx][uLane]);
+			for (unsigned uIx : auBoolBroadcast) abKept.push_back(apbLanes[uIx][uLane]);
+		}
+
+		/// <summary>write the kept assigned broadcast values back to the variables</summary>
+		void write_back(const ts_context& cC)
+		{
+			for (size_t uS = 0; uS < afKept.size(); uS++)
+				if (aeVarUse[auVarBroadcast[uS]] == slot_use::assigned) *cC.apfVars[auVarBroadcast[uS]] = afKept[uS];
+			for (size_t uS = 0; uS < abKept.size(); uS++)
+				if (aeBoolUse[auBoolBroadcast[uS]] == slot_use::assigned) *cC.apbBools[auBoolBroadcast[uS]] = abKept[uS];
+		}
+
+		/// <summary>variable columns by slot (nullptr for broadcast)</summary>
+		std::vector<te_type*> apfColumns;
+		/// <summary>boolean columns by slot (nullptr for broadcast)</summary>
+		std::vector<bool*> apbColumns;
+		/// <summary>variable lanes by slot</summary>
+		std::vector<te_type*> apfLanes;
+		/// <summary>boolean lanes by slot</summary>
+		std::vector<bool*> apbLanes;
+
+	private:
+		/// <summary>slot usage by the script</summary>
+		enum struct slot_use : unsigned
+		{
+			none,
+			read,
+			assigned
+		};
+		/// <summary>update the usage of a slot</summary>
+		static void use(std::vector<slot_use>& aeUse, unsigned uIx, slot_use eUse)
+		{
+			if ((uIx < aeUse.size()) && ((unsigned)aeUse[uIx] < (unsigned)eUse)) aeUse[uIx] = eUse;
+		}
+
+		/// <summary>variable slot usage</summary>
+		std::vector<slot_use> aeVarUse;
+		/// <summary>boolean slot usage</summary>
+		std::vector<slot_use> aeBoolUse;
+		/// <summary>used slots with column</summary>
+		std::vector<unsigned> auVarColumns, auBoolColumns;
+		/// <summary>used slots without column</summary>
+		std::vector<unsigned> auVarBroadcast, auBoolBroadcast;
+		/// <summary>lanes of the broadcast values</summary>
+		std::unique_ptr<te_type[]> afScratch;
+		/// <summary>lanes of the broadcast booleans</summary>
+		std::unique_ptr<bool[]> abScratch;
+		/// <summary>kept broadcast values, index equals auVarBroadcast index</summary>
+		std::vector<te_type> afKept;
+		/// <summary>kept broadcast booleans, index equals auBoolBroadcast index</summary>
+		std::vector<bool> abKept;
+	};
+
+	/// <summary>state of a parallel evaluation, shared by the workers</summary>
+	struct task_state
+	{
+		/// <param name="uTasks">number of tasks of the program</param>
+		explicit task_state(size_t uTasks) : auWaiting(std::make_unique<std::atomic<unsigned>[]>(uTasks)) {}
+
+		/// <summary>predecessors pending per task</summary>
+		std::unique_ptr<std::atomic<unsigned>[]> auWaiting;
+		/// <summary>next task to take by a worker</summary>
+		std::atomic<size_t> uNext{ 0 };
+	};
+
+	/// <summary>private state of a batch worker</summary>
+	struct lanes_worker
+	{
+		/// <summary>the register lanes</summary>
+		std::vector<te_type> afRegisters;
+		/// <summary>lanes waiting for an instruction</summary>
+		std::vector<uint64_t> auPending;
+		/// <summary>return points of the invoked function bodies</summary>
+		std::vector<unsigned> auReturns;
+		/// <summary>TinyExpr++ evaluated expressions (own copies for all but the first worker)</summary>
+		std::vector<std::shared_ptr<ts_program::tinyexpr_fallback>> apsFallbacks;
+		/// <summary>slot binding of the current batch</summary>
+		std::unique_ptr<lane_binding> psBinding;
+		/// <summary>true if this worker executed the last chunk</summary>
+		bool bLast = false;
+	};
+
+	/// <summary>
+	/// chunks owned by a worker, begin and end packed in one atomic value,
+	/// the owner takes chunks from the front, other workers steal the back half
+	/// </summary>
+	struct alignas(64) chunk_range
+	{
+		/// <summary>set the range (owner only, when empty)</summary>
+		void set(uint32_t uBegin, uint32_t uEnd) { uRange.store(((uint64_t)uEnd << 32) | uBegin, std::memory_order_release); }
+		/// <summary>take the next chunk, false if empty</summary>
+		bool pop(uint32_t& uChunk)
+		{
+			uint64_t u = uRange.load(std::memory_order_acquire);
+			for (;;)
+			{
+				uint32_t uBegin = (uint32_t)u, uEnd = (uint32_t)(u >> 32);
+				if (uBegin >= uEnd) return false;
+				if (uRange.compare_exchange_weak(u, ((uint64_t)uEnd << 32) | (uBegin + 1), std::memory_order_acq_rel))
+				{
+					uChunk = uBegin;
+					return true;
+				}
+			}
+		}
+		/// <summary>steal the back half (at least one chunk), false if empty</summary>
+		bool steal(uint32_t& uBegin, uint32_t& uEnd)
+		{
+			uint64_t u = uRange.load(std::memory_order_acquire);
+			for (;;)
+			{
+				uint32_t uB = (uint32_t)u, uE = (uint32_t)(u >> 32);
+				if (uB >= uE) return false;
+				uint32_t uMid = uB + (uE - uB) / 2;
+				if (uRange.compare_exchange_weak(u, ((uint64_t)uMid << 32) | uB, std::memory_order_acq_rel))
+				{
+					uBegin = uMid, uEnd = uE;
+					return true;
+				}
+			}
+		}
+
+		/// <summary>begin (low) and end (high)</summary>
+		std::atomic<uint64_t> uRange{ 0 };
+	};
+
+
+	/// <summary>
+	/// execute compiled instructions
+	/// </summary>
+	/// <param name="psCode">the instructions, ending with op_end</param>
+	/// <param name="afR">the register frame</param>
+	/// <param name="apfVars">variable addresses by slot</param>
+	/// <param name="apbBools">boolean addresses by slot</param>
+	/// <param name="apsFallbacks">TinyExpr++ evaluated expressions</param>
+	/// <param name="asNatives">host function calls</param>
+	/// <param name="puExecute">incremental only : bits of the instructions to execute</param>
+	/// <param name="uBegin">range only : first instruction</param>
+	/// <param name="uEnd">range only : instruction after the range</param>
+	template<bool bIncremental = false, bool bRange = false>
+	static void execute(const ts_instruction* psCode, te_type* afR, te_type* const* apfVars, bool* const* apbBools, const std::shared_ptr<ts_program::tinyexpr_fallback>* apsFallbacks,
+		const ts_program::native_call* asNatives, const uint64_t* puExecute = nullptr, unsigned uBegin = 0, unsigned uEnd = 0)
+	{
+		for (const ts_instruction* ps = psCode + uBegin;; ps++)
+		{
+			if constexpr (bRange)
+			{
+				if (ps == psCode + uEnd) return;
+			}
+			if constexpr (bIncremental)
+			{
+				// skip to the next instruction to execute (op_end always is)
+				size_t uPc = (size_t)(ps - psCode);
+				uint64_t uBits = puExecute[uPc >> 6] >> (uPc & 63);
+				if (!(uBits & 1))
+				{
+					if (uBits)
+						uPc += lowest_bit(uBits);
+					else
+					{
+						uPc = (uPc | 63) + 1;
+						while (!puExecute[uPc >> 6]) uPc += 64;
+						uPc += lowest_bit(puExecute[uPc >> 6]);
+					}
+					ps = psCode + uPc;
+				}
+			}
+			const ts_instruction& s = *ps;
+			switch (s.eOp)
+			{
+			case ts_opcode::op_end: return;
+			case ts_opcode::op_load_var: afR[s.uA] = *apfVars[s.uB]; break;
+			case ts_opcode::op_load_bool: afR[s.uA] = (*apbBools[s.uB]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_store_var: *apfVars[s.uA] = afR[s.uB]; break;
+			case ts_opcode::op_store_bool: *apbBools[s.uA] = (afR[s.uB] != (te_type)0); break;
+			case ts_opcode::op_mov: afR[s.uA] = afR[s.uB]; break;
+			case ts_opcode::op_neg: afR[s.uA] = -afR[s.uB]; break;
+			case ts_opcode::op_add: afR[s.uA] = afR[s.uB] + afR[s.uC]; break;
+			case ts_opcode::op_sub: afR[s.uA] = afR[s.uB] - afR[s.uC]; break;
+			case ts_opcode::op_mul: afR[s.uA] = afR[s.uB] * afR[s.uC]; break;
+			case ts_opcode::op_div: afR[s.uA] = afR[s.uB] / afR[s.uC]; break;
+			case ts_opcode::op_mod: afR[s.uA] = std::fmod(afR[s.uB], afR[s.uC]); break;
+			case ts_opcode::op_pow: afR[s.uA] = std::pow(afR[s.uB], afR[s.uC]); break;
+			case ts_opcode::op_sqrt: afR[s.uA] = std::sqrt(afR[s.uB]); break;
+			case ts_opcode::op_abs: afR[s.uA] = std::fabs(afR[s.uB]); break;
+			case ts_opcode::op_atan2: afR[s.uA] = std::atan2(afR[s.uB], afR[s.uC]); break;
+			case ts_opcode::op_call: afR[s.uA] = ts_builtins()[s.uC].pfFunc(afR[s.uB]); break;
+			case ts_opcode::op_equal: afR[s.uA] = (afR[s.uB] == afR[s.uC]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_unequal: afR[s.uA] = (afR[s.uB] != afR[s.uC]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_greater: afR[s.uA] = (afR[s.uB] > afR[s.uC]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_less: afR[s.uA] = (afR[s.uB] < afR[s.uC]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_greater_equal: afR[s.uA] = (afR[s.uB] >= afR[s.uC]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_less_equal: afR[s.uA] = (afR[s.uB] <= afR[s.uC]) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_and: afR[s.uA] = ((afR[s.uB] != (te_type)0) && (afR[s.uC] != (te_type)0)) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_or: afR[s.uA] = ((afR[s.uB] != (te_type)0) || (afR[s.uC] != (te_type)0)) ? (te_type)1 : (te_type)0; break;
+			case ts_opcode::op_tinyexpr:
+			{
+				ts_program::tinyexpr_fallback& sF = *apsFallbacks[s.uB];
+				for (size_t uIx = 0; uIx < sF.auSlots.size(); uIx++)
+					sF.afShadow[uIx] = *apfVars[sF.auSlots[uIx]];
+				afR[s.uA] = sF.cTEP.evaluate();
+			}
+			break;
+			case ts_opcode::op_jump: ps = psCode + s.uB - 1; break;
+			case ts_opcode::op_jump_false: if (afR[s.uA] == (te_type)0) ps = psCode + s.uB - 1; break;
+			case ts_opcode::op_loop:
+				afR[s.uA] = afR[s.uC];
+				if (!(afR[s.uA] > (te_type)0)) ps = psCode + s.uB - 1;
+				break;
+			case ts_opcode::op_next:
+				afR[s.uA] -= afR[s.uC];
+				if (afR[s.uA] > (te_type)0) ps = psCode + s.uB - 1;
+				break;
+			case ts_opcode::op_invoke: execute(psCode, afR, apfVars, apbBools, apsFallbacks, asNatives, nullptr, s.uB); break;
+			case ts_opcode::op_native:
+			{
+				const ts_program::native_call& sC = asNatives[s.uB];
+				std::array<te_type, ts_native::uMaxArity> afArgs;
+				for (size_t uA = 0; uA < sC.auArgs.size(); uA++) afArgs[uA] = afR[sC.auArgs[uA]];
+				afR[s.uA] = sC.psFunction->pfFunction(afArgs.data(), sC.psFunction->pvContext);
+			}
+			break;
+			default: return;
+			}
+		}
+	}
+
+	/// <summary>index of the lowest set bit (uBits not zero)</summary>
+	static unsigned lowest_bit(uint64_t uBits)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return (unsigned)__builtin_ctzll(uBits);
+#elif defined(_M_X64)
+		unsigned long uIx = 0;
+		_BitScanForward64(&uIx, uBits);
+		return (unsigned)uIx;
+#else
+		unsigned uIx = 0;
+		for (; !(uBits & 1); uBits >>= 1) uIx++;
+		return uIx;
+#endif
+	}
+
+	/// <summary>evaluate script for a number of rows on one or all workers</summary>
+	int64_t run_batch(const std::set<ts_variable>& asColumns, const std::set<ts_boolean>& asBoolColumns, size_t uRows,
+		ts_thread_pool* pcPool, ts_math eMath, ts_simd eSimd)
+	{
+		size_t uChunks = (uRows + uBatchLanes - 1) / uBatchLanes;
+		if ((psProgram->nErr) || (uChunks > 0xFFFFFFFFu)) return TS_FAIL;
+		bEvaluated = false;
+		const ts_program::symbol_table& sSymbols = *psProgram->psSymbols;
+		const ts_program::bytecode& sCode = psProgram->sCode;
+
+		// the columns by slot
+		std::vector<te_type*> apfColumns(sSymbols.apfVars.size(), nullptr);
+		std::vector<bool*> apbColumns(sSymbols.apbBools.size(), nullptr);
+		for (const ts_variable& s : asColumns)
+		{
+			int nIx = sSymbols.find_var(s.m_name);
+			if ((nIx < 0) || (s.m_value == nullptr)) return TS_FAIL;
+			apfColumns[nIx] = s.m_value;
+		}
+		for (const ts_boolean& s : asBoolColumns)
+		{
+			int nIx = sSymbols.find_bool(s.atName);
+			if ((nIx < 0) || (s.pbValue == nullptr)) return TS_FAIL;
+			apbColumns[nIx] = s.pbValue;
+		}
+
+		// set up the workers, the chunks are split evenly at start
+		unsigned uWorkers = (pcPool) ? pcPool->size() : 1;
+		while (apsWorkers.size() < uWorkers) apsWorkers.push_back(std::make_shared<lanes_worker>());
+		std::unique_ptr<chunk_range[]> asRanges = std::make_unique<chunk_range[]>(uWorkers);
+		for (unsigned uW = 0; uW < uWorkers; uW++)
+		{
+			prepare_worker(*apsWorkers[uW], uW, apfColumns, apbColumns);
+			asRanges[uW].set((uint32_t)(uChunks * uW / uWorkers), (uint32_t)(uChunks * (uW + 1) / uWorkers));
+		}
+
+		lanes_kernel pfKernel = select_kernel(eSimd);
+		bool bFast = (eMath == ts_math::fast);
+		std::function<void(unsigned)> fnJob = [&](unsigned uW)
+			{
+				lanes_worker& sW = *apsWorkers[uW];
+				uint32_t uChunk = 0;
+				for (;;)
+				{
+					if (!asRanges[uW].pop(uChunk))
+					{
+						// out of chunks, steal from the others
+						bool bStolen = false;
+						for (unsigned uV = 1; (uV < uWorkers) && (!bStolen); uV++)
+						{
+							uint32_t uBegin = 0, uEnd = 0;
+							if (asRanges[(uW + uV) % uWorkers].steal(uBegin, uEnd))
+							{
+								asRanges[uW].set(uBegin, uEnd);
+								bStolen = true;
+							}
+						}
+						if (!bStolen) return;
+						continue;
+					}
+
+					size_t uRow = (size_t)uChunk * uBatchLanes;
+					sW.psBinding->seek(*this, uRow);
+					pfKernel(sCode.asCode.data(), (unsigned)sCode.asCode.size(), sW.afRegisters.data(), sW.psBinding->apfLanes.data(), sW.psBinding->apbLanes.data(),
+						sW.apsFallbacks.data(), sCode.asNatives.data(), (unsigned)std::min<size_t>(uBatchLanes, uRows - uRow), sW.auPending.data(), sW.auReturns.data(), bFast);
+					if (uChunk + 1 == uChunks)
+					{
+						sW.psBinding->keep((unsigned)((uRows - 1) % uBatchLanes));
+						sW.bLast = true;
+					}
+				}
+			};
+		if ((pcPool) && (uWorkers > 1))
+			pcPool->run(fnJob);
+		else
+			fnJob(0);
+
+		// write back the last row of the assigned broadcast values
+		for (unsigned uW = 0; uW < uWorkers; uW++)
+			if (apsWorkers[uW]->bLast) apsWorkers[uW]->psBinding->write_back(*this);
+		return TS_OK;
+	}
+
+	/// <summary>signature of the JIT compiled code</summary>
+	using jit_function = void(*)(te_type*, te_type* const*, bool* const*, const std::shared_ptr<ts_program::tinyexpr_fallback>*);
+
+	/// <summary>executable memory holding the JIT compiled code (read only once executable)</summary>
+	struct jit_code
+	{
+		/// <param name="auCode">the machine code</param>
+		explicit jit_code(const std::vector<uint8_t>& auCode)
+		{
+#if defined(TS_JIT_X64) && defined(_WIN32)
+			uSize = auCode.size();
+			pMemory = VirtualAlloc(nullptr, uSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+			if (!pMemory) return;
+			std::memcpy(pMemory, auCode.data(), uSize);
+			DWORD uOld = 0;
+			if (!VirtualProtect(pMemory, uSize, PAGE_EXECUTE_READ, &uOld))
+			{
+				VirtualFree(pMemory, 0, MEM_RELEASE);
+				pMemory = nullptr;
+				return;
+			}
+			FlushInstructionCache(GetCurrentProcess(), pMemory, uSize);
+#elif defined(TS_JIT_X64)
+			uSize = auCode.size();
+			pMemory = mmap(nullptr, uSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (pMemory == MAP_FAILED)
+			{
+				pMemory = nullptr;
+				return;
+			}
+			std::memcpy(pMemory, auCode.data(), uSize);
+			if (mprotect(pMemory, uSize, PROT_READ | PROT_EXEC) != 0)
+			{
+				munmap(pMemory, uSize);
+				pMemory = nullptr;
+			}
+#else
+			(void)auCode;
+#endif
+		}
+		~jit_code()
+		{
+#if defined(TS_JIT_X64) && defined(_WIN32)
+			if (pMemory) VirtualFree(pMemory, 0, MEM_RELEASE);
+#elif defined(TS_JIT_X64)
+			if (pMemory) munmap(pMemory, uSize);
+#endif
+		}
+		jit_code(const jit_code&) = delete;
+		jit_code& operator=(const jit_code&) = delete;
+
+		/// <summary>the compiled function, nullptr if no executable memory</summary>
+		jit_function function() const { return reinterpret_cast<jit_function>(pMemory); }
+
+	private:
+		/// <summary>executable memory</summary>
+		void* pMemory = nullptr;
+		/// <summary>size of the memory</summary>
+		size_t uSize = 0;
+	};
+
+	/// <summary>
+	/// x86-64 encoder for the few instructions the JIT emits,
+	/// memory operands are [base + disp32]
+	/// </summary>
+	struct jit_assembler
+	{
+		/// <summary>general purpose registers</summary>
+		enum gpr : unsigned { rax = 0, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15 };
+
+		/// <summary>append bytes</summary>
+		void emit(std::initializer_list<uint8_t> au) { auCode.insert(auCode.end(), au); }
+		/// <summary>append a 32 bit value</summary>
+		void emit32(uint32_t u) { for (unsigned uB = 0; uB < 4; uB++) auCode.push_back((uint8_t)(u >> (uB * 8))); }
+		/// <summary>append a 64 bit value</summary>
+		void emit64(uint64_t u) { for (unsigned uB = 0; uB < 8; uB++) auCode.push_back((uint8_t)(u >> (uB * 8))); }
+		/// <summary>REX prefix if needed</summary>
+		void rex(bool bW, unsigned uReg, unsigned uBase)
+		{
+			uint8_t u = (uint8_t)(0x40 | (bW ? 8 : 0) | ((uReg & 8) ? 4 : 0) | ((uBase & 8) ? 1 : 0));
+			if (u != 0x40) auCode.push_back(u);
+		}
+		/// <summary>ModRM (and SIB) of [base + disp32]</summary>
+		void mem(unsigned uReg, unsigned uBase, int32_t nDisp)
+		{
+			auCode.push_back((uint8_t)(0x80 | ((uReg & 7) << 3) | (uBase & 7)));
+			if ((uBase & 7) == rsp) auCode.push_back(0x24);
+			emit32((uint32_t)nDisp);
+		}
+		/// <summary>scalar SSE operation xmm, [base + disp32] (prefix 0 for none)</summary>
+		void sse(uint8_t uPrefix, uint8_t uOp, unsigned uXmm, unsigned uBase, int32_t nDisp)
+		{
+			if (uPrefix) auCode.push_back(uPrefix);
+			rex(false, uXmm, uBase);
+			emit({ 0x0F, uOp });
+			mem(uXmm, uBase, nDisp);
+		}
+		/// <summary>mov r64, [base + disp32]</summary>
+		void load_ptr(unsigned uReg, unsigned uBase, int32_t nDisp)
+		{
+			rex(true, uReg, uBase);
+			auCode.push_back(0x8B);
+			mem(uReg, uBase, nDisp);
+		}
+		/// <summary>mov rax, imm64 ; call rax</summary>
+		void call(const void* pFunction)
+		{
+			emit({ 0x48, 0xB8 });
+			emit64((uint64_t)(uintptr_t)pFunction);
+			emit({ 0xFF, 0xD0 });
+		}
+
+		/// <summary>the machine code</summary>
+		std::vector<uint8_t> auCode;
+	};
+
+	/// <summary>fmod() called by JIT compiled code</summary>
+	static te_type jit_mod(te_type fB, te_type fC) { return std::fmod(fB, fC); }
+	/// <summary>pow() called by JIT compiled code</summary>
+	static te_type jit_pow(te_type fB, te_type fC) { return std::pow(fB, fC); }
+	/// <summary>atan2() called by JIT compiled code</summary>
+	static te_type jit_atan2(te_type fB, te_type fC) { return std::atan2(fB, fC); }
+	/// <summary>TinyExpr++ expression called by JIT compiled code</summary>
+	static te_type jit_tinyexpr(const std::shared_ptr<ts_program::tinyexpr_fallback>* apsFallbacks, unsigned uIx, te_type* const* apfVars)
+	{
+		ts_program::tinyexpr_fallback& sF = *apsFallbacks[uIx];
+		for (size_t uS = 0; uS < sF.auSlots.size(); uS++)
+			sF.afShadow[uS] = *apfVars[sF.auSlots[uS]];
+		return sF.cTEP.evaluate();
+	}
+
+	/// <summary>
+	/// compile the program to x86-64 machine code, one instruction sequence per bytecode instruction
+	/// (registers stay in the register frame, the results are bit identical to the interpreter)
+	/// rbx : register frame, rbp : variable addresses, r13 : boolean addresses, r14 : TinyExpr++ expressions
+	/// </summary>
+	/// <returns>the code, nullptr if not available</returns>
+	static std::shared_ptr<const jit_code> jit_compile(const ts_program& cProgram)
+	{
+#ifdef TS_JIT_X64
+		const std::vector<ts_instruction>& asCode = cProgram.sCode.asCode;
+		constexpr bool bDouble = (sizeof(te_type) == sizeof(double));
+		constexpr uint8_t uSS = bDouble ? 0xF2 : 0xF3;
+		constexpr uint8_t uUCOMI = bDouble ? 0x66 : 0x00;
+		auto reg = [](unsigned uReg) { return (int32_t)(uReg * sizeof(te_type)); };
+
+		jit_assembler cA;
+		// prologue, 4 pushes and 40 bytes keep the stack aligned and leave the shadow space for calls
+		cA.emit({ 0x53, 0x55, 0x41, 0x55, 0x41, 0x56, 0x48, 0x83, 0xEC, 0x28 });
+#ifdef _WIN32
+		cA.emit({ 0x48, 0x89, 0xCB, 0x48, 0x89, 0xD5, 0x4D, 0x89, 0xC5, 0x4D, 0x89, 0xCE });
+#else
+		cA.emit({ 0x48, 0x89, 0xFB, 0x48, 0x89, 0xF5, 0x49, 0x89, 0xD5, 0x49, 0x89, 0xCE });
+#endif
+
+		// code offset of each instruction, the last one is the epilogue
+		std::vector<size_t> auLabels(asCode.size() + 1, 0);
+		std::vector<std::pair<size_t, unsigned>> asFixups;
+		auto jump = [&](std::initializer_list<uint8_t> auOp, unsigned uTarget)
+			{
+				cA.emit(auOp);
+				asFixups.push_back({ cA.auCode.size(), uTarget });
+				cA.emit32(0);
+			};
+		auto load = [&](unsigned uXmm, unsigned uReg) { cA.sse(uSS, 0x10, uXmm, jit_assembler::rbx, reg(uReg)); };
+		auto store = [&](unsigned uReg) { cA.sse(uSS, 0x11, 0, jit_assembler::rbx, reg(uReg)); };
+		// xmm0 = al ? 1 : 0 (movzx eax, al ; cvtsi2s eax)
+		auto store_flag = [&](unsigned uReg) { cA.emit({ 0x0F, 0xB6, 0xC0, uSS, 0x0F, 0x2A, 0xC0 }); store(uReg); };
+		// al = xmm0 != 0 (NaN is not zero)
+		auto not_zero = [&]()
+			{
+				cA.emit({ 0x0F, 0x57, 0xC9 });
+				if (uUCOMI) cA.emit({ uUCOMI });
+				cA.emit({ 0x0F, 0x2E, 0xC1, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8 });
+			};
+		// ucomis xmm0, [rbx + reg(uReg)]
+		auto compare = [&](unsigned uReg) { cA.sse(uUCOMI, 0x2E, 0, jit_assembler::rbx, reg(uReg)); };
+
+		// the function bodies after the program end are called, sub rsp, 40 keeps the stack aligned as by the prologue
+		const size_t uMain = ts_program::program_end(asCode);
+		for (size_t uPc = 0; uPc < asCode.size(); uPc++)
+		{
+			auLabels[uPc] = cA.auCode.size();
+			const ts_instruction& s = asCode[uPc];
+			if ((uPc > uMain) && (asCode[uPc - 1].eOp == ts_opcode::op_end)) cA.emit({ 0x48, 0x83, 0xEC, 0x28 });
+			switch (s.eOp)
+			{
+			case ts_opcode::op_end:
+				if (uPc <= uMain)
+					jump({ 0xE9 }, (unsigned)asCode.size());
+				else
+					cA.emit({ 0x48, 0x83, 0xC4, 0x28, 0xC3 });
+				break;
+			case ts_opcode::op_load_var:
+				cA.load_ptr(jit_assembler::rax, jit_assembler::rbp, (int32_t)(s.uB * sizeof(te_type*)));
+				cA.sse(uSS, 0x10, 0, jit_assembler::rax, 0);
+				store(s.uA);
+				break;
+			case ts_opcode::op_load_bool:
+				cA.load_ptr(jit_assembler::rax, jit_assembler::r13, (int32_t)(s.uB * sizeof(bool*)));
+				cA.emit({ 0x0F, 0xB6, 0x80 });
+				cA.emit32(0);
+				cA.emit({ uSS, 0x0F, 0x2A, 0xC0 });
+				store(s.uA);
+				break;
+			case ts_opcode::op_store_var:
+				cA.load_ptr(jit_assembler::rax, jit_assembler::rbp, (int32_t)(s.uA * sizeof(te_type*)));
+				load(0, s.uB);
+				cA.sse(uSS, 0x11, 0, jit_assembler::rax, 0);
+				break;
+			case ts_opcode::op_store_bool:
+				load(0, s.uB);
+				not_zero();
+				cA.load_ptr(jit_assembler::rcx, jit_assembler::r13, (int32_t)(s.uA * sizeof(bool*)));
+				cA.emit({ 0x88, 0x81 });
+				cA.emit32(0);
+				break;
+			case ts_opcode::op_mov: load(0, s.uB); store(s.uA); break;
+			case ts_opcode::op_neg:
+			case ts_opcode::op_abs:
+				// flip or clear the sign bit
+				cA.rex(bDouble, jit_assembler::rax, jit_assembler::rbx); cA.emit({ 0x8B }); cA.mem(jit_assembler::rax, jit_assembler::rbx, reg(s.uB));
+				if (bDouble) cA.emit({ 0x48, 0x0F, 0xBA, (uint8_t)((s.eOp == ts_opcode::op_neg) ? 0xF8 : 0xF0), 0x3F });
+				else if (s.eOp == ts_opcode::op_neg) { cA.emit({ 0x35 }); cA.emit32(0x80000000u); }
+				else { cA.emit({ 0x25 }); cA.emit32(0x7FFFFFFFu); }
+				cA.rex(bDouble, jit_assembler::rax, jit_assembler::rbx); cA.emit({ 0x89 }); cA.mem(jit_assembler::rax, jit_assembler::rbx, reg(s.uA));
+				break;
+			case ts_opcode::op_add: load(0, s.uB); cA.sse(uSS, 0x58, 0, jit_assembler::rbx, reg(s.uC)); store(s.uA); break;
+			case ts_opcode::op_sub: load(0, s.uB); cA.sse(uSS, 0x5C, 0, jit_assembler::rbx, reg(s.uC)); store(s.uA); break;
+			case ts_opcode::op_mul: load(0, s.uB); cA.sse(uSS, 0x59, 0, jit_assembler::rbx, reg(s.uC)); store(s.uA); break;
+			case ts_opcode::op_div: load(0, s.uB); cA.sse(uSS, 0x5E, 0, jit_assembler::rbx, reg(s.uC)); store(s.uA); break;
+			case ts_opcode::op_sqrt: cA.sse(uSS, 0x51, 0, jit_assembler::rbx, reg(s.uB)); store(s.uA); break;
+			case ts_opcode::op_mod:
+			case ts_opcode::op_pow:
+			case ts_opcode::op_atan2:
+				load(0, s.uB);
+				load(1, s.uC);
+				cA.call((s.eOp == ts_opcode::op_mod) ? (const void*)&jit_mod : (s.eOp == ts_opcode::op_pow) ? (const void*)&jit_pow : (const void*)&jit_atan2);
+				store(s.uA);
+				break;
+			case ts_opcode::op_call:
+				load(0, s.uB);
+				cA.call((const void*)ts_builtins()[s.uC].pfFunc);
+				store(s.uA);
+				break;
+			case ts_opcode::op_equal:
+				// equal and ordered
+				load(0, s.uB); compare(s.uC);
+				cA.emit({ 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8 });
+				store_flag(s.uA);
+				break;
+			case ts_opcode::op_unequal:
+				// unequal or unordered
+				load(0, s.uB); compare(s.uC);
+				cA.emit({ 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8 });
+				store_flag(s.uA);
+				break;
+			case ts_opcode::op_greater: load(0, s.uB); compare(s.uC); cA.emit({ 0x0F, 0x97, 0xC0 }); store_flag(s.uA); break;
+			case ts_opcode::op_greater_equal: load(0, s.uB); compare(s.uC); cA.emit({ 0x0F, 0x93, 0xC0 }); store_flag(s.uA); break;
+			case ts_opcode::op_less: load(0, s.uC); compare(s.uB); cA.emit({ 0x0F, 0x97, 0xC0 }); store_flag(s.uA); break;
+			case ts_opcode::op_less_equal: load(0, s.uC); compare(s.uB); cA.emit({ 0x0F, 0x93, 0xC0 }); store_flag(s.uA); break;
+			case ts_opcode::op_and:
+			case ts_opcode::op_or:
+				// dl = b != 0, al = c != 0
+				load(0, s.uB); not_zero();
+				cA.emit({ 0x88, 0xC2 });
+				load(0, s.uC); not_zero();
+				cA.emit({ (uint8_t)((s.eOp == ts_opcode::op_and) ? 0x20 : 0x08), 0xD0 });
+				store_flag(s.uA);
+				break;
+			case ts_opcode::op_tinyexpr:
+#ifdef _WIN32
+				cA.emit({ 0x4C, 0x89, 0xF1, 0xBA });
+				cA.emit32(s.uB);
+				cA.emit({ 0x49, 0x89, 0xE8 });
+#else
+				cA.emit({ 0x4C, 0x89, 0xF7, 0xBE });
+				cA.emit32(s.uB);
+				cA.emit({ 0x48, 0x89, 0xEA });
+#endif
+				cA.call((const void*)&jit_tinyexpr);
+				store(s.uA);
+				break;
+			case ts_opcode::op_jump: jump({ 0xE9 }, s.uB); break;
+			case ts_opcode::op_jump_false:
+				// jump if equal to zero and ordered
+				load(0, s.uA);
+				cA.emit({ 0x0F, 0x57, 0xC9 });
+				if (uUCOMI) cA.emit({ uUCOMI });
+				cA.emit({ 0x0F, 0x2E, 0xC1, 0x7A, 0x06 });
+				jump({ 0x0F, 0x84 }, s.uB);
+				break;
+			case ts_opcode::op_loop:
+			case ts_opcode::op_next:
+				// count down, jump if not above zero (unordered included) to the end or if above back to the start
+				if (s.eOp == ts_opcode::op_loop) load(0, s.uC);
+				else { load(0, s.uA); cA.sse(uSS, 0x5C, 0, jit_assembler::rbx, reg(s.uC)); }
+				store(s.uA);
+				cA.emit({ 0x0F, 0x57, 0xC9 });
+				if (uUCOMI) cA.emit({ uUCOMI });
+				cA.emit({ 0x0F, 0x2E, 0xC1 });
+				jump({ 0x0F, (uint8_t)((s.eOp == ts_opcode::op_loop) ? 0x86 : 0x87) }, s.uB);
+				break;
+			case ts_opcode::op_invoke: jump({ 0xE8 }, s.uB); break;
+			case ts_opcode::op_native:
+			{
+				// the arguments copied above the shadow space (sub rsp, 96 keeps the stack aligned), the host function called directly
+				const ts_program::native_call& sC = cProgram.sCode.asNatives[s.uB];
+				cA.emit({ 0x48, 0x83, 0xEC, 0x60 });
+				for (size_t uA = 0; uA < sC.auArgs.size(); uA++)
+				{
+					load(0, sC.auArgs[uA]);
+					cA.sse(uSS, 0x11, 0, jit_assembler::rsp, (int32_t)(32 + uA * sizeof(te_type)));
+				}
+#ifdef _WIN32
+				cA.emit({ 0x48, 0x8D, 0x4C, 0x24, 0x20, 0x48, 0xBA });
+#else
+				cA.emit({ 0x48, 0x8D, 0x7C, 0x24, 0x20, 0x48, 0xBE });
+#endif
+				cA.emit64((uint64_t)(uintptr_t)sC.psFunction->pvContext);
+				cA.call((const void*)sC.psFunction->pfFunction);
+				cA.emit({ 0x48, 0x83, 0xC4, 0x60 });
+				store(s.uA);
+			}
+			break;
+			default: return nullptr;
+			}
+		}
+
+		// epilogue
+		auLabels[asCode.size()] = cA.auCode.size();
+		cA.emit({ 0x48, 0x83, 0xC4, 0x28, 0x41, 0x5E, 0x41, 0x5D, 0x5D, 0x5B, 0xC3 });
+
+		// resolve the jumps
+		for (const std::pair<size_t, unsigned>& sF : asFixups)
+		{
+			if (sF.second >= auLabels.size()) return nullptr;
+			int32_t nRel = (int32_t)((int64_t)auLabels[sF.second] - (int64_t)(sF.first + 4));
+			std::memcpy(&cA.auCode[sF.first], &nRel, sizeof(int32_t));
+		}
+
+		std::shared_ptr<const jit_code> psCode = std::make_shared<const jit_code>(cA.auCode);
+		return (psCode->function()) ? psCode : nullptr;
+#else
+		(void)cProgram;
+		return nullptr;
+#endif
+	}
+
+	/// <summary>set up a worker for the next batch</summary>
+	void prepare_worker(lanes_worker& sW, unsigned uW, const std::vector<te_type*>& apfColumns, const std::vector<bool*>& apbColumns)
+	{
+		const ts_program::bytecode& sCode = psProgram->sCode;
+
+		// register lanes, constants preset for all lanes
+		sW.afRegisters.resize(sCode.afFrame.size() * uBatchLanes);
+		for (size_t uR = 0; uR < sCode.afFrame.size(); uR++)
+			std::fill_n(sW.afRegisters.begin() + uR * uBatchLanes, uBatchLanes, sCode.afFrame[uR]);
+		sW.auPending.assign(sCode.asCode.size(), 0);
+		sW.auReturns.resize(std::count_if(sCode.asCode.begin(), sCode.asCode.end(), [](const ts_instruction& s) { return s.eOp == ts_opcode::op_end; }));
+		sW.bLast = false;
+
+		// TinyExpr++ parsers are bound to their shadow values, other workers need copies
+		if (uW == 0)
+			sW.apsFallbacks = apsFallbacks;
+		else if (sW.apsFallbacks.size() != sCode.apsFallbacks.size())
+			sW.apsFallbacks = clone_fallbacks();
+
+		// bind the columns
+		sW.psBinding = std::make_unique<lane_binding>(*psProgram->psSymbols, sCode);
+		sW.psBinding->apfColumns = apfColumns;
+		sW.psBinding->apbColumns = apbColumns;
+		sW.psBinding->prepare(*this);
+	}
+
+	/// <summary>own copies of the TinyExpr++ evaluated expressions of the program</summary>
+	std::vector<std::shared_ptr<ts_program::tinyexpr_fallback>> clone_fallbacks() const
+	{
+		std::vector<std::shared_ptr<ts_program::tinyexpr_fallback>> aps;
+		for (const std::shared_ptr<ts_program::tinyexpr_fallback>& ps : psProgram->sCode.apsFallbacks)
+		{
+			std::shared_ptr<ts_program::tinyexpr_fallback> psF = std::make_shared<ts_program::tinyexpr_fallback>();
+			psF->atExpression = ps->atExpression;
+			psF->auSlots = ps->auSlots;
+			psF->compile(*psProgram->psSymbols);
+			aps.push_back(psF);
+		}
+		return aps;
+	}
+
+	/// <summary>
+	/// execute compiled instructions for a chunk of rows, one lane per row
+	/// (if blocks mask their lanes, a jump is taken once no lane is left, a loop repeats while any lane iterates)
+	/// </summary>
+	/// <typeparam name="V">lane operations of the instruction set</typeparam>
+	/// <param name="psCode">the instructions, ending with op_end</param>
+	/// <param name="uCodeSize">number of instructions</param>
+	/// <param name="afR">the register lanes, uBatchLanes values per register</param>
+	/// <param name="apfLanes">variable lanes by slot</param>
+	/// <param name="apbLanes">boolean lanes by slot</param>
+	/// <param name="apsFallbacks">TinyExpr++ evaluated expressions</param>
+	/// <param name="asNatives">host function calls</param>
+	/// <param name="uN">number of rows in this chunk (1..uBatchLanes)</param>
+	/// <param name="auPending">lanes waiting for an instruction, index is the instruction (all zero)</param>
+	/// <param name="auReturns">return points of the invoked function bodies, one per op_end</param>
+	/// <param name="bFast">use the polynomial approximations of ts_lanes_fast_math</param>
+	template<class V>
+	static void execute_lanes(const ts_instruction* psCode, unsigned uCodeSize, te_type* afR, te_type* const* apfLanes, bool* const* apbLanes,
+		const std::shared_ptr<ts_program::tinyexpr_fallback>* apsFallbacks, const ts_program::native_call* asNatives, unsigned uN, uint64_t* auPending, unsigned* auReturns, bool bFast)
+	{
+		constexpr unsigned W = V::uWidth;
+		constexpr unsigned uBlock = (1u << W) - 1u;
+		const uint64_t uAll = (uN >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << uN) - 1);
+		uint64_t uMask = uAll;
+		unsigned uReturns = 0;
+		auto r = [afR](unsigned uReg) { return afR + (size_t)uReg * uBatchLanes; };
+
+		for (unsigned uPc = 0; uPc < uCodeSize; uPc++)
+		{
+			// lanes rejoining here
+			uMask |= auPending[uPc];
+			auPending[uPc] = 0;
+
+			const ts_instruction& s = psCode[uPc];
+			bool bSeek = false;
+			switch (s.eOp)
+			{
+			case ts_opcode::op_end:
+				// a function body returns, the lanes wait after the invocation
+				if (uReturns) uPc = auReturns[--uReturns];
+				else bSeek = true;
+				uMask = 0;
+				break;
+			case ts_opcode::op_load_var: std::memcpy(r(s.uA), apfLanes[s.uB], uN * sizeof(te_type)); break;
+			case ts_opcode::op_load_bool: { te_type* pfA = r(s.uA); const bool* pb = apbLanes[s.uB]; for (unsigned u = 0; u < uN; u++) pfA[u] = pb[u] ? (te_type)1 : (te_type)0; } break;
+			case ts_opcode::op_store_var:
+			{
+				// blend the active lanes, lanes past the chunk end are never touched
+				te_type* pf = apfLanes[s.uA]; const te_type* pfB = r(s.uB);
+				if (uMask == uAll) { std::memcpy(pf, pfB, uN * sizeof(te_type)); break; }
+				for (unsigned u = 0; u < uN; u += W)
+				{
+					unsigned uBits = (unsigned)(uMask >> u) & uBlock;
+					if (!uBits) continue;
+					if (u + W <= uN) V::blend(pf + u, pfB + u, uBits);
+					else for (unsigned uL = u; uL < uN; uL++) if ((uMask >> uL) & 1) pf[uL] = pfB[uL];
+				}
+			}
+			break;
+			case ts_opcode::op_store_bool:
+			{
+				bool* pb = apbLanes[s.uA]; const te_type* pfB = r(s.uB);
+				if (uMask == uAll) { for (unsigned u = 0; u < uN; u++) pb[u] = (pfB[u] != (te_type)0); }
+				else { for (unsigned u = 0; u < uN; u++) if ((uMask >> u) & 1) pb[u] = (pfB[u] != (te_type)0); }
+			}
+			break;
+			case ts_opcode::op_mov: std::memcpy(r(s.uA), r(s.uB), uBatchLanes * sizeof(te_type)); break;
+			case ts_opcode::op_neg: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB); for (unsigned u = 0; u < uBatchLanes; u += W) V::neg(pfA + u, pfB + u); } break;
+			case ts_opcode::op_add: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::add(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_sub: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::sub(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_mul: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::mul(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_div: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::div(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_mod: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uN; u++) pfA[u] = std::fmod(pfB[u], pfC[u]); } break;
+			case ts_opcode::op_pow: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uN; u++) pfA[u] = std::pow(pfB[u], pfC[u]); } break;
+			case ts_opcode::op_sqrt: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB); for (unsigned u = 0; u < uBatchLanes; u += W) V::sqrt(pfA + u, pfB + u); } break;
+			case ts_opcode::op_abs: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB); for (unsigned u = 0; u < uBatchLanes; u += W) V::abs(pfA + u, pfB + u); } break;
+			case ts_opcode::op_atan2: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uN; u++) pfA[u] = std::atan2(pfB[u], pfC[u]); } break;
+			case ts_opcode::op_call:
+			{
+				te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB);
+				const ts_builtin& sF = ts_builtins()[s.uC];
+				if (bFast && (W > 1) && (std::strcmp(sF.atName, "acos") == 0))
+					for (unsigned u = 0; u < uBatchLanes; u += W) ts_lanes_fast_math<V>::acos(pfA + u, pfB + u);
+				else if (bFast && (W > 1) && (std::strcmp(sF.atName, "asin") == 0))
+					for (unsigned u = 0; u < uBatchLanes; u += W) ts_lanes_fast_math<V>::asin(pfA + u, pfB + u);
+				else if (bFast && (W > 1) && (std::strcmp(sF.atName, "atan") == 0))
+					for (unsigned u = 0; u < uBatchLanes; u += W) ts_lanes_fast_math<V>::atan(pfA + u, pfB + u);
+				else
+					for (unsigned u = 0; u < uN; u++) if ((uMask >> u) & 1) pfA[u] = sF.pfFunc(pfB[u]);
+			}
+			break;
+			case ts_opcode::op_equal: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::equal(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_unequal: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::unequal(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_greater: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::greater(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_less: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::less(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_greater_equal: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::greater_equal(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_less_equal: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::less_equal(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_and: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::logic_and(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_or: { te_type* pfA = r(s.uA); const te_type* pfB = r(s.uB), * pfC = r(s.uC); for (unsigned u = 0; u < uBatchLanes; u += W) V::logic_or(pfA + u, pfB + u, pfC + u); } break;
+			case ts_opcode::op_tinyexpr: evaluate_fallback(*apsFallbacks[s.uB], r(s.uA), apfLanes, uN, uMask); break;
+			case ts_opcode::op_native: evaluate_native(asNatives[s.uB], r(s.uA), afR, uN, uMask, uAll); break;
+			case ts_opcode::op_jump:
+				auPending[s.uB] |= uMask;
+				uMask = 0;
+				bSeek = true;
+				break;
+			case ts_opcode::op_jump_false:
+			{
+				const te_type* pfA = r(s.uA);
+				uint64_t uFalse = 0;
+				for (unsigned u = 0; u < uN; u += W) uFalse |= (uint64_t)V::zero_mask(pfA + u) << u;
+				uFalse &= uMask;
+				if (uFalse)
+				{
+					auPending[s.uB] |= uFalse;
+					uMask &= ~uFalse;
+					bSeek = (uMask == 0);
+				}
+			}
+			break;
+			case ts_opcode::op_loop:
+			{
+				// lanes without iterations wait at the loop end
+				te_type* pfA = r(s.uA);
+				std::memcpy(pfA, r(s.uC), uBatchLanes * sizeof(te_type));
+				uint64_t uDone = 0;
+				for (unsigned u = 0; u < uN; u++) if (!(pfA[u] > (te_type)0)) uDone |= (uint64_t)1 << u;
+				uDone &= uMask;
+				if (uDone)
+				{
+					auPending[s.uB] |= uDone;
+					uMask &= ~uDone;
+					bSeek = (uMask == 0);
+				}
+			}
+			break;
+			case ts_opcode::op_next:
+			{
+				// lanes with iterations left go back to the loop start, the others wait after the loop end
+				te_type* pfA = r(s.uA); const te_type* pfC = r(s.uC);
+				uint64_t uMore = 0;
+				for (unsigned u = 0; u < uN; u++)
+				{
+					pfA[u] -= pfC[u];
+					if (pfA[u] > (te_type)0) uMore |= (uint64_t)1 << u;
+				}
+				uMore &= uMask;
+				if (uMore)
+				{
+					auPending[uPc + 1] |= uMask & ~uMore;
+					uMask = uMore;
+					uPc = s.uB - 1;
+				}
+				else
+					bSeek = (uMask == 0);
+			}
+			break;
+			case ts_opcode::op_invoke:
+				// the active lanes execute the body, then continue after this instruction
+				auPending[uPc + 1] |= uMask;
+				auReturns[uReturns++] = uPc;
+				uPc = s.uB - 1;
+				break;
+			default: return;
+			}
+
+			// no lane left, continue at the next instruction lanes are waiting for
+			if (bSeek)
+			{
+				while ((uPc + 1 < uCodeSize) && (auPending[uPc + 1] == 0)) uPc++;
+			}
+		}
+	}
+
+	/// <summary>
+	/// evaluate a TinyExpr++ expression for the active lanes
+	/// (never inlined, it keeps the instruction set and floating point contraction of TinyExpr++ itself)
+	/// </summary>
+	TS_NOINLINE static void evaluate_fallback(ts_program::tinyexpr_fallback& sF, te_type* pfA, te_type* const* apfLanes, unsigned uN, uint64_t uMask)
+	{
+		for (unsigned u = 0; u < uN; u++)
+		{
+			if (!((uMask >> u) & 1)) continue;
+			for (size_t uIx = 0; uIx < sF.auSlots.size(); uIx++)
+				sF.afShadow[uIx] = apfLanes[sF.auSlots[uIx]][u];
+			pfA[u] = sF.cTEP.evaluate();
+		}
+	}
+
+	/// <summary>
+	/// call a host function for the active lanes : the batch variant once for the rows of the chunk
+	/// (pure functions, lanes not active are computed as well, or impure ones with all lanes active), else once per active lane
+	/// </summary>
+	TS_NOINLINE static void evaluate_native(const ts_program::native_call& sC, te_type* pfA, const te_type* afR, unsigned uN, uint64_t uMask, uint64_t uAll)
+	{
+		const ts_native& sF = *sC.psFunction;
+		if ((sF.pfBatch) && ((sF.bPure) || (uMask == uAll)))
+		{
+			std::array<const te_type*, ts_native::uMaxArity> apfArgs;
+			for (size_t uA = 0; uA < sC.auArgs.size(); uA++) apfArgs[uA] = afR + (size_t)sC.auArgs[uA] * uBatchLanes;
+			sF.pfBatch(apfArgs.data(), pfA, uN, sF.pvContext);
+			return;
+		}
+		std::array<te_type, ts_native::uMaxArity> afArgs;
+		for (unsigned u = 0; u < uN; u++)
+		{
+			if (!((uMask >> u) & 1)) continue;
+			for (size_t uA = 0; uA < sC.auArgs.size(); uA++) afArgs[uA] = afR[(size_t)sC.auArgs[uA] * uBatchLanes + u];
+			pfA[u] = sF.pfFunction(afArgs.data(), sF.pvContext);
+		}
+	}
+
+	/// <summary>signature of the batch kernels</summary>
+	using lanes_kernel = void(*)(const ts_instruction*, unsigned, te_type*, te_type* const*, bool* const*,
+		const std::shared_ptr<ts_program::tinyexpr_fallback>*, const ts_program::native_call*, unsigned, uint64_t*, unsigned*, bool);
+
+#ifdef TS_SIMD_X86
+	/// <summary>batch kernel compiled for SSE2</summary>
+	TS_TARGET("sse2") TS_FLATTEN static void execute_lanes_sse(const ts_instruction* psCode, unsigned uCodeSize, te_type* afR, te_type* const* apfLanes, bool* const* apbLanes,
+		const std::shared_ptr<ts_program::tinyexpr_fallback>* apsFallbacks, const ts_program::native_call* asNatives, unsigned uN, uint64_t* auPending, unsigned* auReturns, bool bFast)
+	{
+		execute_lanes<ts_lanes_sse>(psCode, uCodeSize, afR, apfLanes, apbLanes, apsFallbacks, asNatives, uN, auPending, auReturns, bFast);
+	}
+	/// <summary>batch kernel compiled for AVX2</summary>
+	TS_TARGET("avx2") TS_FLATTEN static void execute_lanes_avx2(const ts_instruction* psCode, unsigned uCodeSize, te_type* afR, te_type* const* apfLanes, bool* const* apbLanes,
+		const std::shared_ptr<ts_program::tinyexpr_fallback>* apsFallbacks, const ts_program::native_call* asNatives, unsigned uN, uint64_t* auPending, unsigned* auReturns, bool bFast)
+	{
+		execute_lanes<ts_lanes_avx2>(psCode, uCodeSize, afR, apfLanes, apbLanes, apsFallbacks, asNatives, uN, auPending, auReturns, bFast);
+	}
+	/// <summary>batch kernel compiled for AVX-512F</summary>
+	TS_TARGET("avx512f") TS_FLATTEN static void execute_lanes_avx512(const ts_instruction* psCode, unsigned uCodeSize, te_type* afR, te_type* const* apfLanes, bool* const* apbLanes,
+		const std::shared_ptr<ts_program::tinyexpr_fallback>* apsFallbacks, const ts_program::native_call* asNatives, unsigned uN, uint64_t* auPending, unsigned* auReturns, bool bFast)
+	{
+		execute_lanes<ts_lanes_avx512>(psCode, uCodeSize, afR, apfLanes, apbLanes, apsFallbacks, asNatives, uN, auPending, auReturns, bFast);
+	}
+#endif
+
+	/// <summary>batch kernel for the instruction set, limited to the instruction sets supported by the CPU</summary>
+	static lanes_kernel select_kernel(ts_simd eSimd)
+	{
+		ts_simd eSupported = ts_simd_supported();
+		if ((unsigned)eSimd > (unsigned)eSupported) eSimd = eSupported;
+		switch (eSimd)
+		{
+#ifdef TS_SIMD_X86
+		case ts_simd::avx512: return &execute_lanes_avx512;
+		case ts_simd::avx2: return &execute_lanes_avx2;
+		case ts_simd::sse: return &execute_lanes_sse;
+#endif
+		default: return &execute_lanes<ts_lanes_scalar>;
+		}
+	}
+
+	/// <summary>slot bound relative to a struct instance</summary>
+	struct slot_offset
+	{
+		/// <summary>the slot index</summary>
+		unsigned uSlot;
+		/// <summary>byte offset within the instance</summary>
+		size_t uOffset;
+	};
+
+	/// <summary>the compiled script</summary>
+	std::shared_ptr<const ts_program> psProgram;
+	/// <summary>variable addresses by slot</summary>
+	std::vector<te_type*> apfVars;
+	/// <summary>boolean addresses by slot</summary>
+	std::vector<bool*> apbBools;
+	/// <summary>values of the variables bound to no address</summary>
+	std::unique_ptr<te_type[]> afUnbound;
+	/// <summary>values of the booleans bound to no address</summary>
+	std::unique_ptr<bool[]> abUnbound;
+	/// <summary>variable slots rebound by bind_instance()</summary>
+	std::vector<slot_offset> asVarLayout;
+	/// <summary>boolean slots rebound by bind_instance()</summary>
+	std::vector<slot_offset> asBoolLayout;
+	/// <summary>the register frame used during evaluation</summary>
+	std::vector<te_type> afRegisters;
+	/// <summary>TinyExpr++ evaluated expressions, bound to the shadow values of this context</summary>
+	std::vector<std::shared_ptr<ts_program::tinyexpr_fallback>> apsFallbacks;
+	/// <summary>batch workers (register lanes, TinyExpr++ copies), kept between batches</summary>
+	std::vector<std::shared_ptr<lanes_worker>> apsWorkers;
+	/// <summary>JIT compiled program, nullptr if interpreted</summary>
+	std::shared_ptr<const jit_code> psJit;
+	/// <summary>true if the registers hold the results of an evaluation with the current bindings</summary>
+	bool bEvaluated = false;
+	/// <summary>instructions executed by the current incremental evaluation</summary>
+	std::vector<uint64_t> auExecute;
+	/// <summary>state of the parallel evaluation, nullptr if not yet evaluated on a pool</summary>
+	std::unique_ptr<task_state> psTasks;
+};
+
+/// <summary>
+/// compile simple scripts using TinyExpr++
+/// (a program with one context bound to the given variables)
+/// </summary>
+class ts_parser
+{
+public:
+	/// <param name="atScript">the Script code</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_parser(std::string_view atCode, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, ts_optimize eOptimize = ts_optimize::full)
+		: psProgram(std::make_shared<const ts_program>(atCode, asVars, asBools, eOptimize))
+		, cContext(psProgram)
+	{
+	}
+
+	/// <param name="cSource">the Script code, compiled while read</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_parser(ts_source cSource, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, ts_optimize eOptimize = ts_optimize::full)
+		: psProgram(std::make_shared<const ts_program>(std::move(cSource), asVars, asBools, eOptimize))
+		, cContext(psProgram)
+	{
+	}
+
+	/// <param name="sImage">compiled program image written by ts_program::write()</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	explicit ts_parser(ts_image sImage, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools)
+		: psProgram(std::make_shared<const ts_program>(sImage, asVars, asBools))
+		, cContext(psProgram)
+	{
+	}
+
+	/// <param name="atScript">the Script code</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="asNatives">the host functions the script calls</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_parser(std::string_view atCode, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, const std::set<ts_native>& asNatives,
+		ts_optimize eOptimize = ts_optimize::full)
+		: psProgram(std::make_shared<const ts_program>(atCode, asVars, asBools, asNatives, eOptimize))
+		, cContext(psProgram)
+	{
+	}
+
+	/// <param name="cSource">the Script code, compiled while read</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="asNatives">the host functions the script calls</param>
+	/// <param name="eOptimize">optimization of the compiled program</param>
+	explicit ts_parser(ts_source cSource, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, const std::set<ts_native>& asNatives,
+		ts_optimize eOptimize = ts_optimize::full)
+		: psProgram(std::make_shared<const ts_program>(std::move(cSource), asVars, asBools, asNatives, eOptimize))
+		, cContext(psProgram)
+	{
+	}
+
+	/// <param name="sImage">compiled program image written by ts_program::write()</param>
+	/// <param name="asVars">the script variables</param>
+	/// <param name="asBools">the script booleans</param>
+	/// <param name="asNatives">the host functions the script calls</param>
+	explicit ts_parser(ts_image sImage, std::set<ts_variable>& asVars, std::set<ts_boolean>& asBools, const std::set<ts_native>& asNatives)
+		: psProgram(std::make_shared<const ts_program>(sImage, asVars, asBools, asNatives))
+		, cContext(psProgram)
+	{
+	}
+
+	/// <summary>evaluate script based on current variable values</summary>
+	void evaluate() { cContext.evaluate(); }
+
+	/// <summary>evaluate independent parts of the script on the workers of the thread pool, see ts_context::evaluate(ts_thread_pool&)</summary>
+	void evaluate(ts_thread_pool& cPool) { cContext.evaluate(cPool); }
+
+	/// <summary>evaluate only what depends on the changed slots, see ts_context::evaluate_changed()</summary>
+	void evaluate_changed(const std::vector<unsigned>& auVars, const std::vector<unsigned>& auBools = {}) { cContext.evaluate_changed(auVars, auBools); }
+
+	/// <summary>select the backend of evaluate(), see ts_context::set_backend()</summary>
+	int64_t set_backend(ts_backend eBackend) { return cContext.set_backend(eBackend); }
+
+	/// <summary>evaluate script for a number of rows, see ts_context::evaluate_batch()</summary>
+	int64_t evaluate_batch(const std::set<ts_variable>& asColumns, const std::set<ts_boolean>& asBoolColumns, size_t uRows,
+		ts_math eMath = ts_math::strict, ts_simd eSimd = ts_simd::automatic)
+	{
+		return cContext.evaluate_batch(asColumns, asBoolColumns, uRows, eMath, eSimd);
+	}
+
+	/// <summary>evaluate script for a number of rows on all workers of the thread pool, see ts_context::evaluate_batch()</summary>
+	int64_t evaluate_batch(const std::set<ts_variable>& asColumns, const std::set<ts_boolean>& asBoolColumns, size_t uRows,
+		ts_thread_pool& cPool, ts_math eMath = ts_math::strict, ts_simd eSimd = ts_simd::automatic)
+	{
+		return cContext.evaluate_batch(asColumns, asBoolColumns, uRows, cPool, eMath, eSimd);
+	}
+
+	/// <summary>returns error message and position</summary>
+	std::pair<int64_t, uint32_t> error() const
+	{
+		return psProgram->error();
+	}
+
+	/// <summary>the compiled script, create a ts_context of it for each further evaluating thread</summary>
+	const std::shared_ptr<const ts_program>& program() const { return psProgram; }
+
+	/// <summary>the context, to rebind the variables (see ts_context::bind(), ts_context::bind_instance())</summary>
+	ts_context& context() { return cContext; }
+
+private:
+	/// <summary>the compiled script</summary>
+	std::shared_ptr<const ts_program> psProgram;
+	/// <summary>the context bound to the variables given to the constructor</summary>
+	ts_context cContext;
+};
+
+/// <summary>builtin functions of compile time scripts (the functions of ts_builtins(), called directly)</summary>
+enum struct ts_static_function : unsigned
+{
+	fn_abs, fn_acos, fn_asin, fn_atan, fn_atan2, fn_ceil, fn_cos, fn_cosh, fn_exp,
+	fn_floor, fn_ln, fn_log10, fn_pow, fn_sin, fn_sinh, fn_sqrt, fn_tan, fn_tanh
+};
+
+/// <summary>names of the compile time script builtins, index is the ts_static_function value</summary>
+constexpr std::array<std::string_view, 18> ts_static_function_names =
+{
+	"abs", "acos", "asin", "atan", "atan2", "ceil", "cos", "cosh", "exp",
+	"floor", "ln", "log10", "pow", "sin", "sinh", "sqrt", "tan", "tanh"
+};
+
+/// <summary>
+/// expression node of a compile time parsed script
+/// (operands are node indices, operations as the interpreter instructions)
+/// </summary>
+struct ts_static_node
+{
+	/// <summary>op_mov : constant, op_load_var : variable, op_call : builtin, others : operation of uB and uC</summary>
+	ts_opcode eOp;
+	/// <summary>variable slot (op_load_var) or builtin function (op_call)</summary>
+	unsigned uA;
+	/// <summary>first operand node</summary>
+	unsigned uB;
+	/// <summary>second operand node</summary>
+	unsigned uC;
+	/// <summary>value of a constant</summary>
+	te_type fValue;
+};
+
+/// <summary>statement of a compile time parsed script</summary>
+struct ts_static_statement
+{
+	/// <summary>
+	/// op_store_var : variable slot uA = node uB, op_jump_false : if node uA, the block ends at statement uB,
+	/// op_jump : if node uA with else branch, starting at statement uB (statement uB - 1 is an op_jump, uB the branch end)
+	/// </summary>
+	ts_opcode eOp;
+	/// <summary>variable slot or condition node</summary>
+	unsigned uA;
+	/// <summary>expression node or block end statement</summary>
+	unsigned uB;
+};
+
+/// <summary>
+/// compile time parsed script, nodes and statements in fixed size storage
+/// (uN is the script length, the upper bound of tokens)
+/// </summary>
+template<size_t uN>
+struct ts_static_ast
+{
+	/// <summary>expression nodes</summary>
+	std::array<ts_static_node, uN> asNodes{};
+	/// <summary>statements in execution order</summary>
+	std::array<ts_static_statement, uN> asStatements{};
+	/// <summary>variable names, index is the slot (order of first appearance)</summary>
+	std::array<std::string_view, uN> atVarNames{};
+	/// <summary>number of nodes</summary>
+	unsigned uNodes = 0;
+	/// <summary>number of statements</summary>
+	unsigned uStatements = 0;
+	/// <summary>number of variables</summary>
+	unsigned uVars = 0;
+	/// <summary>0 if script compiled</summary>
+	int64_t nErr = TS_OK;
+	/// <summary>character index of the error</summary>
+	size_t uErrMark = 0;
+};
+
+/// <summary>
+/// constexpr parser for compile time scripts, mirrors the tokenizer and the expression grammar of ts_program
+/// (float variables only, every name that is no keyword, constant or builtin is a variable,
+/// expressions TinyScript++ evaluates by TinyExpr++ are not supported)
+/// </summary>
+template<size_t uN>
+class ts_static_parser
+{
+public:
+	/// <param name="_atCode">the script code</param>
+	constexpr explicit ts_static_parser(std::string_view _atCode) : atCode(_atCode) {}
+
+	/// <summary>parse the script</summary>
+	constexpr ts_static_ast<uN> parse()
+	{
+		next_token();
+		while ((eType != token_type::TOK_END) && (!sAst.nErr))
+			parse_statement();
+		return sAst;
+	}
+
+private:
+	/// <summary>token types used by compile time scripts</summary>
+	enum struct token_type : unsigned
+	{
+		TOK_END,
+		TOK_ERROR,
+		TOK_NUMBER,
+		TOK_VAR_FLOAT,
+		TOK_FUNCTION,
+		TOK_IF,
+		TOK_ELSE,
+		TOK_TRUE,
+		TOK_FALSE,
+		TOK_OPEN,
+		TOK_CLOSE,
+		TOK_OPEN_CURLY,
+		TOK_CLOSE_CURLY,
+		TOK_SEPARATOR,
+		TOK_ASSIGN,
+		TOK_COMPARE,
+		TOK_PLUS,
+		TOK_MINUS,
+		TOK_MUL,
+		TOK_DIV,
+		TOK_MOD,
+		TOK_POW,
+		TOK_COMMA
+	};
+
+	/// <summary>get the next token, skip spaces and comments</summary>
+	constexpr void next_token()
+	{
+		for (;;)
 		{
-			switch (sTerm.eType)
+			if (uNext >= atCode.size()) { eType = token_type::TOK_END; return; }
+			char c = atCode[uNext];
+			if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\v') || (c == '\f') || (c == '\0')) { uNext++; continue; }
+			if ((c == '/') && (peek(1) == '/'))
 			{
-			case ts_parser::ts_statement_bool_expr::term_type::floating_const:
+				while ((uNext < atCode.size()) && (atCode[uNext] != '\n')) uNext++;
+				continue;
+			}
+			if ((c == '/') && (peek(1) == '*'))
 			{
-				te_type fV = std::get<te_type>(sTerm.sValue);
-				return (fV != 0.f);
+				uNext += 2;
+				while ((uNext < atCode.size()) && !((atCode[uNext] == '*') && (peek(1) == '/'))) uNext++;
+				uNext += 2;
+				continue;
 			}
 			break;
-			case ts_parser::ts_statement_bool_expr::term_type::boolean_const:
-				return std::get<bool>(sTerm.sValue);
-			case ts_parser::ts_statement_bool_expr::term_type::operative:
-			default: break;
-			}
-			return false;
 		}
 
-		/// <summary>get boolean value from term</summary>
-		[[nodiscard]] bool get_bool(term_level& sTerm)
+		uMark = uNext;
+		char c = atCode[uNext];
+		if (is_digit(c) || (c == '.'))
+			pop_number();
+		else if (is_alpha(c))
+			pop_vocable();
+		else
+			pop_operator();
+	}
+
+	/// <summary>decimal number, as std::stof() / std::stod() would read it</summary>
+	constexpr void pop_number()
+	{
+		uint64_t uMantissa = 0;
+		int nExp = 0;
+		bool bDigits = false;
+		while (is_digit(peek(0)))
 		{
-			switch (sTerm.eType)
-			{
-			case ts_parser::ts_statement_bool_expr::term_level_type::floating:
-			{
-				unsigned uIx = std::get<unsigned>(sTerm.sValue);
-				if (uIx < pasVars->size())
-				{
-					te_type* pf = std::next(pasVars->begin(), uIx)->m_value;
-					if (pf) return ((*pf) != 0.f);
-				}
-			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_level_type::floating_const:
+			if (uMantissa < 1000000000000000000ull) uMantissa = uMantissa * 10 + (uint64_t)(peek(0) - '0'); else nExp++;
+			uNext++, bDigits = true;
+		}
+		if (peek(0) == '.')
+		{
+			uNext++;
+			while (is_digit(peek(0)))
 			{
-				te_type fV = std::get<te_type>(sTerm.sValue);
-				return (fV != 0.f);
+				if (uMantissa < 1000000000000000000ull) uMantissa = uMantissa * 10 + (uint64_t)(peek(0) - '0'), nExp--;
+				uNext++, bDigits = true;
 			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_level_type::boolean:
+		}
+		if (!bDigits) { eType = token_type::TOK_ERROR; return; }
+		if (((peek(0) == 'e') || (peek(0) == 'E')) && (is_digit(peek(1)) || (((peek(1) == '+') || (peek(1) == '-')) && is_digit(peek(2)))))
+		{
+			uNext++;
+			bool bNegative = (peek(0) == '-');
+			if ((peek(0) == '+') || (peek(0) == '-')) uNext++;
+			int nE = 0;
+			while (is_digit(peek(0))) { if (nE < 10000) nE = nE * 10 + (peek(0) - '0'); uNext++; }
+			nExp += bNegative ? -nE : nE;
+		}
+		fValue = to_floating(uMantissa, nExp);
+		eType = token_type::TOK_NUMBER;
+	}
+
+	/// <summary>
+	/// mantissa * 10 ^ exponent, correctly rounded if both are exact in te_type (or in double for float),
+	/// other literals may differ by one ulp from std::stof() / std::stod()
+	/// </summary>
+	static constexpr te_type to_floating(uint64_t uMantissa, int nExp)
+	{
+		if ((sizeof(te_type) == sizeof(float)) && (uMantissa <= (1ull << 24)) && (nExp >= -10) && (nExp <= 10))
+			return (nExp < 0) ? (te_type)uMantissa / (te_type)power_of_ten(-nExp) : (te_type)uMantissa * (te_type)power_of_ten(nExp);
+		if ((uMantissa <= (1ull << 53)) && (nExp >= -22) && (nExp <= 22))
+			return (te_type)((nExp < 0) ? (double)uMantissa / power_of_ten(-nExp) : (double)uMantissa * power_of_ten(nExp));
+		long double fR = (long double)uMantissa;
+		for (; nExp > 0; nExp--) fR *= 10.0L;
+		for (; nExp < 0; nExp++) fR /= 10.0L;
+		return (te_type)fR;
+	}
+
+	/// <summary>10 ^ n (exact up to 10 ^ 22)</summary>
+	static constexpr double power_of_ten(int n)
+	{
+		double f = 1.;
+		for (; n > 0; n--) f *= 10.;
+		return f;
+	}
+
+	/// <summary>keyword, constant, builtin or variable</summary>
+	constexpr void pop_vocable()
+	{
+		size_t uStart = uNext;
+		while (is_alpha(peek(0)) || is_digit(peek(0)) || (peek(0) == '_')) uNext++;
+		std::string_view at = atCode.substr(uStart, uNext - uStart);
+
+		if (at == "if") eType = token_type::TOK_IF;
+		else if (at == "else") eType = token_type::TOK_ELSE;
+		else if (at == "true") eType = token_type::TOK_TRUE;
+		else if (at == "false") eType = token_type::TOK_FALSE;
+		else if (at == "pi") { fValue = (te_type)3.14159265358979323846; eType = token_type::TOK_NUMBER; }
+		else if (at == "e") { fValue = (te_type)2.71828182845904523536; eType = token_type::TOK_NUMBER; }
+		else
+		{
+			for (unsigned uIx = 0; uIx < (unsigned)ts_static_function_names.size(); uIx++)
 			{
-				unsigned uIx = std::get<unsigned>(sTerm.sValue);
-				if (uIx < pasBools->size())
+				if (at == ts_static_function_names[uIx])
 				{
-					bool* pb = std::next(pasBools->begin(), uIx)->pbValue;
-					if (pb) return *pb;
+					uValue = uIx;
+					eType = token_type::TOK_FUNCTION;
+					return;
 				}
 			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_level_type::boolean_const:
-				return std::get<bool>(sTerm.sValue);
-			case ts_parser::ts_statement_bool_expr::term_level_type::operative:
-			default: break;
-			}
-			return false;
+
+			// variable slot, new variables are appended
+			uValue = sAst.uVars;
+			for (unsigned uIx = 0; uIx < sAst.uVars; uIx++)
+				if (sAst.atVarNames[uIx] == at) uValue = uIx;
+			if (uValue == sAst.uVars) sAst.atVarNames[sAst.uVars++] = at;
+			eType = token_type::TOK_VAR_FLOAT;
 		}
+	}
 
-		/// <summary>get floating value from term</summary>
-		[[nodiscard]] te_type get_float(term& sTerm)
+	/// <summary>operator or special character</summary>
+	constexpr void pop_operator()
+	{
+		char c0 = atCode[uNext++], c1 = peek(0);
+		eType = token_type::TOK_ERROR;
+		switch (c0)
 		{
-			switch (sTerm.eType)
-			{
-			case ts_parser::ts_statement_bool_expr::term_type::floating_const:
-			{
-				te_type fV = std::get<te_type>(sTerm.sValue);
-				return fV;
-			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_type::boolean_const:
-				return (std::get<bool>(sTerm.sValue)) ? 1.f : 0.f;
-			case ts_parser::ts_statement_bool_expr::term_type::operative:
-			default: break;
-			}
-			return 0.f;
+		case '(': eType = token_type::TOK_OPEN; break;
+		case ')': eType = token_type::TOK_CLOSE; break;
+		case '{': eType = token_type::TOK_OPEN_CURLY; break;
+		case '}': eType = token_type::TOK_CLOSE_CURLY; break;
+		case ';': eType = token_type::TOK_SEPARATOR; break;
+		case '+': eType = token_type::TOK_PLUS; break;
+		case '-': eType = token_type::TOK_MINUS; break;
+		case '*': eType = token_type::TOK_MUL; break;
+		case '/': eType = token_type::TOK_DIV; break;
+		case '%': eType = token_type::TOK_MOD; break;
+		case '^': eType = token_type::TOK_POW; break;
+		case ',': eType = token_type::TOK_COMMA; break;
+		case '&': if (c1 == '&') compare(ts_opcode::op_and, 1); break;
+		case '|': if (c1 == '|') compare(ts_opcode::op_or, 1); break;
+		case '!': if (c1 == '=') compare(ts_opcode::op_unequal, 1); break;
+		case '=': if (c1 == '=') compare(ts_opcode::op_equal, 1); else eType = token_type::TOK_ASSIGN; break;
+		case '>': compare((c1 == '=') ? ts_opcode::op_greater_equal : ts_opcode::op_greater, (c1 == '=') ? 1 : 0); break;
+		case '<': compare((c1 == '=') ? ts_opcode::op_less_equal : ts_opcode::op_less, (c1 == '=') ? 1 : 0); break;
+		default: break;
 		}
+	}
 
-		/// <summary>get floating value from term</summary>
-		[[nodiscard]] te_type get_float(term_level& sTerm)
+	/// <summary>set a compare token, skip the second character</summary>
+	constexpr void compare(ts_opcode eOp, unsigned uSkip)
+	{
+		eCompare = eOp;
+		eType = token_type::TOK_COMPARE;
+		uNext += uSkip;
+	}
+
+	/// <summary>statement : ";" | "{" {statement} "}" | "if" condition statement ["else" statement] | variable "=" list (";" | "}" | end)</summary>
+	constexpr void parse_statement()
+	{
+		switch (eType)
 		{
-			switch (sTerm.eType)
+		case token_type::TOK_SEPARATOR:
+			next_token();
+			return;
+		case token_type::TOK_OPEN_CURLY:
+			next_token();
+			while ((eType != token_type::TOK_CLOSE_CURLY) && (!sAst.nErr))
 			{
-			case ts_parser::ts_statement_bool_expr::term_level_type::floating:
-			{
-				unsigned uIx = std::get<unsigned>(sTerm.sValue);
-				if (uIx < pasVars->size())
-				{
-					te_type* pf = std::next(pasVars->begin(), uIx)->m_value;
-					if (pf) return *pf;
-				}
-			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_level_type::floating_const:
-			{
-				te_type fV = std::get<te_type>(sTerm.sValue);
-				return fV;
+				if (eType == token_type::TOK_END) { fail(); return; }
+				parse_statement();
 			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_level_type::boolean:
+			next_token();
+			return;
+		case token_type::TOK_IF:
+		{
+			next_token();
+			bCondition = true;
+			unsigned uCondition = parse_condition();
+			bCondition = false;
+			if (sAst.nErr) return;
+			unsigned uIf = sAst.uStatements++;
+			parse_statement();
+			if (sAst.nErr) return;
+			if (eType != token_type::TOK_ELSE)
 			{
-				unsigned uIx = std::get<unsigned>(sTerm.sValue);
-				if (uIx < pasBools->size())
-				{
-					bool* pb = std::next(pasBools->begin(), uIx)->pbValue;
-					if (pb) return (*pb) ? 1.f : 0.f;
-				}
-			}
-			break;
-			case ts_parser::ts_statement_bool_expr::term_level_type::boolean_const:
-				return (std::get<bool>(sTerm.sValue)) ? 1.f : 0.f;
-			case ts_parser::ts_statement_bool_expr::term_level_type::operative:
-			default: break;
+				sAst.asStatements[uIf] = { ts_opcode::op_jump_false, uCondition, sAst.uStatements };
+				return;
 			}
-			return 0.f;
+
+			// else branch, binds to the innermost if
+			next_token();
+			unsigned uJump = sAst.uStatements++;
+			sAst.asStatements[uIf] = { ts_opcode::op_jump, uCondition, sAst.uStatements };
+			parse_statement();
+			sAst.asStatements[uJump] = { ts_opcode::op_jump, 0, sAst.uStatements };
+			return;
+		}
+		case token_type::TOK_VAR_FLOAT:
+		{
+			unsigned uSlot = uValue;
+			next_token();
+			if (eType != token_type::TOK_ASSIGN) { fail(); return; }
+			next_token();
+			unsigned uNode = parse_list();
+			if (sAst.nErr) return;
+			if ((eType != token_type::TOK_SEPARATOR) && (eType != token_type::TOK_CLOSE_CURLY) && (eType != token_type::TOK_END)) { fail(); return; }
+			sAst.asStatements[sAst.uStatements++] = { ts_opcode::op_store_var, uSlot, uNode };
+			// the separator belongs to the statement (an "else" may follow)
+			if (eType == token_type::TOK_SEPARATOR) next_token();
+			return;
+		}
+		default:
+			// unexpected token
+			fail();
+			return;
 		}
+	}
 
-		/// <summary>compare two values</summary>
-		[[nodiscard]] bool compare(state::token_compare_type eType, std::array<std::variant<bool, te_type>, 2>& asValue)
+	/// <summary>list : sum {"," sum}</summary>
+	constexpr unsigned parse_list()
+	{
+		unsigned uNode = parse_sum();
+		while ((eType == token_type::TOK_COMMA) && (!sAst.nErr))
 		{
-			switch (eType)
+			next_token();
+			uNode = parse_sum();
+		}
+		return uNode;
+	}
+	/// <summary>sum : term {("+" | "-") term}</summary>
+	constexpr unsigned parse_sum()
+	{
+		unsigned uNode = parse_term();
+		while (((eType == token_type::TOK_PLUS) || (eType == token_type::TOK_MINUS)) && (!sAst.nErr))
+		{
+			ts_opcode eOp = (eType == token_type::TOK_PLUS) ? ts_opcode::op_add : ts_opcode::op_sub;
+			next_token();
+			uNode = node(eOp, 0, uNode, parse_term());
+		}
+		return uNode;
+	}
+	/// <summary>term : factor {("*" | "/" | "%") factor}</summary>
+	constexpr unsigned parse_term()
+	{
+		unsigned uNode = parse_factor();
+		while (((eType == token_type::TOK_MUL) || (eType == token_type::TOK_DIV) || (eType == token_type::TOK_MOD)) && (!sAst.nErr))
+		{
+			ts_opcode eOp = (eType == token_type::TOK_MUL) ? ts_opcode::op_mul : (eType == token_type::TOK_DIV) ? ts_opcode::op_div : ts_opcode::op_mod;
+			next_token();
+			uNode = node(eOp, 0, uNode, parse_factor());
+		}
+		return uNode;
+	}
+	/// <summary>factor : power {"^" power} (left to right, as TinyExpr++ by default)</summary>
+	constexpr unsigned parse_factor()
+	{
+		unsigned uNode = parse_power();
+		while ((eType == token_type::TOK_POW) && (!sAst.nErr))
+		{
+			next_token();
+			uNode = node(ts_opcode::op_pow, 0, uNode, parse_power());
+		}
+		return uNode;
+	}
+	/// <summary>power : {("-" | "+")} base</summary>
+	constexpr unsigned parse_power()
+	{
+		bool bNegate = false;
+		while ((eType == token_type::TOK_PLUS) || (eType == token_type::TOK_MINUS))
+		{
+			if (eType == token_type::TOK_MINUS) bNegate = !bNegate;
+			next_token();
+		}
+		unsigned uNode = parse_base();
+		return bNegate ? node(ts_opcode::op_neg, 0, uNode, 0) : uNode;
+	}
+	/// <summary>
+	/// base : number | variable | function-1 power | function-2 "(" sum "," sum ")" | "(" list ")"
+	/// (in conditions also "true" | "false" and "(" condition ")" instead of "(" list ")")
+	/// </summary>
+	constexpr unsigned parse_base()
+	{
+		switch (eType)
+		{
+		case token_type::TOK_NUMBER:
+		{
+			unsigned uNode = constant(fValue);
+			next_token();
+			return uNode;
+		}
+		case token_type::TOK_TRUE:
+		case token_type::TOK_FALSE:
+		{
+			if (!bCondition) return fail();
+			unsigned uNode = constant((eType == token_type::TOK_TRUE) ? (te_type)1 : (te_type)0);
+			next_token();
+			return uNode;
+		}
+		case token_type::TOK_VAR_FLOAT:
+		{
+			unsigned uNode = node(ts_opcode::op_load_var, uValue, 0, 0);
+			next_token();
+			return uNode;
+		}
+		case token_type::TOK_FUNCTION:
+		{
+			ts_static_function eF = (ts_static_function)uValue;
+			next_token();
+			if ((eF == ts_static_function::fn_atan2) || (eF == ts_static_function::fn_pow))
 			{
-			case ts_parser::state::token_compare_type::TOK_EQUAL:
-				return (std::get<te_type>(asValue[0]) == std::get<te_type>(asValue[1]));
-			case ts_parser::state::token_compare_type::TOK_UNEQUAL:
-				return (std::get<te_type>(asValue[0]) != std::get<te_type>(asValue[1]));
-			case ts_parser::state::token_compare_type::TOK_GREATER:
-				return (std::get<te_type>(asValue[0]) > std::get<te_type>(asValue[1]));
-			case ts_parser::state::token_compare_type::TOK_LESS:
-				return (std::get<te_type>(asValue[0]) < std::get<te_type>(asValue[1]));
-			case ts_parser::state::token_compare_type::TOK_GREATER_EQUAL:
-				return (std::get<te_type>(asValue[0]) >= std::get<te_type>(asValue[1]));
-			case ts_parser::state::token_compare_type::TOK_LESS_EQUAL:
-				return (std::get<te_type>(asValue[0]) <= std::get<te_type>(asValue[1]));
-			case ts_parser::state::token_compare_type::TOK_AND:
-				return ((std::get<bool>(asValue[0])) && (std::get<bool>(asValue[1])));
-			case ts_parser::state::token_compare_type::TOK_OR:
-				return ((std::get<bool>(asValue[0])) || (std::get<bool>(asValue[1])));
-			default:
-				break;
+				if (eType != token_type::TOK_OPEN) return fail();
+				next_token();
+				unsigned uLeft = parse_sum();
+				if (eType != token_type::TOK_COMMA) return fail();
+				next_token();
+				unsigned uRight = parse_sum();
+				if (eType != token_type::TOK_CLOSE) return fail();
+				next_token();
+				return node((eF == ts_static_function::fn_pow) ? ts_opcode::op_pow : ts_opcode::op_atan2, 0, uLeft, uRight);
 			}
-			return false;
+			return node(ts_opcode::op_call, (unsigned)eF, parse_power(), 0);
 		}
+		case token_type::TOK_OPEN:
+		{
+			next_token();
+			unsigned uNode = (bCondition) ? parse_condition() : parse_list();
+			if (eType != token_type::TOK_CLOSE) return fail();
+			next_token();
+			return uNode;
+		}
+		default:
+			return fail();
+		}
+	}
 
-		/// <summary>the compiled boolean expression</summary>
-		std::vector<term_level> asTermsCompiled = std::vector<term_level>();
-		/// <summary>intermediate comparisation terms</summary>
-		std::vector<std::vector<term>> aasEvaluationValues = std::vector<std::vector<term>>();
-		/// <summary>the actual statement</summary>
-		std::string atStatement;
-		/// <summary>all variables used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_variable>> pasVars;
-		/// <summary>all variables used within this script (type bool)</summary>
-		std::shared_ptr<std::set<ts_boolean>> pasBools;
-		/// <summary>destination boolean - if set uDestIx is ignored</summary>
-		std::shared_ptr<bool> pbDestBool;
-		/// <summary>the state with the embedded statement string</summary>
-		std::shared_ptr<state> psState;
-		/// <summary>destination index in pasBools</summary>
-		unsigned uDestIx = 0;
-		/// <summary>0 if statement compiled</summary>
-		int64_t nErr = TS_OK;
-	};
-
-	/// <summary>TinyScript if statement class</summary>
-	class ts_statement_if
+	/// <summary>condition : and {"||" and} (precedence as ts_program)</summary>
+	constexpr unsigned parse_condition()
 	{
-	public:
-		ts_statement_if() {}
-
-		/// <summary>operator needed to assign</summary>
-		ts_statement_if& operator=(const ts_statement_if& s)
+		unsigned uNode = parse_and();
+		while ((eType == token_type::TOK_COMPARE) && (eCompare == ts_opcode::op_or) && (!sAst.nErr))
 		{
-			this->atBoolStatement = s.atBoolStatement;
-			this->pasVars = s.pasVars;
-			this->pasBools = s.pasBools;
-			this->nErr = s.nErr;
-			this->pbDestBool = s.pbDestBool;
-			return *this;
+			next_token();
+			uNode = node(ts_opcode::op_or, 0, uNode, parse_and());
 		}
-
-		/// <param name="_atStatement">the statement string</param>
-		/// <param name="_pasVars">shared pointer to the script variables</param>
-		ts_statement_if(std::string& _atBoolStatement,
-			std::shared_ptr<std::set<ts_variable>> _pasVars,
-			std::shared_ptr<std::set<ts_boolean>> _pasBools
-		)
-			: atBoolStatement(_atBoolStatement)
-			, pasBools(_pasBools)
-			, pasVars(_pasVars)
-			, pbDestBool(std::make_shared<bool>(false))
+		return uNode;
+	}
+	/// <summary>and : equality {"&&" equality}</summary>
+	constexpr unsigned parse_and()
+	{
+		unsigned uNode = parse_equality();
+		while ((eType == token_type::TOK_COMPARE) && (eCompare == ts_opcode::op_and) && (!sAst.nErr))
 		{
-			cBoolExpr = ts_statement_bool_expr(_atBoolStatement, _pasVars, _pasBools, pbDestBool, 0);
+			next_token();
+			uNode = node(ts_opcode::op_and, 0, uNode, parse_equality());
 		}
-		/// <summary></summary>
-		int64_t error() { return nErr; }
-		/// <summary>evaluate compiled statement</summary>
-		void evaluate()
+		return uNode;
+	}
+	/// <summary>equality : relation {("==" | "!=") relation}</summary>
+	constexpr unsigned parse_equality()
+	{
+		unsigned uNode = parse_relation();
+		while ((eType == token_type::TOK_COMPARE) && ((eCompare == ts_opcode::op_equal) || (eCompare == ts_opcode::op_unequal)) && (!sAst.nErr))
 		{
-			cBoolExpr.evaluate();
+			ts_opcode eOp = eCompare;
+			next_token();
+			uNode = node(eOp, 0, uNode, parse_relation());
 		}
-		/// <summary>return value of the boolean expression</summary>
-		bool value()
+		return uNode;
+	}
+	/// <summary>relation : sum {("<" | ">" | "<=" | ">=") sum}</summary>
+	constexpr unsigned parse_relation()
+	{
+		unsigned uNode = parse_sum();
+		while ((eType == token_type::TOK_COMPARE) && (eCompare != ts_opcode::op_or) && (eCompare != ts_opcode::op_and) &&
+			(eCompare != ts_opcode::op_equal) && (eCompare != ts_opcode::op_unequal) && (!sAst.nErr))
 		{
-			return *(pbDestBool.get());
+			ts_opcode eOp = eCompare;
+			next_token();
+			uNode = node(eOp, 0, uNode, parse_sum());
 		}
+		return uNode;
+	}
 
-	private:
-		/// <summary>the boolean statement</summary>
-		std::string atBoolStatement;
-		/// <summary>all variables used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_variable>> pasVars;
-		/// <summary>all variables used within this script (type bool)</summary>
-		std::shared_ptr<std::set<ts_boolean>> pasBools;
-		/// <summary>0 if statement compiled</summary>
-		int64_t nErr = TS_OK;
-		/// <summary>destination boolean pointer</summary>
-		std::shared_ptr<bool> pbDestBool;
-		/// <summary>embedded boolean expression</summary>
-		ts_statement_bool_expr cBoolExpr;
-	};
-
-	/// <summary>a single code line within the script</summary>
-	class ts_statement
+	/// <summary>add a node, returns its index</summary>
+	constexpr unsigned node(ts_opcode eOp, unsigned uA, unsigned uB, unsigned uC)
 	{
-	public:
-		/// <param name="_atStatement">the statement string</param>
-		/// <param name="_pasVars">shared pointer to the script variables</param>
-		/// <param name="_pasBools">shared pointer to the script booleans</param>
-		explicit ts_statement(std::string& _atStatement,
-			std::shared_ptr<std::set<ts_variable>> _pasVars,
-			std::shared_ptr<std::set<ts_boolean>> _pasBools,
-			unsigned _uBlockLevel
-		) : uBlockLevel(_uBlockLevel)
+		if (sAst.nErr) return 0;
+		if (sAst.uNodes >= uN) return fail();
+		sAst.asNodes[sAst.uNodes] = { eOp, uA, uB, uC, (te_type)0 };
+		return sAst.uNodes++;
+	}
+	/// <summary>add a constant node</summary>
+	constexpr unsigned constant(te_type f)
+	{
+		unsigned uNode = node(ts_opcode::op_mov, 0, 0, 0);
+		sAst.asNodes[uNode].fValue = f;
+		return uNode;
+	}
+	/// <summary>set the error at the current token</summary>
+	constexpr unsigned fail()
+	{
+		if (!sAst.nErr)
 		{
-			// create state class
-			psState = std::make_unique<state>(state(_atStatement, _pasVars, _pasBools));
-
-			// get first token, create statement class
-			psState->next_token();
-			switch (psState->get_type())
-			{
-			case ts_parser::state::token_type::TOK_NULL:
-			case ts_parser::state::token_type::TOK_ERROR:
-			case ts_parser::state::token_type::TOK_END:
-			case ts_parser::state::token_type::TOK_OPEN:
-			case ts_parser::state::token_type::TOK_CLOSE:
-			case ts_parser::state::token_type::TOK_OPEN_CURLY:
-			case ts_parser::state::token_type::TOK_CLOSE_CURLY:
-			case ts_parser::state::token_type::TOK_NUMBER:
-			case ts_parser::state::token_type::TOK_ASSIGN:
-			case ts_parser::state::token_type::TOK_EQUAL:
-			case ts_parser::state::token_type::TOK_UNEQUAL:
-			case ts_parser::state::token_type::TOK_GREATER:
-			case ts_parser::state::token_type::TOK_LESS:
-			case ts_parser::state::token_type::TOK_GREATER_EQUAL:
-			case ts_parser::state::token_type::TOK_LESS_EQUAL:
-				nErr = TS_FAIL;
-				return;
-			case ts_parser::state::token_type::TOK_IF:
-			{
-				// create if (in case boolean) statement
-				std::string atS = psState->remaining();
-				cStatement = ts_statement_if(atS, _pasVars, _pasBools);
-				auto nE = std::get<ts_statement_if>(cStatement).error();
-				if (nE == TS_OK)
-					eType = ts_types::sm_if;
-				else
-					nErr = nE;
-			}
-			break;
-			case ts_parser::state::token_type::TOK_ELSE:
-				// TODO !! ELSE !!
-				break;
-			case ts_parser::state::token_type::TOK_VAR_FLOAT:
-			{
-				// get the variable index
-				unsigned uIx = psState->value_unsigned();
+			sAst.nErr = TS_FAIL;
+			sAst.uErrMark = uMark;
+		}
+		eType = token_type::TOK_END;
+		return 0;
+	}
 
-				// return error if wrong index
-				if (uIx >= _pasVars->size())
-				{
-					nErr = TS_FAIL;
-					return;
-				}
+	/// <summary>character at this offset from the current index</summary>
+	constexpr char peek(size_t uOffset) const { return ((uNext + uOffset) < atCode.size()) ? atCode[uNext + uOffset] : '\0'; }
+	/// <summary>constexpr isdigit()</summary>
+	static constexpr bool is_digit(char c) { return (c >= '0') && (c <= '9'); }
+	/// <summary>constexpr isalpha()</summary>
+	static constexpr bool is_alpha(char c) { return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')); }
 
-				// next token must be TOK_ASSIGN
-				psState->next_token();
-				if (psState->get_type() != ts_parser::state::token_type::TOK_ASSIGN)
-				{
-					nErr = TS_FAIL;
-					return;
-				}
+	/// <summary>the script code</summary>
+	std::string_view atCode;
+	/// <summary>the parsed script</summary>
+	ts_static_ast<uN> sAst{};
+	/// <summary>current character index</summary>
+	size_t uNext = 0;
+	/// <summary>character index of the current token</summary>
+	size_t uMark = 0;
+	/// <summary>current token type</summary>
+	token_type eType = token_type::TOK_END;
+	/// <summary>compare operation of a compare token</summary>
+	ts_opcode eCompare = ts_opcode::op_equal;
+	/// <summary>variable slot or builtin of the current token</summary>
+	unsigned uValue = 0;
+	/// <summary>parsing an if condition</summary>
+	bool bCondition = false;
+	/// <summary>value of a number token</summary>
+	te_type fValue = (te_type)0;
+};
 
-				// create TinyExpr statement
-				std::string atS = psState->remaining();
-				cStatement = ts_statement_float_expr(atS, _pasVars, uIx);
-				auto nE = std::get<ts_statement_float_expr>(cStatement).error();
-				if (nE == TS_OK)
-					eType = ts_types::sm_expr_float;
-				else
-					nErr = nE;
-			}
-			break;
-			case ts_parser::state::token_type::TOK_VAR_BOOL:
-			{
-				// get the variable index
-				unsigned uIx = psState->value_unsigned();
+/// <summary>
+/// expression node of a compile time script as type, evaluated inline
+/// </summary>
+/// <typeparam name="P">the script (ts_static_script)</typeparam>
+/// <typeparam name="uNode">the node index</typeparam>
+template<class P, unsigned uNode>
+struct ts_static_expr
+{
+	/// <summary>the node</summary>
+	static constexpr ts_static_node sNode = P::sAst.asNodes[uNode];
+	/// <summary>first operand</summary>
+	using left = ts_static_expr<P, sNode.uB>;
+	/// <summary>second operand</summary>
+	using right = ts_static_expr<P, sNode.uC>;
 
-				// return error if wrong index
-				if (uIx >= _pasBools->size())
-				{
-					nErr = TS_FAIL;
-					return;
-				}
+	/// <summary>evaluate the node (compare operations return 1 or 0, as the interpreter does)</summary>
+	TS_INLINE static te_type eval(te_type* const* apfVars)
+	{
+		constexpr ts_opcode eOp = sNode.eOp;
+		if constexpr (eOp == ts_opcode::op_mov) return sNode.fValue;
+		else if constexpr (eOp == ts_opcode::op_load_var) return *apfVars[sNode.uA];
+		else if constexpr (eOp == ts_opcode::op_neg) return -left::eval(apfVars);
+		else if constexpr (eOp == ts_opcode::op_add) return left::eval(apfVars) + right::eval(apfVars);
+		else if constexpr (eOp == ts_opcode::op_sub) return left::eval(apfVars) - right::eval(apfVars);
+		else if constexpr (eOp == ts_opcode::op_mul) return left::eval(apfVars) * right::eval(apfVars);
+		else if constexpr (eOp == ts_opcode::op_div) return left::eval(apfVars) / right::eval(apfVars);
+		else if constexpr (eOp == ts_opcode::op_mod) return std::fmod(left::eval(apfVars), right::eval(apfVars));
+		else if constexpr (eOp == ts_opcode::op_pow) return std::pow(left::eval(apfVars), right::eval(apfVars));
+		else if constexpr (eOp == ts_opcode::op_atan2) return std::atan2(left::eval(apfVars), right::eval(apfVars));
+		else if constexpr (eOp == ts_opcode::op_call) return call(left::eval(apfVars));
+		else if constexpr (eOp == ts_opcode::op_equal) return (left::eval(apfVars) == right::eval(apfVars)) ? (te_type)1 : (te_type)0;
+		else if constexpr (eOp == ts_opcode::op_unequal) return (left::eval(apfVars) != right::eval(apfVars)) ? (te_type)1 : (te_type)0;
+		else if constexpr (eOp == ts_opcode::op_greater) return (left::eval(apfVars) > right::eval(apfVars)) ? (te_type)1 : (te_type)0;
+		else if constexpr (eOp == ts_opcode::op_less) return (left::eval(apfVars) < right::eval(apfVars)) ? (te_type)1 : (te_type)0;
+		else if constexpr (eOp == ts_opcode::op_greater_equal) return (left::eval(apfVars) >= right::eval(apfVars)) ? (te_type)1 : (te_type)0;
+		else if constexpr (eOp == ts_opcode::op_less_equal) return (left::eval(apfVars) <= right::eval(apfVars)) ? (te_type)1 : (te_type)0;
+		else if constexpr (eOp == ts_opcode::op_and) return ((left::eval(apfVars) != (te_type)0) && (right::eval(apfVars) != (te_type)0)) ? (te_type)1 : (te_type)0;
+		else return ((left::eval(apfVars) != (te_type)0) || (right::eval(apfVars) != (te_type)0)) ? (te_type)1 : (te_type)0;
+	}
 
-				// next token must be TOK_ASSIGN
-				psState->next_token();
-				if (psState->get_type() != ts_parser::state::token_type::TOK_ASSIGN)
-				{
-					nErr = TS_FAIL;
-					return;
-				}
+private:
+	/// <summary>call the builtin, same functions as ts_builtins()</summary>
+	TS_INLINE static te_type call(te_type f)
+	{
+		constexpr ts_static_function eF = (ts_static_function)sNode.uA;
+		if constexpr (eF == ts_static_function::fn_abs) return std::fabs(f);
+		else if constexpr (eF == ts_static_function::fn_acos) return std::acos(f);
+		else if constexpr (eF == ts_static_function::fn_asin) return std::asin(f);
+		else if constexpr (eF == ts_static_function::fn_atan) return std::atan(f);
+		else if constexpr (eF == ts_static_function::fn_ceil) return std::ceil(f);
+		else if constexpr (eF == ts_static_function::fn_cos) return std::cos(f);
+		else if constexpr (eF == ts_static_function::fn_cosh) return std::cosh(f);
+		else if constexpr (eF == ts_static_function::fn_exp) return std::exp(f);
+		else if constexpr (eF == ts_static_function::fn_floor) return std::floor(f);
+		else if constexpr (eF == ts_static_function::fn_ln) return std::log(f);
+		else if constexpr (eF == ts_static_function::fn_log10) return std::log10(f);
+		else if constexpr (eF == ts_static_function::fn_sin) return std::sin(f);
+		else if constexpr (eF == ts_static_function::fn_sinh) return std::sinh(f);
+		else if constexpr (eF == ts_static_function::fn_sqrt) return std::sqrt(f);
+		else if constexpr (eF == ts_static_function::fn_tan) return std::tan(f);
+		else return std::tanh(f);
+	}
+};
 
-				// create boolean statement
-				std::string atS = psState->remaining();
-				cStatement = ts_statement_bool_expr(atS, _pasVars, _pasBools, nullptr, uIx);
-				auto nE = std::get<ts_statement_bool_expr>(cStatement).error();
-				if (nE == TS_OK)
-					eType = ts_types::sm_expr_bool;
-				else
-					nErr = nE;
+/// <summary>
+/// statements uBegin .. uEnd of a compile time script as type, executed inline
+/// </summary>
+/// <typeparam name="P">the script (ts_static_script)</typeparam>
+template<class P, unsigned uBegin, unsigned uEnd>
+struct ts_static_block
+{
+	/// <summary>execute the statements</summary>
+	TS_INLINE static void run(te_type* const* apfVars)
+	{
+		if constexpr (uBegin < uEnd)
+		{
+			constexpr ts_static_statement s = P::sAst.asStatements[uBegin];
+			if constexpr (s.eOp == ts_opcode::op_store_var)
+			{
+				*apfVars[s.uA] = ts_static_expr<P, s.uB>::eval(apfVars);
+				ts_static_block<P, uBegin + 1, uEnd>::run(apfVars);
 			}
-			break;
-			default:
-				break;
+			else if constexpr (s.eOp == ts_opcode::op_jump_false)
+			{
+				if (ts_static_expr<P, s.uA>::eval(apfVars) != (te_type)0)
+					ts_static_block<P, uBegin + 1, s.uB>::run(apfVars);
+				ts_static_block<P, s.uB, uEnd>::run(apfVars);
+			}
+			else
+			{
+				// the block up to the jump over the else branch
+				constexpr unsigned uAfter = P::sAst.asStatements[s.uB - 1].uB;
+				if (ts_static_expr<P, s.uA>::eval(apfVars) != (te_type)0)
+					ts_static_block<P, uBegin + 1, s.uB - 1>::run(apfVars);
+				else
+					ts_static_block<P, s.uB, uAfter>::run(apfVars);
+				ts_static_block<P, uAfter, uEnd>::run(apfVars);
 			}
 		}
-		/// <summary>evaluate statement based on type</summary>
-		void evaluate()
-		{
-			if (eType == ts_types::sm_expr_float)
-				std::get<ts_statement_float_expr>(cStatement).evaluate();
-			else if (eType == ts_types::sm_expr_bool)
-				std::get<ts_statement_bool_expr>(cStatement).evaluate();
-			else if (eType == ts_types::sm_if)
-				std::get<ts_statement_if>(cStatement).evaluate();
-		}
-		/// <summary></summary>
-		ts_types type() { return eType; }
-		/// <summary></summary>
-		int64_t error() { return nErr; }
-		/// <summary></summary>
-		unsigned level() { return uBlockLevel; }
-		/// <summary>return value for if statements</summary>
-		bool boolean() { return (eType == ts_types::sm_if) ? std::get<ts_statement_if>(cStatement).value() : false; }
+	}
+};
 
-	private:
-		/// <summary>type of the statement</summary>
-		ts_types eType = ts_types::sm_undefined;
-		/// <summary>the actual statement</summary>
-		std::variant<ts_statement_bool_expr, ts_statement_float_expr, ts_statement_if> cStatement;
-		/// <summary>the state with the embedded statement string</summary>
-		std::unique_ptr<state> psState;
-		/// <summary>all variables used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_variable>> pasVars;
-		/// <summary>all booleans used within this script (type te_type : float or double)</summary>
-		std::shared_ptr<std::set<ts_boolean>> pasBools;
-		/// <summary>the block level of this statement</summary>
-		unsigned uBlockLevel;
-		/// <summary>0 if statement compiled</summary>
-		int64_t nErr = TS_OK;
-	};
+/// <summary>
+/// script parsed at compile time, the expression tree is encoded in types and evaluated inline
+/// (no startup parsing, the compiler optimizes the script as hand written code)
+/// the source is a type providing the code : struct S { static constexpr std::string_view code() { return "..."; } };
+/// variable slots are numbered in order of first appearance, see slot()
+/// </summary>
+/// <typeparam name="S">the source type</typeparam>
+template<class S>
+class ts_static_script
+{
+public:
+	/// <summary>the parsed script</summary>
+	static constexpr auto sAst = ts_static_parser<S::code().size() + 1>(S::code()).parse();
+	static_assert(sAst.nErr == TS_OK, "TinyScript++ compile time script does not compile (see sAst.uErrMark)");
 
-	/// <summary>block level helper</summary>
-	unsigned block_level_up() { if (++uBlockLevel >= (unsigned)aeFlags.size()) aeFlags.resize(uBlockLevel + 1); return uBlockLevel; }
-	/// <summary>block level helper</summary>
-	unsigned block_level_down() { return --uBlockLevel; }
+	/// <summary>number of variable slots</summary>
+	static constexpr unsigned uVars = sAst.uVars;
 
-	/// <summary>the unmodified script</summary>
-	std::string atScript;
-	/// <summary>the compiled script statements</summary>
-	std::vector<std::shared_ptr<ts_statement>> apsStatements_compiled;
-	/// <summary>flags for each block level used during evaluation process	</summary>
-	std::vector<ts_runtime_flags> aeFlags;
-	/// <summary>all variables used within this script (type te_type : float or double)</summary>
-	std::shared_ptr<std::set<ts_variable>> pasVars;
-	/// <summary>all booleans used within this script (type te_type : float or double)</summary>
-	std::shared_ptr<std::set<ts_boolean>> pasBools;
-	/// <summary>the code block level in opened braces</summary>
-	unsigned uBlockLevel = 0;
-	/// <summary>0 if script compiled</summary>
-	int64_t nErr = TS_OK;
-	/// <summary>y position of the error</summary>
-	uint32_t uErrLine = 0;
-	/// <summary>X position of the error</summary>
-	uint32_t uErrMark = 0;
+	/// <summary>slot of a variable, -1 if the script does not use it</summary>
+	static constexpr int slot(std::string_view atName)
+	{
+		for (unsigned uIx = 0; uIx < sAst.uVars; uIx++)
+			if (sAst.atVarNames[uIx] == atName) return (int)uIx;
+		return -1;
+	}
+
+	/// <summary>evaluate the script</summary>
+	/// <param name="apfVars">variable addresses by slot (uVars addresses)</param>
+	TS_INLINE static void evaluate(te_type* const* apfVars)
+	{
+		ts_static_block<ts_static_script, 0, sAst.uStatements>::run(apfVars);
+	}
+	/// <summary>evaluate the script, see evaluate()</summary>
+	TS_INLINE void operator()(te_type* const* apfVars) const { evaluate(apfVars); }
 };
 
 #endif /// __TINYSCRIPT_PLUS_PLUS_H__